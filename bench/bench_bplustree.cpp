@@ -0,0 +1,460 @@
+// Microbenchmarks for BPlusTree on Google Benchmark.
+//
+//   bench_bplustree [--max_keys=N] [--min_keys=N] [--perf_counters=0|1] [benchmark flags]
+//
+// Tree sizes run from --min_keys (default 10K) to --max_keys (default 1M) in steps of 10x;
+// pass --max_keys=100000000 for the full 10K..100M sweep. Every benchmark is repeated three times
+// after a warmup and reported as mean/median/stddev/cv; any --benchmark_* flag overrides the
+// defaults, e.g. --benchmark_repetitions=10 or
+// --benchmark_out=result.json --benchmark_out_format=json for machine-readable output.
+// The Latch/* benchmarks time one uncontended lock/unlock pair of the page latch and of
+// std::shared_mutex.
+//
+// Hardware counters (cycles, instructions, IPC, L1d/LLC/branch/dTLB misses, page faults) are
+// read around the timed region of every benchmark and reported per operation as extra columns.
+// Counters the machine does not expose are listed once at startup and left out;
+// --perf_counters=0 turns them off.
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <random>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+#include "b_plus_tree.h"
+#include "b_plus_tree_latch.h"
+#include "config.h"
+#include "perf_counters.h"
+
+namespace mybplus {
+namespace bench {
+
+using Tree = BPlusTree<KeyType, ValueType, KeyComparator>;
+
+constexpr size_t kProbeCount = 1 << 20;  // 预先生成的随机键个数，计时循环里不调用随机数
+constexpr int kScanLength = 100;
+constexpr size_t kRunLength = 16;  // 局部性查找中每一段相邻键的个数
+constexpr size_t kHotKeys = 1000;  // 热点查找的键个数
+constexpr size_t kMixedPending = 64;  // 混合负载中插入后再删除的键数
+
+bool perf_counters_enabled = true;
+
+/**
+ * Timed region of one benchmark run: hardware counters run exactly while the benchmark timer
+ * does, so setup done under PauseTiming is excluded from both. Finish reports each counter
+ * divided by the number of operations.
+ */
+class PerfRegion {
+ public:
+  explicit PerfRegion(benchmark::State &state) : state_(state) {
+    if (perf_counters_enabled) {
+      counters_.Start();
+    }
+  }
+
+  auto Pause() -> void {
+    state_.PauseTiming();
+    if (perf_counters_enabled) {
+      counters_.Stop();
+    }
+  }
+  auto Resume() -> void {
+    if (perf_counters_enabled) {
+      counters_.Start();
+    }
+    state_.ResumeTiming();
+  }
+  auto Finish(int64_t operations) -> void {
+    if (!perf_counters_enabled || operations == 0) {
+      return;
+    }
+    counters_.Stop();
+    double cycles = 0;
+    double instructions = 0;
+    for (const auto &[name, value] : counters_.Values()) {
+      state_.counters[name] = benchmark::Counter(value / operations);
+      cycles = name == "cycles" ? value : cycles;
+      instructions = name == "instructions" ? value : instructions;
+    }
+    if (cycles > 0 && instructions > 0) {
+      state_.counters["IPC"] = benchmark::Counter(instructions / cycles);
+    }
+  }
+
+ private:
+  benchmark::State &state_;
+  PerfCounters counters_;
+};
+
+auto MakeValue(KeyType key) -> ValueType {
+  ValueType value{};
+  std::memcpy(value.data(), &key, sizeof(key));
+  return value;
+}
+
+// 树中的键为 0, 2, 4, ...，奇数键留给插入
+auto BuildTree(Tree *tree, int64_t n) -> void {
+  tree->BeginBulkLoad(n);
+  for (int64_t i = 0; i < n; i++) {
+    tree->BulkLoadAppend(i * 2, MakeValue(i * 2));
+  }
+  tree->FinishBulkLoad();
+}
+
+// 只读基准共用的树；同一大小的基准连续注册，所以只缓存最近一棵
+auto SharedTree(int64_t n) -> Tree * {
+  static std::unique_ptr<Tree> tree;
+  static int64_t size = -1;
+  if (size != n) {
+    tree.reset();
+    tree = std::make_unique<Tree>("bench_tree", KeyComparator());
+    BuildTree(tree.get(), n);
+    size = n;
+  }
+  return tree.get();
+}
+
+// 均匀分布在 [0, n) 的下标
+auto RandomIndexes(int64_t n, size_t count, uint32_t seed) -> std::vector<int64_t> {
+  std::mt19937_64 rng(seed);
+  std::uniform_int_distribution<int64_t> dist(0, n - 1);
+  std::vector<int64_t> indexes(count);
+  for (auto &index : indexes) {
+    index = dist(rng);
+  }
+  return indexes;
+}
+
+auto ShuffledKeys(int64_t n, uint32_t seed) -> std::vector<KeyType> {
+  std::vector<KeyType> keys(n);
+  for (int64_t i = 0; i < n; i++) {
+    keys[i] = i * 2;
+  }
+  std::shuffle(keys.begin(), keys.end(), std::mt19937_64(seed));
+  return keys;
+}
+
+auto BM_PointLookup(benchmark::State &state) -> void {
+  int64_t n = state.range(0);
+  Tree *tree = SharedTree(n);
+  std::vector<int64_t> probes = RandomIndexes(n, kProbeCount, 1);
+  ValueType value;
+  size_t i = 0;
+  PerfRegion perf(state);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(tree->GetValue(probes[i++ & (kProbeCount - 1)] * 2, &value));
+  }
+  perf.Finish(state.iterations());
+  state.SetItemsProcessed(state.iterations());
+}
+
+// 子页面引用换回页面 id，每层下降都要查页表，与 PointLookup 对比 swizzle 的收益
+auto BM_PointLookupUnswizzled(benchmark::State &state) -> void {
+  int64_t n = state.range(0);
+  Tree *tree = SharedTree(n);
+  tree->UnswizzleChildren();
+  std::vector<int64_t> probes = RandomIndexes(n, kProbeCount, 1);
+  ValueType value;
+  size_t i = 0;
+  PerfRegion perf(state);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(tree->GetValue(probes[i++ & (kProbeCount - 1)] * 2, &value));
+  }
+  perf.Finish(state.iterations());
+  state.SetItemsProcessed(state.iterations());
+  tree->SwizzleChildren();
+}
+
+// Clustered 为 true 时连续查找 kRunLength 个相邻的键后再跳到随机位置；Finger 打开 finger 缓存，
+// 随机查找下衡量 finger 落空的开销
+template <bool Clustered, bool Finger>
+auto BM_PointLookupLocality(benchmark::State &state) -> void {
+  int64_t n = state.range(0);
+  Tree *tree = SharedTree(n);
+  tree->EnableFingerCache(Finger);
+  std::vector<int64_t> probes = RandomIndexes(n, kProbeCount, 1);
+  if (Clustered) {
+    for (size_t i = 0; i < kProbeCount; i++) {
+      probes[i] = std::min(probes[i - i % kRunLength] + static_cast<int64_t>(i % kRunLength),
+                           n - 1);
+    }
+  }
+  ValueType value;
+  size_t i = 0;
+  PerfRegion perf(state);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(tree->GetValue(probes[i++ & (kProbeCount - 1)] * 2, &value));
+  }
+  perf.Finish(state.iterations());
+  state.SetItemsProcessed(state.iterations());
+  tree->EnableFingerCache(false);
+}
+
+// 查找只落在 kHotKeys 个随机键上；HashIndex 打开自适应哈希索引
+template <bool HashIndex>
+auto BM_PointLookupHot(benchmark::State &state) -> void {
+  int64_t n = state.range(0);
+  Tree *tree = SharedTree(n);
+  tree->EnableHashIndex(HashIndex ? 4 * kHotKeys : 0);
+  std::vector<int64_t> hot = RandomIndexes(n, kHotKeys, 4);
+  std::vector<int64_t> probes = RandomIndexes(kHotKeys, kProbeCount, 5);
+  for (auto &probe : probes) {
+    probe = hot[probe];
+  }
+  ValueType value;
+  size_t i = 0;
+  PerfRegion perf(state);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(tree->GetValue(probes[i++ & (kProbeCount - 1)] * 2, &value));
+  }
+  perf.Finish(state.iterations());
+  state.SetItemsProcessed(state.iterations());
+  if (HashIndex) {
+    state.counters["hit_rate"] = tree->GetHashIndexStats().HitRate();
+  }
+  tree->EnableHashIndex(0);
+}
+
+auto BM_Scan(benchmark::State &state) -> void {
+  int64_t n = state.range(0);
+  Tree *tree = SharedTree(n);
+  std::vector<int64_t> probes = RandomIndexes(n, kProbeCount, 2);
+  std::vector<std::pair<KeyType, ValueType>> entries;
+  entries.reserve(kScanLength);
+  size_t i = 0;
+  int64_t scanned = 0;
+  PerfRegion perf(state);
+  for (auto _ : state) {
+    entries.clear();
+    scanned += tree->Scan(probes[i++ & (kProbeCount - 1)] * 2, kScanLength, &entries);
+    benchmark::DoNotOptimize(entries.data());
+  }
+  // 按扫描的元素计，而不是按扫描次数
+  perf.Finish(scanned);
+  state.SetItemsProcessed(scanned);
+}
+
+// 每次迭代从空树插入 n 个键
+auto InsertAll(benchmark::State &state, const std::vector<KeyType> &keys) -> void {
+  PerfRegion perf(state);
+  for (auto _ : state) {
+    auto tree = std::make_unique<Tree>("bench_tree", KeyComparator());
+    for (auto key : keys) {
+      tree->Insert(key, MakeValue(key));
+    }
+    perf.Pause();
+    tree.reset();
+    perf.Resume();
+  }
+  perf.Finish(state.iterations() * keys.size());
+  state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+auto BM_InsertSequential(benchmark::State &state) -> void {
+  std::vector<KeyType> keys(state.range(0));
+  for (size_t i = 0; i < keys.size(); i++) {
+    keys[i] = static_cast<KeyType>(i) * 2;
+  }
+  InsertAll(state, keys);
+}
+
+auto BM_InsertRandom(benchmark::State &state) -> void {
+  InsertAll(state, ShuffledKeys(state.range(0), 3));
+}
+
+// 每次迭代在批量构建的 n 个键的树上按随机顺序删除全部键
+auto BM_Remove(benchmark::State &state) -> void {
+  int64_t n = state.range(0);
+  std::vector<KeyType> keys = ShuffledKeys(n, 4);
+  PerfRegion perf(state);
+  for (auto _ : state) {
+    perf.Pause();
+    auto tree = std::make_unique<Tree>("bench_tree", KeyComparator());
+    BuildTree(tree.get(), n);
+    perf.Resume();
+    for (auto key : keys) {
+      tree->Remove(key);
+    }
+    perf.Pause();
+    tree.reset();
+    perf.Resume();
+  }
+  perf.Finish(state.iterations() * n);
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+/**
+ * Reads of existing keys interleaved with writes at range(1) percent reads. Writes alternate
+ * between inserting a fresh odd key and removing the one inserted kMixedPending writes earlier,
+ * so the tree stays at its starting size.
+ */
+auto BM_Mixed(benchmark::State &state) -> void {
+  int64_t n = state.range(0);
+  int64_t read_percent = state.range(1);
+  Tree *tree = SharedTree(n);
+  std::vector<int64_t> probes = RandomIndexes(n, kProbeCount, 5);
+  std::vector<int64_t> ops = RandomIndexes(100, kProbeCount, 6);
+  std::deque<KeyType> pending;
+  ValueType result;
+  size_t i = 0;
+  bool insert_next = true;
+  PerfRegion perf(state);
+  for (auto _ : state) {
+    size_t slot = i++ & (kProbeCount - 1);
+    KeyType key = probes[slot] * 2;
+    if (ops[slot] < read_percent) {
+      benchmark::DoNotOptimize(tree->GetValue(key, &result));
+    } else if (insert_next || pending.empty()) {
+      tree->Insert(key + 1, MakeValue(key + 1));
+      pending.push_back(key + 1);
+      insert_next = pending.size() < kMixedPending;
+    } else {
+      tree->Remove(pending.front());
+      pending.pop_front();
+      insert_next = true;
+    }
+  }
+  perf.Finish(state.iterations());
+  for (auto key : pending) {
+    tree->Remove(key);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// 读取并删除 --name=value 形式的参数
+auto TakeFlag(int *argc, char **argv, const std::string &name, int64_t *value) -> void {
+  std::string prefix = "--" + name + "=";
+  for (int i = 1; i < *argc; i++) {
+    if (std::strncmp(argv[i], prefix.c_str(), prefix.size()) == 0) {
+      *value = std::strtoll(argv[i] + prefix.size(), nullptr, 10);
+      std::copy(argv + i + 1, argv + *argc, argv + i);
+      (*argc)--;
+      i--;
+    }
+  }
+}
+
+// 未竞争时加锁再解锁一次的开销，对比页面锁与 std::shared_mutex
+struct SharedMutexLatch {
+  auto Lock() -> void { mutex_.lock(); }
+  auto Unlock() -> void { mutex_.unlock(); }
+  auto LockShared() -> void { mutex_.lock_shared(); }
+  auto UnlockShared() -> void { mutex_.unlock_shared(); }
+  std::shared_mutex mutex_;
+};
+
+struct PageLatch {
+  auto Lock() -> void { latch_.LockExclusive(); }
+  auto Unlock() -> void { latch_.UnlockExclusive(); }
+  auto LockShared() -> void { latch_.LockShared(); }
+  auto UnlockShared() -> void { latch_.UnlockShared(); }
+  HybridLatch latch_;
+};
+
+template <typename Latch, bool Exclusive>
+auto BM_Latch(benchmark::State &state) -> void {
+  Latch latch;
+  PerfRegion perf(state);
+  for (auto _ : state) {
+    if constexpr (Exclusive) {
+      latch.Lock();
+      latch.Unlock();
+    } else {
+      latch.LockShared();
+      latch.UnlockShared();
+    }
+    benchmark::ClobberMemory();
+  }
+  perf.Finish(state.iterations());
+  state.SetItemsProcessed(state.iterations());
+}
+
+auto RegisterBenchmarks(int64_t min_keys, int64_t max_keys) -> void {
+  benchmark::RegisterBenchmark("Latch/shared_mutex/exclusive", BM_Latch<SharedMutexLatch, true>);
+  benchmark::RegisterBenchmark("Latch/shared_mutex/shared", BM_Latch<SharedMutexLatch, false>);
+  benchmark::RegisterBenchmark("Latch/hybrid/exclusive", BM_Latch<PageLatch, true>);
+  benchmark::RegisterBenchmark("Latch/hybrid/shared", BM_Latch<PageLatch, false>);
+  // 按大小分组注册，使共享的树在同一大小的基准之间复用
+  for (int64_t n = min_keys; n <= max_keys; n *= 10) {
+    benchmark::RegisterBenchmark("PointLookup", BM_PointLookup)->Arg(n)->ArgName("keys");
+    benchmark::RegisterBenchmark("PointLookup/unswizzled", BM_PointLookupUnswizzled)
+        ->Arg(n)
+        ->ArgName("keys");
+    benchmark::RegisterBenchmark("PointLookup/finger", BM_PointLookupLocality<false, true>)
+        ->Arg(n)
+        ->ArgName("keys");
+    benchmark::RegisterBenchmark("PointLookup/clustered", BM_PointLookupLocality<true, false>)
+        ->Arg(n)
+        ->ArgName("keys");
+    benchmark::RegisterBenchmark("PointLookup/clustered/finger",
+                                 BM_PointLookupLocality<true, true>)
+        ->Arg(n)
+        ->ArgName("keys");
+    benchmark::RegisterBenchmark("PointLookup/hot", BM_PointLookupHot<false>)
+        ->Arg(n)
+        ->ArgName("keys");
+    benchmark::RegisterBenchmark("PointLookup/hot/hash_index", BM_PointLookupHot<true>)
+        ->Arg(n)
+        ->ArgName("keys");
+    benchmark::RegisterBenchmark("Scan", BM_Scan)->Arg(n)->ArgName("keys");
+    benchmark::RegisterBenchmark("Mixed", BM_Mixed)
+        ->Args({n, 50})
+        ->Args({n, 95})
+        ->ArgNames({"keys", "read_pct"});
+    for (auto bench : {benchmark::RegisterBenchmark("InsertSequential", BM_InsertSequential),
+                       benchmark::RegisterBenchmark("InsertRandom", BM_InsertRandom),
+                       benchmark::RegisterBenchmark("Remove", BM_Remove)}) {
+      bench->Arg(n)->ArgName("keys")->Unit(benchmark::kMillisecond);
+    }
+  }
+}
+
+}  // namespace bench
+}  // namespace mybplus
+
+int main(int argc, char **argv) {
+  int64_t min_keys = 10000;
+  int64_t max_keys = 1000000;
+  mybplus::bench::TakeFlag(&argc, argv, "min_keys", &min_keys);
+  mybplus::bench::TakeFlag(&argc, argv, "max_keys", &max_keys);
+  int64_t perf_counters = 1;
+  mybplus::bench::TakeFlag(&argc, argv, "perf_counters", &perf_counters);
+  mybplus::bench::perf_counters_enabled = perf_counters != 0;
+  if (mybplus::bench::perf_counters_enabled) {
+    mybplus::bench::PerfCounters probe;
+    if (!probe.Unavailable().empty()) {
+      std::string names;
+      for (const auto &name : probe.Unavailable()) {
+        names += " " + name;
+      }
+      std::fprintf(stderr, "perf counters unavailable, not reported:%s\n", names.c_str());
+    }
+  }
+
+  // 默认参数放在用户参数之前，用户给出的同名参数会覆盖它们
+  std::vector<char *> args{argv[0]};
+  std::string repetitions = "--benchmark_repetitions=3";
+  std::string warmup = "--benchmark_min_warmup_time=0.2";
+  std::string aggregates = "--benchmark_report_aggregates_only=true";
+  args.push_back(repetitions.data());
+  args.push_back(warmup.data());
+  args.push_back(aggregates.data());
+  args.insert(args.end(), argv + 1, argv + argc);
+  int args_count = static_cast<int>(args.size());
+
+  benchmark::Initialize(&args_count, args.data());
+  if (benchmark::ReportUnrecognizedArguments(args_count, args.data())) {
+    return 1;
+  }
+  mybplus::bench::RegisterBenchmarks(std::max<int64_t>(min_keys, 1), max_keys);
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
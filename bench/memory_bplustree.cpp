@@ -0,0 +1,360 @@
+// Memory footprint of BPlusTree against std::map and std::unordered_map.
+//
+//   memory_bplustree [--keys=1000000] [--delete_percent=90] [--seed=42]
+//
+// The binary replaces the global operator new/delete with counting versions, so a container's
+// footprint is the change in live heap bytes from before it is constructed to after it is loaded.
+// Every container receives the same keys in each insertion order: bulk (the tree's bulk loader,
+// hinted appends for std::map, a pre-sized table for std::unordered_map), ascending, descending
+// and random. The last row loads in random order and then removes --delete_percent of the keys.
+// A final table counts heap allocations per BPlusTree::GetValue call for each overload.
+//
+// Bytes per live key are split into
+//   payload  the key and value themselves
+//   header   bookkeeping: page headers, internal pages and the page table for the tree; node
+//            links for std::map; chain links and the bucket array for std::unordered_map
+//   slack    allocated but holding nothing: empty page slots and malloc size-class rounding
+
+#include <malloc.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <new>
+#include <numeric>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "b_plus_tree.h"
+#include "config.h"
+
+namespace {
+
+constexpr size_t kUnknownSize = static_cast<size_t>(-1);
+
+std::atomic<int64_t> live_requested{0};
+std::atomic<int64_t> live_usable{0};
+std::atomic<int64_t> live_blocks{0};
+std::atomic<int64_t> total_allocs{0};  // 只增不减，用于统计一段操作的分配次数
+
+auto CountedAllocate(size_t size, size_t alignment) -> void * {
+  void *ptr;
+  if (alignment <= alignof(std::max_align_t)) {
+    ptr = std::malloc(size == 0 ? 1 : size);
+  } else {
+    ptr = std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+  }
+  if (ptr != nullptr) {
+    live_requested.fetch_add(size, std::memory_order_relaxed);
+    live_usable.fetch_add(malloc_usable_size(ptr), std::memory_order_relaxed);
+    live_blocks.fetch_add(1, std::memory_order_relaxed);
+    total_allocs.fetch_add(1, std::memory_order_relaxed);
+  }
+  return ptr;
+}
+
+auto CountedNew(size_t size, size_t alignment) -> void * {
+  void *ptr = CountedAllocate(size, alignment);
+  if (ptr == nullptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+// 未带大小的 delete 只能按 malloc 实际大小扣除（GCC 默认对容器和 delete 表达式使用带大小的版本）
+auto CountedDelete(void *ptr, size_t size) -> void {
+  if (ptr == nullptr) {
+    return;
+  }
+  auto usable = static_cast<int64_t>(malloc_usable_size(ptr));
+  live_requested.fetch_sub(size == kUnknownSize ? usable : static_cast<int64_t>(size),
+                           std::memory_order_relaxed);
+  live_usable.fetch_sub(usable, std::memory_order_relaxed);
+  live_blocks.fetch_sub(1, std::memory_order_relaxed);
+  std::free(ptr);
+}
+
+}  // namespace
+
+auto operator new(size_t size) -> void * { return CountedNew(size, 0); }
+auto operator new[](size_t size) -> void * { return CountedNew(size, 0); }
+auto operator new(size_t size, const std::nothrow_t &) noexcept -> void * {
+  return CountedAllocate(size, 0);
+}
+auto operator new[](size_t size, const std::nothrow_t &) noexcept -> void * {
+  return CountedAllocate(size, 0);
+}
+auto operator new(size_t size, std::align_val_t alignment) -> void * {
+  return CountedNew(size, static_cast<size_t>(alignment));
+}
+auto operator new[](size_t size, std::align_val_t alignment) -> void * {
+  return CountedNew(size, static_cast<size_t>(alignment));
+}
+void operator delete(void *ptr) noexcept { CountedDelete(ptr, kUnknownSize); }
+void operator delete[](void *ptr) noexcept { CountedDelete(ptr, kUnknownSize); }
+void operator delete(void *ptr, size_t size) noexcept { CountedDelete(ptr, size); }
+void operator delete[](void *ptr, size_t size) noexcept { CountedDelete(ptr, size); }
+void operator delete(void *ptr, const std::nothrow_t &) noexcept {
+  CountedDelete(ptr, kUnknownSize);
+}
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept {
+  CountedDelete(ptr, kUnknownSize);
+}
+void operator delete(void *ptr, std::align_val_t) noexcept { CountedDelete(ptr, kUnknownSize); }
+void operator delete[](void *ptr, std::align_val_t) noexcept { CountedDelete(ptr, kUnknownSize); }
+void operator delete(void *ptr, size_t size, std::align_val_t) noexcept {
+  CountedDelete(ptr, size);
+}
+void operator delete[](void *ptr, size_t size, std::align_val_t) noexcept {
+  CountedDelete(ptr, size);
+}
+
+namespace mybplus {
+namespace bench {
+
+using Tree = BPlusTree<KeyType, ValueType, KeyComparator>;
+
+constexpr size_t kPayload = sizeof(KeyType) + sizeof(ValueType);
+
+struct Options {
+  uint64_t keys = 1000000;
+  int delete_percent = 90;
+  uint64_t seed = 42;
+};
+
+struct Scenario {
+  std::string name;
+  bool bulk;
+  std::vector<KeyType> inserts;  // bulk 时为升序
+  std::vector<KeyType> removes;
+};
+
+struct Footprint {
+  uint64_t keys = 0;
+  int64_t requested = 0;
+  int64_t usable = 0;
+  int64_t blocks = 0;
+  int64_t unused_slots = 0;  // 容器内部已分配但为空的槽位
+};
+
+class TreeContainer {
+ public:
+  static constexpr const char *kName = "BPlusTree";
+
+  auto BulkLoad(const std::vector<KeyType> &sorted) -> void {
+    tree_.BeginBulkLoad(sorted.size());
+    for (auto key : sorted) {
+      tree_.BulkLoadAppend(key, ValueType{});
+    }
+    tree_.FinishBulkLoad();
+  }
+  auto Insert(KeyType key) -> void { tree_.Insert(key, ValueType{}); }
+  auto Remove(KeyType key) -> void { tree_.Remove(key); }
+  auto UnusedSlotBytes() -> int64_t {
+    TreeStats stats = tree_.GetStats(true);
+    uint64_t page_objects =
+        stats.leaf_pages * sizeof(BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>) +
+        stats.internal_pages * sizeof(BPlusTreeInternalPage<KeyType, ChildRef, KeyComparator>);
+    return static_cast<int64_t>(stats.bytes_allocated - stats.bytes_used - page_objects);
+  }
+
+ private:
+  Tree tree_{"memory_tree", KeyComparator()};
+};
+
+class MapContainer {
+ public:
+  static constexpr const char *kName = "std::map";
+
+  auto BulkLoad(const std::vector<KeyType> &sorted) -> void {
+    for (auto key : sorted) {
+      map_.emplace_hint(map_.end(), key, ValueType{});
+    }
+  }
+  auto Insert(KeyType key) -> void { map_.emplace(key, ValueType{}); }
+  auto Remove(KeyType key) -> void { map_.erase(key); }
+  auto UnusedSlotBytes() -> int64_t { return 0; }
+
+ private:
+  std::map<KeyType, ValueType> map_;
+};
+
+class HashContainer {
+ public:
+  static constexpr const char *kName = "std::unordered_map";
+
+  auto BulkLoad(const std::vector<KeyType> &sorted) -> void {
+    map_.reserve(sorted.size());
+    for (auto key : sorted) {
+      map_.emplace(key, ValueType{});
+    }
+  }
+  auto Insert(KeyType key) -> void { map_.emplace(key, ValueType{}); }
+  auto Remove(KeyType key) -> void { map_.erase(key); }
+  auto UnusedSlotBytes() -> int64_t { return 0; }
+
+ private:
+  std::unordered_map<KeyType, ValueType> map_;
+};
+
+template <typename Container>
+auto Measure(const Scenario &scenario) -> Footprint {
+  int64_t requested = live_requested.load();
+  int64_t usable = live_usable.load();
+  int64_t blocks = live_blocks.load();
+  auto container = std::make_unique<Container>();
+  if (scenario.bulk) {
+    container->BulkLoad(scenario.inserts);
+  } else {
+    for (auto key : scenario.inserts) {
+      container->Insert(key);
+    }
+  }
+  for (auto key : scenario.removes) {
+    container->Remove(key);
+  }
+
+  Footprint footprint;
+  footprint.keys = scenario.inserts.size() - scenario.removes.size();
+  footprint.requested = live_requested.load() - requested;
+  footprint.usable = live_usable.load() - usable;
+  footprint.blocks = live_blocks.load() - blocks;
+  // 统计本身会分配内存，放在读取计数之后
+  footprint.unused_slots = container->UnusedSlotBytes();
+  return footprint;
+}
+
+auto Print(const std::string &scenario, const char *container, const Footprint &footprint)
+    -> void {
+  double keys = std::max<uint64_t>(footprint.keys, 1);
+  int64_t payload = footprint.keys * kPayload;
+  int64_t header = footprint.requested - payload - footprint.unused_slots;
+  int64_t slack = footprint.usable - footprint.requested + footprint.unused_slots;
+  std::cout << std::left << std::setw(15) << scenario << std::setw(20) << container << std::right
+            << std::setw(10) << footprint.keys << std::fixed << std::setprecision(1)
+            << std::setw(11) << footprint.usable / keys << std::setw(9) << header / keys
+            << std::setw(9) << slack / keys << std::setw(9) << payload / keys
+            << std::setprecision(3) << std::setw(12) << footprint.blocks / keys << "\n";
+}
+
+auto MakeScenarios(const Options &options) -> std::vector<Scenario> {
+  std::vector<KeyType> ascending(options.keys);
+  std::iota(ascending.begin(), ascending.end(), 0);
+  std::vector<KeyType> descending(ascending.rbegin(), ascending.rend());
+  std::vector<KeyType> random = ascending;
+  std::mt19937_64 rng(options.seed);
+  std::shuffle(random.begin(), random.end(), rng);
+
+  // 删除的键与插入顺序无关，另行打乱
+  std::vector<KeyType> removes = ascending;
+  std::shuffle(removes.begin(), removes.end(), rng);
+  removes.resize(options.keys * options.delete_percent / 100);
+
+  std::vector<Scenario> scenarios;
+  scenarios.push_back({"bulk", true, ascending, {}});
+  scenarios.push_back({"ascending", false, ascending, {}});
+  scenarios.push_back({"descending", false, descending, {}});
+  scenarios.push_back({"random", false, random, {}});
+  scenarios.push_back({"random-delete", false, random, removes});
+  return scenarios;
+}
+
+// 每种 GetValue 重载平均每次查找的堆分配次数
+auto PrintLookupAllocations(const Options &options) -> void {
+  Tree tree("lookup_tree", KeyComparator());
+  tree.BeginBulkLoad(options.keys);
+  for (uint64_t i = 0; i < options.keys; i++) {
+    tree.BulkLoadAppend(static_cast<KeyType>(i), ValueType{});
+  }
+  tree.FinishBulkLoad();
+
+  std::vector<KeyType> probes(std::min<uint64_t>(options.keys, 100000));
+  std::mt19937_64 rng(options.seed);
+  for (auto &probe : probes) {
+    probe = static_cast<KeyType>(rng() % options.keys);
+  }
+  auto allocs_per_lookup = [&probes](auto lookup) {
+    int64_t before = total_allocs.load();
+    for (auto key : probes) {
+      lookup(key);
+    }
+    return static_cast<double>(total_allocs.load() - before) / probes.size();
+  };
+
+  std::cout << "\n" << std::left << std::setw(35) << "GetValue overload" << std::right
+            << std::setw(12) << "allocs/get" << "\n";
+  std::cout << std::fixed << std::setprecision(3) << std::left << std::setw(35)
+            << "std::vector<ValueType> *" << std::right << std::setw(12)
+            << allocs_per_lookup([&tree](KeyType key) {
+                 std::vector<ValueType> result;
+                 tree.GetValue(key, &result);
+               })
+            << "\n";
+  std::cout << std::left << std::setw(35) << "ValueType *" << std::right << std::setw(12)
+            << allocs_per_lookup([&tree](KeyType key) {
+                 ValueType value;
+                 tree.GetValue(key, &value);
+               })
+            << "\n";
+  std::cout << std::left << std::setw(35) << "std::optional<ValueType>" << std::right
+            << std::setw(12) << allocs_per_lookup([&tree](KeyType key) { tree.GetValue(key); })
+            << "\n";
+}
+
+auto Run(const Options &options) -> void {
+  std::cout << "payload " << kPayload << " bytes per key; header/slack/payload are bytes per live "
+            << "key, allocs is heap blocks per live key\n"
+            << std::left << std::setw(15) << "order" << std::setw(20) << "container" << std::right
+            << std::setw(10) << "keys" << std::setw(11) << "bytes/key" << std::setw(9)
+            << "header" << std::setw(9) << "slack" << std::setw(9) << "payload" << std::setw(12)
+            << "allocs/key" << "\n";
+  for (const auto &scenario : MakeScenarios(options)) {
+    Print(scenario.name, TreeContainer::kName, Measure<TreeContainer>(scenario));
+    Print(scenario.name, MapContainer::kName, Measure<MapContainer>(scenario));
+    Print(scenario.name, HashContainer::kName, Measure<HashContainer>(scenario));
+  }
+  PrintLookupAllocations(options);
+}
+
+auto Usage() -> int {
+  std::cerr << "usage: memory_bplustree [--keys=N] [--delete_percent=0..100] [--seed=N]\n";
+  return 1;
+}
+
+}  // namespace bench
+}  // namespace mybplus
+
+int main(int argc, char **argv) {
+  using mybplus::bench::Usage;
+  mybplus::bench::Options options;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    size_t eq = arg.find('=');
+    if (arg.compare(0, 2, "--") != 0 || eq == std::string::npos) {
+      return Usage();
+    }
+    std::string name = arg.substr(2, eq - 2);
+    std::string value = arg.substr(eq + 1);
+    if (name == "keys") {
+      options.keys = std::strtoull(value.c_str(), nullptr, 10);
+    } else if (name == "delete_percent") {
+      options.delete_percent = std::atoi(value.c_str());
+    } else if (name == "seed") {
+      options.seed = std::strtoull(value.c_str(), nullptr, 10);
+    } else {
+      return Usage();
+    }
+  }
+  if (options.keys == 0 || options.delete_percent < 0 || options.delete_percent > 100) {
+    return Usage();
+  }
+  mybplus::bench::Run(options);
+  return 0;
+}
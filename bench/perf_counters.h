@@ -0,0 +1,144 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace mybplus {
+namespace bench {
+
+/**
+ * Hardware counters for the calling thread through perf_event_open. Each event is opened on its
+ * own rather than as a group, so an event the CPU or hypervisor does not expose (dTLB misses in
+ * many VMs) only drops that column. Counts are scaled for multiplexing. When nothing can be
+ * opened (no PMU, perf_event_paranoid too strict, not Linux) IsAvailable() is false and
+ * Start/Stop do nothing. User space only, so perf_event_paranoid <= 2 is enough.
+ */
+class PerfCounters {
+ public:
+  PerfCounters() {
+#ifdef __linux__
+    Open("cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+    Open("instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+    Open("l1d_misses", PERF_TYPE_HW_CACHE, CacheEvent(PERF_COUNT_HW_CACHE_L1D));
+    Open("llc_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+    Open("branch_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+    Open("dtlb_misses", PERF_TYPE_HW_CACHE, CacheEvent(PERF_COUNT_HW_CACHE_DTLB));
+    Open("page_faults", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS);
+#endif
+  }
+  ~PerfCounters() {
+#ifdef __linux__
+    for (auto &event : events_) {
+      close(event.fd);
+    }
+#endif
+  }
+  PerfCounters(const PerfCounters &) = delete;
+  auto operator=(const PerfCounters &) -> PerfCounters & = delete;
+
+  auto IsAvailable() const -> bool { return !events_.empty(); }
+  // 可以多次 Start/Stop，计数累加
+  auto Start() -> void {
+#ifdef __linux__
+    for (auto &event : events_) {
+      Read(&event, &event.start);
+      ioctl(event.fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+  }
+  auto Stop() -> void {
+#ifdef __linux__
+    for (auto &event : events_) {
+      ioctl(event.fd, PERF_EVENT_IOC_DISABLE, 0);
+      Sample end;
+      Read(&event, &end);
+      uint64_t enabled = end.enabled - event.start.enabled;
+      uint64_t running = end.running - event.start.running;
+      double value = static_cast<double>(end.value - event.start.value);
+      // 与其他事件分时复用时按运行时间比例放大
+      if (running > 0 && running < enabled) {
+        value *= static_cast<double>(enabled) / running;
+      }
+      event.total += value;
+    }
+#endif
+  }
+  auto Reset() -> void {
+    for (auto &event : events_) {
+      event.total = 0;
+    }
+  }
+
+  // Events that could not be opened on this machine
+  auto Unavailable() const -> const std::vector<std::string> & { return unavailable_; }
+
+  // (name, count) of every event that could be opened
+  auto Values() const -> std::vector<std::pair<std::string, double>> {
+    std::vector<std::pair<std::string, double>> values;
+    for (const auto &event : events_) {
+      values.emplace_back(event.name, event.total);
+    }
+    return values;
+  }
+
+ private:
+  struct Sample {
+    uint64_t value = 0;
+    uint64_t enabled = 0;
+    uint64_t running = 0;
+  };
+  struct Event {
+    std::string name;
+    int fd;
+    Sample start;
+    double total = 0;
+  };
+
+#ifdef __linux__
+  static auto CacheEvent(uint64_t cache) -> uint64_t {
+    return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+  }
+
+  auto Open(const char *name, uint32_t type, uint64_t config) -> void {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    int fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    if (fd >= 0) {
+      events_.push_back({name, fd, {}, 0});
+    } else {
+      unavailable_.emplace_back(name);
+    }
+  }
+
+  static auto Read(const Event *event, Sample *sample) -> void {
+    uint64_t buffer[3] = {0, 0, 0};
+    if (read(event->fd, buffer, sizeof(buffer)) == sizeof(buffer)) {
+      sample->value = buffer[0];
+      sample->enabled = buffer[1];
+      sample->running = buffer[2];
+    }
+  }
+#endif
+
+  std::vector<Event> events_;
+  std::vector<std::string> unavailable_;
+};
+
+}  // namespace bench
+}  // namespace mybplus
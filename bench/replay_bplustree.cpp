@@ -0,0 +1,253 @@
+// Replays a trace written by BPlusTree::StartTrace.
+//
+//   replay_bplustree --trace=FILE [--speed=original|max] [--order=thread|strict]
+//                    [--snapshot=DIR | --preload=N]
+//
+// One replay thread is started per traced thread and issues that thread's calls in their
+// original order. --speed=original waits until each call's recorded offset from the start of the
+// trace; --speed=max issues calls back to back. --order=strict additionally serializes all calls
+// in global timestamp order, which makes the replay deterministic at the cost of concurrency.
+// The tree starts either from a serializer snapshot taken when the trace began (--snapshot) or
+// bulk-loaded with keys 0..N-1 (--preload). Inserted and updated values are derived from the key,
+// since traces do not carry values.
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "b_plus_tree.h"
+#include "b_plus_tree_trace.h"
+
+extern "C" {
+#include "b_plus_tree_serializer.h"
+#include "b_plus_tree_wrapper.h"
+}
+
+namespace mybplus {
+namespace bench {
+
+constexpr int kOpCount = static_cast<int>(TraceOp::SCAN) + 1;
+const char *const kOpNames[kOpCount] = {"get", "insert", "remove", "update", "scan"};
+constexpr std::chrono::microseconds kSpinWindow(200);
+
+struct Options {
+  std::string trace;
+  bool original_speed = true;
+  bool strict_order = false;
+  std::string snapshot;
+  uint64_t preload = 0;
+};
+
+auto MakeValue(int64_t key) -> ::ValueType {
+  ::ValueType value;
+  std::memset(value.data, 0, sizeof(value.data));
+  std::memcpy(value.data, &key, sizeof(key));
+  return value;
+}
+
+auto Execute(CBPlusTree *tree, const TraceRecord &record, std::vector<KeyType> *keys,
+             std::vector<::ValueType> *values) -> void {
+  switch (static_cast<TraceOp>(record.op)) {
+    case TraceOp::GET: {
+      ::ValueType value;
+      bpt_get_value(tree, record.key, &value);
+      break;
+    }
+    case TraceOp::INSERT:
+      bpt_insert(tree, record.key, MakeValue(record.key));
+      break;
+    case TraceOp::REMOVE:
+      bpt_remove(tree, record.key);
+      break;
+    case TraceOp::UPDATE:
+      bpt_update(tree, record.key, MakeValue(record.key));
+      break;
+    case TraceOp::SCAN:
+      keys->resize(record.arg);
+      values->resize(record.arg);
+      bpt_scan(tree, record.key, static_cast<int>(record.arg), keys->data(), values->data());
+      break;
+  }
+}
+
+auto LoadTree(const Options &options) -> CBPlusTree * {
+  CBPlusTree *tree = bpt_create(LEAF_PAGE_SIZE, INTERNAL_PAGE_SIZE);
+  if (!options.snapshot.empty()) {
+    BPlusTreeSerializer *serializer = serializer_create(tree, options.snapshot.c_str());
+    bool ok = serializer_deserialize(serializer);
+    serializer_destroy(serializer);
+    if (!ok) {
+      bpt_destroy(tree);
+      return nullptr;
+    }
+    return tree;
+  }
+  bpt_bulk_load_begin(tree, options.preload, 1.0);
+  for (uint64_t i = 0; i < options.preload; i++) {
+    KeyType key = static_cast<KeyType>(i);
+    ::ValueType value = MakeValue(key);
+    bpt_bulk_load_append(tree, &key, &value, 1);
+  }
+  bpt_bulk_load_finish(tree);
+  return tree;
+}
+
+auto Replay(const Options &options) -> int {
+  TraceHeader header;
+  std::vector<TraceRecord> records;
+  if (!TraceRecorder::ReadTrace(options.trace, &header, &records)) {
+    std::cerr << "cannot read trace " << options.trace << "\n";
+    return 1;
+  }
+  CBPlusTree *tree = LoadTree(options);
+  if (tree == nullptr) {
+    std::cerr << "cannot load snapshot " << options.snapshot << "\n";
+    return 1;
+  }
+
+  // 按原线程分组，组内保持原来的顺序
+  std::map<uint16_t, std::vector<size_t>> by_thread;
+  for (size_t i = 0; i < records.size(); i++) {
+    by_thread[records[i].thread].push_back(i);
+  }
+  std::vector<std::array<HistogramSnapshot, kOpCount>> latency(by_thread.size());
+  std::vector<uint64_t> max_lag(by_thread.size(), 0);
+  std::atomic<size_t> turn{0};
+  std::atomic<bool> start{false};
+  std::chrono::steady_clock::time_point begin;
+
+  std::vector<std::thread> threads;
+  size_t slot = 0;
+  for (const auto &entry : by_thread) {
+    const std::vector<size_t> &indexes = entry.second;
+    threads.emplace_back([&, slot, &indexes = indexes]() {
+      std::vector<KeyType> keys;
+      std::vector<::ValueType> values;
+      while (!start.load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+      }
+      for (size_t index : indexes) {
+        const TraceRecord &record = records[index];
+        auto scheduled = begin + std::chrono::nanoseconds(record.timestamp_ns);
+        if (options.original_speed) {
+          if (scheduled - std::chrono::steady_clock::now() > kSpinWindow) {
+            std::this_thread::sleep_until(scheduled - kSpinWindow);
+          }
+          while (std::chrono::steady_clock::now() < scheduled) {
+            std::this_thread::yield();
+          }
+        }
+        if (options.strict_order) {
+          while (turn.load(std::memory_order_acquire) != index) {
+            std::this_thread::yield();
+          }
+        }
+        auto op_start = std::chrono::steady_clock::now();
+        Execute(tree, record, &keys, &values);
+        auto op_end = std::chrono::steady_clock::now();
+        if (options.strict_order) {
+          turn.store(index + 1, std::memory_order_release);
+        }
+        latency[slot][record.op].Record(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(op_end - op_start).count());
+        if (options.original_speed && op_start > scheduled) {
+          uint64_t lag =
+              std::chrono::duration_cast<std::chrono::nanoseconds>(op_start - scheduled).count();
+          max_lag[slot] = std::max(max_lag[slot], lag);
+        }
+      }
+    });
+    slot++;
+  }
+
+  begin = std::chrono::steady_clock::now();
+  start.store(true, std::memory_order_release);
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+  bpt_destroy(tree);
+
+  double traced_seconds = records.empty() ? 0 : records.back().timestamp_ns / 1e9;
+  std::cout << "trace " << options.trace << ": " << records.size() << " calls from "
+            << by_thread.size() << " threads over " << std::fixed << std::setprecision(3)
+            << traced_seconds << " s";
+  if (header.dropped > 0) {
+    std::cout << " (" << header.dropped << " calls dropped while recording)";
+  }
+  std::cout << "\nreplay " << (options.original_speed ? "original" : "max") << " speed, "
+            << (options.strict_order ? "strict" : "per-thread") << " order: " << seconds
+            << " s, " << std::setprecision(0) << records.size() / seconds << " ops/s";
+  if (options.original_speed) {
+    std::cout << ", max lag " << *std::max_element(max_lag.begin(), max_lag.end()) / 1000
+              << " us";
+  }
+  std::cout << "\n"
+            << std::left << std::setw(8) << "op" << std::right << std::setw(12) << "count"
+            << std::setw(12) << "mean(ns)" << std::setw(10) << "p50" << std::setw(10) << "p99"
+            << std::setw(10) << "p999" << std::setw(12) << "max" << "\n";
+  for (int op = 0; op < kOpCount; op++) {
+    HistogramSnapshot total;
+    for (const auto &thread_latency : latency) {
+      total.Merge(thread_latency[op]);
+    }
+    if (total.count == 0) {
+      continue;
+    }
+    std::cout << std::left << std::setw(8) << kOpNames[op] << std::right << std::setw(12)
+              << total.count << std::setw(12) << std::setprecision(1) << total.Mean()
+              << std::setw(10) << total.Percentile(0.5) << std::setw(10)
+              << total.Percentile(0.99) << std::setw(10) << total.Percentile(0.999)
+              << std::setw(12) << total.max << "\n";
+  }
+  return 0;
+}
+
+auto Usage() -> int {
+  std::cerr << "usage: replay_bplustree --trace=FILE [--speed=original|max] "
+               "[--order=thread|strict] [--snapshot=DIR | --preload=N]\n";
+  return 1;
+}
+
+}  // namespace bench
+}  // namespace mybplus
+
+int main(int argc, char **argv) {
+  using mybplus::bench::Usage;
+  mybplus::bench::Options options;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    size_t eq = arg.find('=');
+    if (arg.compare(0, 2, "--") != 0 || eq == std::string::npos) {
+      return Usage();
+    }
+    std::string name = arg.substr(2, eq - 2);
+    std::string value = arg.substr(eq + 1);
+    if (name == "trace") {
+      options.trace = value;
+    } else if (name == "speed" && (value == "original" || value == "max")) {
+      options.original_speed = value == "original";
+    } else if (name == "order" && (value == "thread" || value == "strict")) {
+      options.strict_order = value == "strict";
+    } else if (name == "snapshot") {
+      options.snapshot = value;
+    } else if (name == "preload") {
+      options.preload = std::strtoull(value.c_str(), nullptr, 10);
+    } else {
+      return Usage();
+    }
+  }
+  if (options.trace.empty()) {
+    return Usage();
+  }
+  return mybplus::bench::Replay(options);
+}
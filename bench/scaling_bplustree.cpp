@@ -0,0 +1,308 @@
+// Thread-scaling and tail-latency sweep for BPlusTree.
+//
+//   scaling_bplustree [--max_threads=N (default: hardware threads)] [--records=1000000]
+//                     [--seconds=1] [--workload=read,write,mixed] [--pin=0|1]
+//                     [--mode=single_thread,global_lock,crabbing,optimistic]
+//                     [--distribution=uniform|zipfian|hotspot] [--theta=0.99] [--shards=N]
+//
+// For every concurrency mode (see ConcurrencyMode) and every workload, the thread count is swept
+// over 1, 2, 4, ... up to --max_threads; single_thread takes no locks and only runs one thread.
+// Each point runs for --seconds on a tree bulk-loaded with --records keys and reports total and
+// per-thread throughput, scaling efficiency against the single-thread run
+// (throughput(n) / (n * throughput(1))) and p50/p99/p999 latency over all operations. --pin binds
+// thread i to CPU i modulo the CPU count. --shards=N runs every point on a ShardedBPlusTree
+// with N equal key ranges instead of a single tree; the shards column shows N, or - without it.
+//
+// Workloads: read is 100% lookups; write alternates inserting a fresh key with removing the key
+// inserted kPending writes earlier, so the tree size stays constant; mixed is 90% lookups and 10%
+// such writes.
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "b_plus_tree.h"
+#include "b_plus_tree_sharded.h"
+#include "config.h"
+#include "workload_generators.h"
+
+namespace mybplus {
+namespace bench {
+
+using Tree = BPlusTree<KeyType, ValueType, KeyComparator>;
+using ShardedTree = ShardedBPlusTree<KeyType, ValueType, KeyComparator>;
+
+constexpr size_t kPending = 64;
+
+struct Options {
+  int max_threads = static_cast<int>(std::max(1U, std::thread::hardware_concurrency()));
+  uint64_t records = 1000000;
+  double seconds = 1.0;
+  std::vector<std::string> workloads = {"read", "write", "mixed"};
+  std::vector<std::string> modes = {"single_thread", "global_lock", "crabbing", "optimistic"};
+  bool pin = false;
+  KeyDistribution distribution = KeyDistribution::UNIFORM;
+  double theta = 0.99;
+  int shards = 0;  // 0 表示不分片
+};
+
+struct Workload {
+  std::string name;
+  int read_percent;
+};
+
+struct Mode {
+  std::string name;
+  ConcurrencyMode mode;
+};
+
+auto AvailableModes() -> std::vector<Mode> {
+  return {{"single_thread", ConcurrencyMode::SINGLE_THREADED},
+          {"global_lock", ConcurrencyMode::GLOBAL_LOCK},
+          {"crabbing", ConcurrencyMode::CRABBING},
+          {"optimistic", ConcurrencyMode::OPTIMISTIC}};
+}
+
+struct PointResult {
+  uint64_t operations = 0;
+  double seconds = 0;
+  HistogramSnapshot latency;
+};
+
+auto PinToCpu(int index) -> void {
+  int cpus = static_cast<int>(std::max(1U, std::thread::hardware_concurrency()));
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(index % cpus, &set);
+  pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+template <typename TreeType>
+auto RunPoint(TreeType *tree, const Options &options, const Workload &workload, int threads)
+    -> PointResult {
+  std::atomic<int> ready{0};
+  std::atomic<bool> start{false};
+  std::atomic<bool> stop{false};
+  std::vector<PointResult> results(threads);
+  std::vector<std::thread> workers;
+  KeyChooser prototype(options.distribution, options.records, options.theta, 0.2, 0.8);
+
+  for (int t = 0; t < threads; t++) {
+    workers.emplace_back([&, t]() {
+      if (options.pin) {
+        PinToCpu(t);
+      }
+      std::mt19937_64 rng(t * 7919 + threads);
+      std::uniform_int_distribution<int> percent(0, 99);
+      KeyChooser chooser = prototype;
+      std::deque<KeyType> pending;
+      ValueType found;
+      ValueType value{};
+      PointResult &result = results[t];
+
+      ready.fetch_add(1);
+      while (!start.load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+      }
+      auto begin = std::chrono::steady_clock::now();
+      while (!stop.load(std::memory_order_relaxed)) {
+        auto op_start = std::chrono::steady_clock::now();
+        if (percent(rng) < workload.read_percent) {
+          tree->GetValue(static_cast<KeyType>(chooser.Next(rng, options.records)) * 2, &found);
+        } else if (pending.size() < kPending) {
+          // 写入奇数键 2m+1，并让 m 模线程数等于线程编号，各线程的键互不冲突
+          auto m = static_cast<KeyType>(chooser.Next(rng, options.records));
+          KeyType key = 2 * (m - m % threads + t) + 1;
+          tree->Insert(key, value);
+          pending.push_back(key);
+        } else {
+          tree->Remove(pending.front());
+          pending.pop_front();
+        }
+        auto op_end = std::chrono::steady_clock::now();
+        result.latency.Record(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(op_end - op_start).count());
+        result.operations++;
+      }
+      result.seconds =
+          std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+      for (auto key : pending) {
+        tree->Remove(key);
+      }
+    });
+  }
+
+  while (ready.load() < threads) {
+    std::this_thread::yield();
+  }
+  start.store(true, std::memory_order_release);
+  std::this_thread::sleep_for(std::chrono::duration<double>(options.seconds));
+  stop.store(true, std::memory_order_relaxed);
+  for (auto &worker : workers) {
+    worker.join();
+  }
+
+  PointResult total;
+  for (const auto &result : results) {
+    total.operations += result.operations;
+    total.seconds = std::max(total.seconds, result.seconds);
+    total.latency.Merge(result.latency);
+  }
+  return total;
+}
+
+auto ThreadCounts(int max_threads) -> std::vector<int> {
+  std::vector<int> counts;
+  for (int n = 1; n < max_threads; n *= 2) {
+    counts.push_back(n);
+  }
+  counts.push_back(max_threads);
+  return counts;
+}
+
+template <typename TreeType>
+auto Sweep(TreeType *tree, const Options &options, const std::string &name,
+           const Workload &workload, int max_threads) -> void {
+  double single_thread = 0;
+  std::string shards = options.shards > 0 ? std::to_string(options.shards) : "-";
+  for (int threads : ThreadCounts(max_threads)) {
+    PointResult result = RunPoint(tree, options, workload, threads);
+    double throughput = result.operations / result.seconds;
+    if (threads == 1) {
+      single_thread = throughput;
+    }
+    double efficiency = single_thread > 0 ? throughput / (threads * single_thread) : 0;
+    std::cout << std::left << std::setw(15) << name << std::setw(8) << workload.name
+              << std::right << std::setw(8) << shards << std::setw(8) << threads << std::fixed
+              << std::setprecision(0) << std::setw(14) << throughput << std::setw(14)
+              << throughput / threads << std::setw(11) << std::setprecision(1)
+              << efficiency * 100 << "%" << std::setw(10) << result.latency.Percentile(0.5)
+              << std::setw(10) << result.latency.Percentile(0.99) << std::setw(10)
+              << result.latency.Percentile(0.999) << std::endl;
+  }
+}
+
+auto Run(const Options &options) -> void {
+  const std::vector<Workload> all_workloads = {{"read", 100}, {"write", 0}, {"mixed", 90}};
+  std::cout << std::left << std::setw(15) << "mode" << std::setw(8) << "workload" << std::right
+            << std::setw(8) << "shards" << std::setw(8) << "threads" << std::setw(14) << "ops/s"
+            << std::setw(14) << "ops/s/thread" << std::setw(12) << "efficiency" << std::setw(10)
+            << "p50(ns)" << std::setw(10) << "p99" << std::setw(10) << "p999" << "\n";
+  for (const auto &mode : AvailableModes()) {
+    if (std::find(options.modes.begin(), options.modes.end(), mode.name) == options.modes.end()) {
+      continue;
+    }
+    for (const auto &workload : all_workloads) {
+      if (std::find(options.workloads.begin(), options.workloads.end(), workload.name) ==
+          options.workloads.end()) {
+        continue;
+      }
+      int max_threads = mode.mode == ConcurrencyMode::SINGLE_THREADED ? 1 : options.max_threads;
+      // 树中已有的键为 0, 2, 4, ...
+      if (options.shards > 0) {
+        std::vector<KeyType> split_keys;
+        for (int i = 1; i < options.shards; i++) {
+          split_keys.push_back(static_cast<KeyType>(options.records * 2 / options.shards * i));
+        }
+        auto tree = std::make_unique<ShardedTree>("scaling_tree", KeyComparator(),
+                                                  options.shards, split_keys, LEAF_PAGE_SIZE,
+                                                  INTERNAL_PAGE_SIZE, mode.mode);
+        // 顺序装载时关闭自动划分，否则会先拆分正在装载的分片
+        tree->SetAutoRebalance(false);
+        for (uint64_t i = 0; i < options.records; i++) {
+          tree->Insert(static_cast<KeyType>(i) * 2, ValueType{});
+        }
+        tree->SetAutoRebalance(true);
+        Sweep(tree.get(), options, mode.name, workload, max_threads);
+        continue;
+      }
+      auto tree = std::make_unique<Tree>("scaling_tree", KeyComparator(), LEAF_PAGE_SIZE,
+                                         INTERNAL_PAGE_SIZE, mode.mode);
+      tree->BeginBulkLoad(options.records);
+      for (uint64_t i = 0; i < options.records; i++) {
+        tree->BulkLoadAppend(static_cast<KeyType>(i) * 2, ValueType{});
+      }
+      tree->FinishBulkLoad();
+      Sweep(tree.get(), options, mode.name, workload, max_threads);
+    }
+  }
+}
+
+auto Usage() -> int {
+  std::cerr << "usage: scaling_bplustree [--max_threads=N] [--records=N] [--seconds=S] "
+               "[--workload=read,write,mixed] [--pin=0|1] "
+               "[--mode=single_thread,global_lock,crabbing,optimistic] "
+               "[--distribution=uniform|zipfian|hotspot] [--theta=0.99] [--shards=N]\n";
+  return 1;
+}
+
+}  // namespace bench
+}  // namespace mybplus
+
+int main(int argc, char **argv) {
+  using mybplus::bench::KeyDistribution;
+  using mybplus::bench::Usage;
+  mybplus::bench::Options options;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    size_t eq = arg.find('=');
+    if (arg.compare(0, 2, "--") != 0 || eq == std::string::npos) {
+      return Usage();
+    }
+    std::string name = arg.substr(2, eq - 2);
+    std::string value = arg.substr(eq + 1);
+    if (name == "max_threads") {
+      options.max_threads = std::atoi(value.c_str());
+    } else if (name == "records") {
+      options.records = std::strtoull(value.c_str(), nullptr, 10);
+    } else if (name == "seconds") {
+      options.seconds = std::strtod(value.c_str(), nullptr);
+    } else if (name == "workload" || name == "mode") {
+      std::vector<std::string> &list = name == "workload" ? options.workloads : options.modes;
+      list.clear();
+      std::stringstream items(value);
+      std::string item;
+      while (std::getline(items, item, ',')) {
+        list.push_back(item);
+      }
+    } else if (name == "pin") {
+      options.pin = value != "0";
+    } else if (name == "distribution") {
+      if (value == "uniform") {
+        options.distribution = KeyDistribution::UNIFORM;
+      } else if (value == "zipfian") {
+        options.distribution = KeyDistribution::ZIPFIAN;
+      } else if (value == "hotspot") {
+        options.distribution = KeyDistribution::HOTSPOT;
+      } else {
+        return Usage();
+      }
+    } else if (name == "theta") {
+      options.theta = std::strtod(value.c_str(), nullptr);
+    } else if (name == "shards") {
+      options.shards = std::atoi(value.c_str());
+    } else {
+      return Usage();
+    }
+  }
+  if (options.max_threads < 1 || options.records < 2 || options.seconds <= 0 ||
+      options.theta <= 0 || options.theta >= 1 || options.shards < 0) {
+    return Usage();
+  }
+  mybplus::bench::Run(options);
+  return 0;
+}
@@ -0,0 +1,156 @@
+// Snapshot size and throughput for every serializer format.
+//
+//   snapshot_bplustree [--keys=500000] [--seed=42]
+//
+// Builds a tree of --keys random keys, then for each format writes a snapshot with
+// serializer_serialize and reads it back into an empty tree with serializer_deserialize. Reports
+// the file size, its ratio against the raw format, and serialize/deserialize throughput measured
+// against the raw snapshot size, so formats that write fewer bytes are not credited twice.
+
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "b_plus_tree.h"
+#include "config.h"
+
+extern "C" {
+#include "b_plus_tree_serializer.h"
+#include "b_plus_tree_wrapper.h"
+}
+
+namespace mybplus {
+namespace bench {
+
+using Tree = BPlusTree<KeyType, ValueType, KeyComparator>;
+
+struct Options {
+  uint64_t keys = 500000;
+  uint64_t seed = 42;
+};
+
+struct Format {
+  const char *name;
+  uint32_t flags;
+};
+
+auto MakeValue(KeyType key) -> ValueType {
+  ValueType value{};
+  std::snprintf(value.data(), value.size(), "value_%lld", static_cast<long long>(key));
+  return value;
+}
+
+auto FileSize(const std::string &path) -> size_t {
+  std::ifstream file(path, std::ios::binary | std::ios::ate);
+  return static_cast<size_t>(file.tellg());
+}
+
+auto Run(const Options &options) -> bool {
+  Tree tree("snapshot_tree", KeyComparator(), 128, 128);
+  std::mt19937_64 rng(options.seed);
+  std::uniform_int_distribution<KeyType> distribution(1, static_cast<KeyType>(options.keys * 10));
+  std::unordered_set<KeyType> seen;
+  while (seen.size() < options.keys) {
+    KeyType key = distribution(rng);
+    if (seen.insert(key).second) {
+      tree.Insert(key, MakeValue(key));
+    }
+  }
+
+  const std::vector<Format> formats = {
+      {"raw", 0},
+      {"encoded", SERIALIZER_FLAG_ENCODED},
+      {"compressed", SERIALIZER_FLAG_COMPRESSED},
+      {"encoded+compressed", SERIALIZER_FLAG_ENCODED | SERIALIZER_FLAG_COMPRESSED},
+      {"segmented", SERIALIZER_FLAG_SEGMENTED},
+      {"segmented+encoded+compressed",
+       SERIALIZER_FLAG_SEGMENTED | SERIALIZER_FLAG_ENCODED | SERIALIZER_FLAG_COMPRESSED},
+      {"leaf_stream", SERIALIZER_FLAG_LEAF_STREAM},
+      {"leaf_stream+encoded+compressed",
+       SERIALIZER_FLAG_LEAF_STREAM | SERIALIZER_FLAG_ENCODED | SERIALIZER_FLAG_COMPRESSED},
+      {"raw+checksum", SERIALIZER_FLAG_CHECKSUM}};
+
+  std::cout << std::left << std::setw(32) << "format" << std::right << std::setw(14) << "bytes"
+            << std::setw(8) << "ratio" << std::setw(16) << "write(MB/s)" << std::setw(16)
+            << "read(MB/s)" << "\n";
+  size_t raw_size = 0;
+  for (const auto &format : formats) {
+    std::string path = "snapshot_bplustree_" + std::to_string(getpid()) + ".bin";
+    BPlusTreeSerializer *serializer =
+        serializer_create(reinterpret_cast<CBPlusTree *>(&tree), path.c_str());
+    serializer_set_flags(serializer, format.flags);
+    auto start = std::chrono::steady_clock::now();
+    bool ok = serializer_serialize(serializer);
+    double write_seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    serializer_destroy(serializer);
+
+    Tree restored("restored_tree", KeyComparator(), 128, 128);
+    BPlusTreeSerializer *deserializer =
+        serializer_create(reinterpret_cast<CBPlusTree *>(&restored), path.c_str());
+    start = std::chrono::steady_clock::now();
+    ok = ok && serializer_deserialize(deserializer);
+    double read_seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    serializer_destroy(deserializer);
+
+    size_t size = FileSize(path);
+    std::remove(path.c_str());
+    if (!ok) {
+      std::cerr << "snapshot round trip failed for " << format.name << "\n";
+      return false;
+    }
+    if (format.flags == 0) {
+      raw_size = size;
+    }
+    // 吞吐量按未压缩的数据量计算
+    double mb = static_cast<double>(raw_size) / (1024 * 1024);
+    std::cout << std::left << std::setw(32) << format.name << std::right << std::setw(14) << size
+              << std::fixed << std::setprecision(2) << std::setw(8)
+              << static_cast<double>(raw_size) / size << std::setprecision(0) << std::setw(16)
+              << mb / write_seconds << std::setw(16) << mb / read_seconds << std::endl;
+  }
+  return true;
+}
+
+auto Usage() -> int {
+  std::cerr << "usage: snapshot_bplustree [--keys=N] [--seed=N]\n";
+  return 1;
+}
+
+}  // namespace bench
+}  // namespace mybplus
+
+int main(int argc, char **argv) {
+  using mybplus::bench::Usage;
+  mybplus::bench::Options options;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    size_t eq = arg.find('=');
+    if (arg.compare(0, 2, "--") != 0 || eq == std::string::npos) {
+      return Usage();
+    }
+    std::string name = arg.substr(2, eq - 2);
+    std::string value = arg.substr(eq + 1);
+    if (name == "keys") {
+      options.keys = std::strtoull(value.c_str(), nullptr, 10);
+    } else if (name == "seed") {
+      options.seed = std::strtoull(value.c_str(), nullptr, 10);
+    } else {
+      return Usage();
+    }
+  }
+  if (options.keys == 0) {
+    return Usage();
+  }
+  return mybplus::bench::Run(options) ? 0 : 1;
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <random>
+
+namespace mybplus {
+namespace bench {
+
+/**
+ * Zipfian ranks over [0, items) following Gray et al., "Quickly Generating Billion-Record
+ * Synthetic Databases", as used by YCSB: rank 0 is the most popular and theta (0 < theta < 1)
+ * sets the skew. The item count may grow between calls (the "latest" distribution); zeta is then
+ * extended incrementally instead of being recomputed.
+ */
+class ZipfianGenerator {
+ public:
+  ZipfianGenerator(uint64_t items, double theta)
+      : theta_(theta), alpha_(1.0 / (1.0 - theta)), zeta2_(Zeta(0, 2, theta, 0.0)) {
+    SetItems(items);
+  }
+
+  auto Next(std::mt19937_64 &rng) -> uint64_t { return Next(rng, items_); }
+  auto Next(std::mt19937_64 &rng, uint64_t items) -> uint64_t {
+    if (items != items_) {
+      SetItems(items);
+    }
+    double u = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+    double uz = u * zetan_;
+    if (uz < 1.0) {
+      return 0;
+    }
+    if (uz < 1.0 + std::pow(0.5, theta_)) {
+      return 1;
+    }
+    auto rank = static_cast<uint64_t>(items_ * std::pow(eta_ * u - eta_ + 1.0, alpha_));
+    return rank < items_ ? rank : items_ - 1;
+  }
+
+ private:
+  static auto Zeta(uint64_t from, uint64_t to, double theta, double initial) -> double {
+    double sum = initial;
+    for (uint64_t i = from; i < to; i++) {
+      sum += 1.0 / std::pow(static_cast<double>(i + 1), theta);
+    }
+    return sum;
+  }
+
+  auto SetItems(uint64_t items) -> void {
+    // 只增长时在原来的 zeta 上累加
+    zetan_ = items > items_ ? Zeta(items_, items, theta_, zetan_) : Zeta(0, items, theta_, 0.0);
+    items_ = items;
+    eta_ = (1.0 - std::pow(2.0 / items_, 1.0 - theta_)) / (1.0 - zeta2_ / zetan_);
+  }
+
+  double theta_;
+  double alpha_;
+  double zeta2_;
+  uint64_t items_ = 0;
+  double zetan_ = 0.0;
+  double eta_ = 0.0;
+};
+
+enum class KeyDistribution { UNIFORM, ZIPFIAN, LATEST, HOTSPOT };
+
+/**
+ * Chooses existing keys in [0, count) under one of the YCSB request distributions. Zipfian ranks
+ * are scrambled through a hash so the hot keys are spread over the key space; "latest" makes the
+ * most recently inserted keys (the largest ones) the most popular; "hotspot" sends hot_op_fraction
+ * of the requests uniformly into the first hot_set_fraction of the keys. Each thread should own
+ * a copy.
+ */
+class KeyChooser {
+ public:
+  KeyChooser(KeyDistribution distribution, uint64_t items, double theta, double hot_set_fraction,
+             double hot_op_fraction)
+      : distribution_(distribution),
+        zipfian_(items, theta),
+        hot_set_fraction_(hot_set_fraction),
+        hot_op_fraction_(hot_op_fraction) {}
+
+  auto Next(std::mt19937_64 &rng, uint64_t count) -> uint64_t {
+    switch (distribution_) {
+      case KeyDistribution::ZIPFIAN:
+        return Fnv1a(zipfian_.Next(rng)) % count;
+      case KeyDistribution::LATEST:
+        return count - 1 - zipfian_.Next(rng, count);
+      case KeyDistribution::HOTSPOT: {
+        auto hot = static_cast<uint64_t>(count * hot_set_fraction_);
+        hot = hot == 0 ? 1 : hot;
+        if (hot >= count || std::uniform_real_distribution<double>(0.0, 1.0)(rng) <
+                                hot_op_fraction_) {
+          return std::uniform_int_distribution<uint64_t>(0, hot - 1)(rng);
+        }
+        return std::uniform_int_distribution<uint64_t>(hot, count - 1)(rng);
+      }
+      default:
+        return std::uniform_int_distribution<uint64_t>(0, count - 1)(rng);
+    }
+  }
+
+ private:
+  static auto Fnv1a(uint64_t value) -> uint64_t {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (int i = 0; i < 8; i++) {
+      hash ^= value & 0xff;
+      hash *= 0x100000001b3ULL;
+      value >>= 8;
+    }
+    return hash;
+  }
+
+  KeyDistribution distribution_;
+  ZipfianGenerator zipfian_;
+  double hot_set_fraction_;
+  double hot_op_fraction_;
+};
+
+}  // namespace bench
+}  // namespace mybplus
@@ -0,0 +1,417 @@
+// YCSB core workloads A-F against BPlusTree.
+//
+//   ycsb_bplustree [--workload=A..F, several letters run in turn, default A]
+//                  [--distribution=uniform|zipfian|latest|hotspot] [--theta=0.99]
+//                  [--hot_set=0.2] [--hot_ops=0.8] [--records=1000000] [--operations=1000000]
+//                  [--threads=1] [--rate=0 (ops/s over all threads, 0 = unthrottled)]
+//                  [--scan_max=100] [--api=cpp|c]
+//
+// Without --distribution each workload uses its YCSB default (latest for D, zipfian otherwise).
+// Every workload starts from a freshly loaded tree of --records keys. With --rate each thread
+// issues its operations on a fixed schedule and latency is measured from the scheduled start,
+// so a stalled operation also charges the ones queued behind it (no coordinated omission).
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "b_plus_tree.h"
+#include "b_plus_tree_wrapper.h"
+#include "config.h"
+#include "workload_generators.h"
+
+namespace mybplus {
+namespace bench {
+
+enum class YcsbOp { READ = 0, UPDATE, INSERT, SCAN, READ_MODIFY_WRITE, COUNT };
+constexpr int kYcsbOpCount = static_cast<int>(YcsbOp::COUNT);
+const char *const kYcsbOpNames[kYcsbOpCount] = {"read", "update", "insert", "scan", "rmw"};
+constexpr std::chrono::microseconds kSpinWindow(200);
+
+struct Workload {
+  char name;
+  std::array<double, kYcsbOpCount> mix;  // 各操作所占比例
+  KeyDistribution distribution;
+};
+
+const Workload kWorkloads[] = {
+    {'A', {0.5, 0.5, 0, 0, 0}, KeyDistribution::ZIPFIAN},
+    {'B', {0.95, 0.05, 0, 0, 0}, KeyDistribution::ZIPFIAN},
+    {'C', {1.0, 0, 0, 0, 0}, KeyDistribution::ZIPFIAN},
+    {'D', {0.95, 0, 0.05, 0, 0}, KeyDistribution::LATEST},
+    {'E', {0, 0, 0.05, 0.95, 0}, KeyDistribution::ZIPFIAN},
+    {'F', {0.5, 0, 0, 0, 0.5}, KeyDistribution::ZIPFIAN},
+};
+
+struct Options {
+  std::string workloads = "A";
+  std::string distribution;  // 为空时使用负载的默认分布
+  double theta = 0.99;
+  double hot_set = 0.2;
+  double hot_ops = 0.8;
+  uint64_t records = 1000000;
+  uint64_t operations = 1000000;
+  int threads = 1;
+  double rate = 0;
+  int scan_max = 100;
+  std::string api = "cpp";
+};
+
+auto MakeValue(KeyType key, uint64_t version) -> ValueType {
+  ValueType value{};
+  std::memcpy(value.data(), &key, sizeof(key));
+  std::memcpy(value.data() + sizeof(key), &version, sizeof(version));
+  return value;
+}
+
+// 被测接口
+class Store {
+ public:
+  virtual ~Store() = default;
+  virtual auto Load(uint64_t records) -> void = 0;
+  virtual auto Read(KeyType key) -> bool = 0;
+  virtual auto Update(KeyType key, const ValueType &value) -> bool = 0;
+  virtual auto Insert(KeyType key, const ValueType &value) -> bool = 0;
+  virtual auto Scan(KeyType key, int length) -> int = 0;
+};
+
+class CppStore : public Store {
+ public:
+  CppStore() : tree_("ycsb_tree", KeyComparator()) {}
+
+  auto Load(uint64_t records) -> void override {
+    tree_.BeginBulkLoad(records);
+    for (uint64_t i = 0; i < records; i++) {
+      tree_.BulkLoadAppend(i, MakeValue(i, 0));
+    }
+    tree_.FinishBulkLoad();
+  }
+  auto Read(KeyType key) -> bool override {
+    ValueType result;
+    return tree_.GetValue(key, &result);
+  }
+  auto Update(KeyType key, const ValueType &value) -> bool override {
+    return tree_.Update(key, value);
+  }
+  auto Insert(KeyType key, const ValueType &value) -> bool override {
+    return tree_.Insert(key, value);
+  }
+  auto Scan(KeyType key, int length) -> int override {
+    thread_local std::vector<std::pair<KeyType, ValueType>> entries;
+    entries.clear();
+    return static_cast<int>(tree_.Scan(key, length, &entries));
+  }
+
+ private:
+  BPlusTree<KeyType, ValueType, KeyComparator> tree_;
+};
+
+// 通过 b_plus_tree_wrapper.h 的 C 接口访问，包含值的转换开销
+class CStore : public Store {
+ public:
+  CStore() : tree_(bpt_create(LEAF_PAGE_SIZE, INTERNAL_PAGE_SIZE)) {}
+  ~CStore() override { bpt_destroy(tree_); }
+
+  auto Load(uint64_t records) -> void override {
+    constexpr int kBatch = 1024;
+    std::vector<KeyType> keys(kBatch);
+    std::vector<::ValueType> values(kBatch);
+    bpt_bulk_load_begin(tree_, records, 1.0);
+    for (uint64_t start = 0; start < records; start += kBatch) {
+      int count = static_cast<int>(std::min<uint64_t>(kBatch, records - start));
+      for (int i = 0; i < count; i++) {
+        keys[i] = start + i;
+        values[i] = ToC(MakeValue(keys[i], 0));
+      }
+      bpt_bulk_load_append(tree_, keys.data(), values.data(), count);
+    }
+    bpt_bulk_load_finish(tree_);
+  }
+  auto Read(KeyType key) -> bool override {
+    ::ValueType value;
+    return bpt_get_value(tree_, key, &value);
+  }
+  auto Update(KeyType key, const ValueType &value) -> bool override {
+    return bpt_update(tree_, key, ToC(value));
+  }
+  auto Insert(KeyType key, const ValueType &value) -> bool override {
+    return bpt_insert(tree_, key, ToC(value));
+  }
+  auto Scan(KeyType key, int length) -> int override {
+    thread_local std::vector<KeyType> keys;
+    thread_local std::vector<::ValueType> values;
+    keys.resize(length);
+    values.resize(length);
+    return bpt_scan(tree_, key, length, keys.data(), values.data());
+  }
+
+ private:
+  static auto ToC(const ValueType &value) -> ::ValueType {
+    ::ValueType c_value;
+    std::memcpy(c_value.data, value.data(), sizeof(c_value.data));
+    return c_value;
+  }
+
+  CBPlusTree *tree_;
+};
+
+struct ThreadResult {
+  std::array<HistogramSnapshot, kYcsbOpCount> latency;
+  uint64_t misses = 0;  // 没有找到键的读取或更新
+};
+
+auto ParseDistribution(const std::string &name, KeyDistribution *distribution) -> bool {
+  if (name == "uniform") {
+    *distribution = KeyDistribution::UNIFORM;
+  } else if (name == "zipfian") {
+    *distribution = KeyDistribution::ZIPFIAN;
+  } else if (name == "latest") {
+    *distribution = KeyDistribution::LATEST;
+  } else if (name == "hotspot") {
+    *distribution = KeyDistribution::HOTSPOT;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+auto DistributionName(KeyDistribution distribution) -> const char * {
+  switch (distribution) {
+    case KeyDistribution::ZIPFIAN:
+      return "zipfian";
+    case KeyDistribution::LATEST:
+      return "latest";
+    case KeyDistribution::HOTSPOT:
+      return "hotspot";
+    default:
+      return "uniform";
+  }
+}
+
+auto RunWorkload(const Options &options, const Workload &workload,
+                 KeyDistribution distribution) -> void {
+  std::unique_ptr<Store> store;
+  if (options.api == "c") {
+    store = std::make_unique<CStore>();
+  } else {
+    store = std::make_unique<CppStore>();
+  }
+  store->Load(options.records);
+
+  // 已经存在的键为 [0, key_count)，插入的键依次递增
+  std::atomic<uint64_t> next_insert{options.records};
+  std::atomic<uint64_t> key_count{options.records};
+  std::atomic<bool> start{false};
+  KeyChooser prototype(distribution, options.records, options.theta, options.hot_set,
+                       options.hot_ops);
+  std::vector<ThreadResult> results(options.threads);
+  std::vector<std::thread> threads;
+  uint64_t ops_per_thread = options.operations / options.threads;
+  auto interval = options.rate > 0 ? std::chrono::nanoseconds(static_cast<int64_t>(
+                                         1e9 * options.threads / options.rate))
+                                   : std::chrono::nanoseconds(0);
+
+  for (int t = 0; t < options.threads; t++) {
+    threads.emplace_back([&, t]() {
+      std::mt19937_64 rng(t + 1);
+      std::uniform_real_distribution<double> uniform(0.0, 1.0);
+      std::uniform_int_distribution<int> scan_length(1, options.scan_max);
+      KeyChooser chooser = prototype;
+      ThreadResult &result = results[t];
+      while (!start.load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+      }
+      auto begin = std::chrono::steady_clock::now();
+      for (uint64_t i = 0; i < ops_per_thread; i++) {
+        auto op_start = std::chrono::steady_clock::now();
+        if (interval.count() > 0) {
+          auto scheduled = begin + interval * i;
+          // 睡眠会多睡几十微秒，最后一段忙等，避免把睡眠误差计入延迟
+          if (scheduled - op_start > kSpinWindow) {
+            std::this_thread::sleep_until(scheduled - kSpinWindow);
+          }
+          while (std::chrono::steady_clock::now() < scheduled) {
+            std::this_thread::yield();
+          }
+          op_start = scheduled;
+        }
+
+        double dice = uniform(rng);
+        int op = 0;
+        while (op < kYcsbOpCount - 1 && dice >= workload.mix[op]) {
+          dice -= workload.mix[op];
+          op++;
+        }
+        bool found = true;
+        switch (static_cast<YcsbOp>(op)) {
+          case YcsbOp::READ:
+            found = store->Read(chooser.Next(rng, key_count.load(std::memory_order_relaxed)));
+            break;
+          case YcsbOp::UPDATE: {
+            KeyType key = chooser.Next(rng, key_count.load(std::memory_order_relaxed));
+            found = store->Update(key, MakeValue(key, i + 1));
+            break;
+          }
+          case YcsbOp::INSERT: {
+            KeyType key = next_insert.fetch_add(1, std::memory_order_relaxed);
+            store->Insert(key, MakeValue(key, 0));
+            // 插入完成后才对读取可见；并发插入乱序完成时取最大值
+            uint64_t count = key_count.load(std::memory_order_relaxed);
+            while (count < static_cast<uint64_t>(key) + 1 &&
+                   !key_count.compare_exchange_weak(count, key + 1, std::memory_order_relaxed)) {
+            }
+            break;
+          }
+          case YcsbOp::SCAN:
+            store->Scan(chooser.Next(rng, key_count.load(std::memory_order_relaxed)),
+                        scan_length(rng));
+            break;
+          default: {
+            KeyType key = chooser.Next(rng, key_count.load(std::memory_order_relaxed));
+            found = store->Read(key) && store->Update(key, MakeValue(key, i + 1));
+            break;
+          }
+        }
+        result.misses += found ? 0 : 1;
+        auto elapsed = std::chrono::steady_clock::now() - op_start;
+        result.latency[op].Record(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+      }
+    });
+  }
+
+  auto begin = std::chrono::steady_clock::now();
+  start.store(true, std::memory_order_release);
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+  ThreadResult total;
+  for (const auto &result : results) {
+    for (int op = 0; op < kYcsbOpCount; op++) {
+      total.latency[op].Merge(result.latency[op]);
+    }
+    total.misses += result.misses;
+  }
+  uint64_t done = ops_per_thread * options.threads;
+
+  std::cout << std::defaultfloat << std::setprecision(6) << "workload " << workload.name << "  distribution "
+            << DistributionName(distribution);
+  if (distribution == KeyDistribution::ZIPFIAN || distribution == KeyDistribution::LATEST) {
+    std::cout << "(theta=" << options.theta << ")";
+  } else if (distribution == KeyDistribution::HOTSPOT) {
+    std::cout << "(" << options.hot_ops * 100 << "% ops on " << options.hot_set * 100
+              << "% keys)";
+  }
+  std::cout << "  api " << options.api << "  threads " << options.threads << "\n"
+            << "records " << options.records << "  operations " << done << "  target ";
+  if (options.rate > 0) {
+    std::cout << options.rate << " ops/s\n";
+  } else {
+    std::cout << "unthrottled\n";
+  }
+  std::cout << "throughput " << std::fixed << std::setprecision(0) << done / seconds
+            << " ops/s  elapsed " << std::setprecision(3) << seconds << " s  misses "
+            << total.misses << "\n";
+  std::cout << std::left << std::setw(8) << "op" << std::right << std::setw(12) << "count"
+            << std::setw(12) << "mean(ns)" << std::setw(10) << "p50" << std::setw(10) << "p95"
+            << std::setw(10) << "p99" << std::setw(10) << "p999" << std::setw(12) << "max"
+            << "\n";
+  for (int op = 0; op < kYcsbOpCount; op++) {
+    const HistogramSnapshot &h = total.latency[op];
+    if (h.count == 0) {
+      continue;
+    }
+    std::cout << std::left << std::setw(8) << kYcsbOpNames[op] << std::right << std::setw(12)
+              << h.count << std::setw(12) << std::setprecision(1) << h.Mean() << std::setw(10)
+              << h.Percentile(0.5) << std::setw(10) << h.Percentile(0.95) << std::setw(10)
+              << h.Percentile(0.99) << std::setw(10) << h.Percentile(0.999) << std::setw(12)
+              << h.max << "\n";
+  }
+  std::cout << std::endl;
+}
+
+auto Usage() -> int {
+  std::cerr << "usage: ycsb_bplustree [--workload=ABCDEF] "
+               "[--distribution=uniform|zipfian|latest|hotspot] [--theta=0.99] "
+               "[--hot_set=0.2] [--hot_ops=0.8] [--records=N] [--operations=N] [--threads=N] "
+               "[--rate=OPS] [--scan_max=N] [--api=cpp|c]\n";
+  return 1;
+}
+
+}  // namespace bench
+}  // namespace mybplus
+
+int main(int argc, char **argv) {
+  using mybplus::bench::Usage;
+  mybplus::bench::Options options;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    size_t eq = arg.find('=');
+    if (arg.compare(0, 2, "--") != 0 || eq == std::string::npos) {
+      return Usage();
+    }
+    std::string name = arg.substr(2, eq - 2);
+    std::string value = arg.substr(eq + 1);
+    if (name == "workload") {
+      options.workloads = value;
+    } else if (name == "distribution") {
+      options.distribution = value;
+    } else if (name == "theta") {
+      options.theta = std::strtod(value.c_str(), nullptr);
+    } else if (name == "hot_set") {
+      options.hot_set = std::strtod(value.c_str(), nullptr);
+    } else if (name == "hot_ops") {
+      options.hot_ops = std::strtod(value.c_str(), nullptr);
+    } else if (name == "records") {
+      options.records = std::strtoull(value.c_str(), nullptr, 10);
+    } else if (name == "operations") {
+      options.operations = std::strtoull(value.c_str(), nullptr, 10);
+    } else if (name == "threads") {
+      options.threads = std::atoi(value.c_str());
+    } else if (name == "rate") {
+      options.rate = std::strtod(value.c_str(), nullptr);
+    } else if (name == "scan_max") {
+      options.scan_max = std::atoi(value.c_str());
+    } else if (name == "api") {
+      options.api = value;
+    } else {
+      return Usage();
+    }
+  }
+  if (options.threads < 1 || options.records < 2 || options.scan_max < 1 ||
+      options.theta <= 0 || options.theta >= 1 || (options.api != "cpp" && options.api != "c")) {
+    return Usage();
+  }
+
+  for (char letter : options.workloads) {
+    const mybplus::bench::Workload *workload = nullptr;
+    for (const auto &candidate : mybplus::bench::kWorkloads) {
+      if (candidate.name == std::toupper(letter)) {
+        workload = &candidate;
+      }
+    }
+    if (workload == nullptr) {
+      return Usage();
+    }
+    mybplus::bench::KeyDistribution distribution = workload->distribution;
+    if (!options.distribution.empty() &&
+        !mybplus::bench::ParseDistribution(options.distribution, &distribution)) {
+      return Usage();
+    }
+    mybplus::bench::RunWorkload(options, *workload, distribution);
+  }
+  return 0;
+}
@@ -4,16 +4,18 @@
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <thread>
 
 namespace mybplus {
 
 INDEX_TEMPLATE_ARGUMENTS
 BPLUSTREE_TYPE::BPlusTree(std::string name, const KeyComparator &comparator, int leaf_max_size,
-                          int internal_max_size)
+                          int internal_max_size, ConcurrencyMode mode)
     : index_name_(std::move(name)),
       comparator_(comparator),
       leaf_max_size_(leaf_max_size),
-      internal_max_size_(internal_max_size) {
+      internal_max_size_(internal_max_size),
+      mode_(mode) {
   root_page_id_ = INVALID_PAGE_ID;
 }
 
@@ -25,7 +27,12 @@ auto BPLUSTREE_TYPE::IsEmpty() const -> bool {
 
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::GetPage(page_id_t page_id) -> BPlusTreePage * {
-  std::lock_guard<std::mutex> lock(pages_mutex_);
+  // 其他模式下树的操作不会并发；并行反序列化注册页面时直接使用 CreateAndRegisterPage 的返回值，
+  // 不会在注册的同时调用 GetPage
+  std::unique_lock<std::mutex> lock(pages_mutex_, std::defer_lock);
+  if (UsesLatches()) {
+    lock.lock();
+  }
   auto it = pages_.find(page_id);
   if (it == pages_.end()) {
     return nullptr;
@@ -42,6 +49,7 @@ auto BPLUSTREE_TYPE::NewPage(page_id_t *page_id) -> BPlusTreePage * {
   page->SetPageId(*page_id);
 
   pages_[*page_id] = page;
+  metrics_.Increment(MetricCounter::PAGE_ALLOC);
   return page;
 }
 
@@ -54,6 +62,8 @@ auto BPLUSTREE_TYPE::NewLeafPage(page_id_t *new_page_id) -> LeafPage * {
   leaf_page->Init(leaf_max_size_);
   // leaf_page->SetMaxSize(leaf_max_size_);
   pages_[*new_page_id] = leaf_page;
+  metrics_.Increment(MetricCounter::PAGE_ALLOC);
+  stat_leaf_pages_.fetch_add(1, std::memory_order_relaxed);
   return leaf_page;
 }
 
@@ -66,6 +76,8 @@ auto BPLUSTREE_TYPE::NewInternalPage(page_id_t *new_page_id) -> InternalPage * {
   internal_page->Init(internal_max_size_);
   // internal_page->SetMaxSize(internal_max_size_);
   pages_[*new_page_id] = internal_page;
+  metrics_.Increment(MetricCounter::PAGE_ALLOC);
+  stat_internal_pages_.fetch_add(1, std::memory_order_relaxed);
   return internal_page;
 }
 
@@ -74,9 +86,22 @@ void BPLUSTREE_TYPE::DeletePage(page_id_t page_id) {
   std::lock_guard<std::mutex> lock(pages_mutex_);
   auto it = pages_.find(page_id);
   if (it != pages_.end()) {
-    delete it->second;
-    // std::cout << "Delete page: " << page_id << std::endl;
+    (it->second->IsLeafPage() ? stat_leaf_pages_ : stat_internal_pages_)
+        .fetch_sub(1, std::memory_order_relaxed);
+    BPlusTreePage *page = it->second;
     pages_.erase(it);
+    metrics_.Increment(MetricCounter::PAGE_FREE);
+    // 先让记录的叶子失效再退休页面，仍持有旧代数的操作在页面回收之前就已经进入了 epoch
+    if (page->IsLeafPage()) {
+      InvalidateCachedLeaves();
+      hash_index_.InvalidateLeaf(page);
+    }
+    if (UsesLatches()) {
+      // 其他线程（包括调用方自己的锁）可能仍引用该页面，推迟到无人可见时释放
+      epoch_.Retire(page, [](void *p) { delete static_cast<BPlusTreePage *>(p); });
+    } else {
+      delete page;
+    }
   }
 }
 
@@ -86,12 +111,47 @@ void BPLUSTREE_TYPE::DeletePage(page_id_t page_id) {
 
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result) -> bool {
-#ifdef USING_CRABBING_PROTOCOL
+  ValueType value;
+  if (!GetValue(key, &value)) {
+    return false;
+  }
+  result->emplace_back(value);
+  return true;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::GetValue(const KeyType &key) -> std::optional<ValueType> {
+  ValueType value;
+  if (!GetValue(key, &value)) {
+    return std::nullopt;
+  }
+  return value;
+}
 
-#else
-  std::unique_lock<std::shared_mutex> lock(mutex_);
-#endif
-  Context ctx(mutex_);
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::GetValue(const KeyType &key, ValueType *value) -> bool {
+  ScopedLatency latency(metrics_, MetricOp::GET);
+  Trace(TraceOp::GET, key);
+  auto tree_lock = SharedTreeLock();
+  EpochGuard epoch_guard(epoch_, UsesLatches());
+  if (hash_index_.IsEnabled() && TryHashIndex(key, value)) {
+    return true;
+  }
+  if (LeafPage *leaf_page = FingerLeaf(key); leaf_page != nullptr) {
+    if (UsesLatches()) {
+      leaf_page->RLock();
+    }
+    bool hit = FingerStillValid(leaf_page);
+    bool found = hit && leaf_page->FindValue(key, comparator_, *value, nullptr);
+    if (UsesLatches()) {
+      leaf_page->RUnlock();
+    }
+    if (hit) {
+      metrics_.Increment(MetricCounter::FINGER_HIT);
+      return found;
+    }
+  }
+  Context ctx(mutex_, ActiveLatchProfiler(), UsesLatches());
   ctx.RLockRoot();
   ctx.root_page_id_ = root_page_id_;
   if (ctx.root_page_id_ == INVALID_PAGE_ID) {
@@ -106,28 +166,169 @@ auto BPLUSTREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result
   }
 
   ctx.RPush(page);
+  // 根页面已经加锁，根不会再变化；持有根互斥量等待页面锁会与分裂根的写者死锁
+  ctx.RUnlockRoot();
+  bool track = IsFingerCacheEnabled();
+  KeyRange range;
   // 遍历到叶子节点
   while (!page->IsLeafPage()) {
     InternalPage *internal_page = static_cast<InternalPage *>(page);
-    page_id_t next_page_id = internal_page->FindValue(key, comparator_, nullptr);
-    page = GetPage(next_page_id);
+    int index = 0;
+    page = ResolveChild(internal_page->FindValue(key, comparator_, &index));
     if (!page) {
-      ctx.RUnlockRoot();
       return false;
     }
+    if (track) {
+      NarrowRange(internal_page, index, &range);
+    }
     ctx.RPush(page);
     // 蟹锁
-    ctx.CheckAndReleaseAncestors(page, OperationType::FIND);
+    ctx.RPopFront();
   }
-  ctx.RUnlockRoot();
   LeafPage *leaf_page = static_cast<LeafPage *>(page);
-  ValueType value;
-  if (leaf_page->FindValue(key, comparator_, value, nullptr)) {
-    result->emplace_back(value);
-    ctx.Clear();
-    return true;
+  if (track) {
+    SetFinger(leaf_page, range, false);
+  }
+  if (!hash_index_.IsEnabled()) {
+    return leaf_page->FindValue(key, comparator_, *value, nullptr);
   }
-  return false;
+  int index = -1;
+  bool found = leaf_page->FindValue(key, comparator_, *value, &index);
+  // 叶子经常被访问时把键的位置记入哈希索引；持有读锁，记录的版本在下一个写者解锁前不变
+  if (found && hash_index_.Touch(leaf_page)) {
+    hash_index_.Store(key, {leaf_page, index, UsesLatches() ? leaf_page->LatchVersion() : 0});
+  }
+  return found;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::TryHashIndex(const KeyType &key, ValueType *value) -> bool {
+  typename AdaptiveHashIndex<KeyType, KeyComparator>::Location location;
+  // Lookup 已经确认叶子没有被释放
+  if (!hash_index_.Lookup(key, &location)) {
+    return false;
+  }
+  auto *leaf_page = static_cast<LeafPage *>(location.leaf);
+  if (UsesLatches()) {
+    leaf_page->RLock();
+  }
+  // 加锁模式下版本不变说明叶子没有被写过；不加锁的模式下没有版本，确认槽位中仍是这个键
+  bool hit = (!UsesLatches() || leaf_page->LatchVersion() == location.version) &&
+             location.slot < leaf_page->GetSize() &&
+             comparator_(leaf_page->KeyAt(location.slot), key) == 0;
+  if (hit) {
+    *value = leaf_page->ValueAt(location.slot);
+  }
+  if (UsesLatches()) {
+    leaf_page->RUnlock();
+  }
+  if (hit) {
+    hash_index_.RecordHit();
+  }
+  return hit;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::FingerLeaf(const KeyType &key) -> LeafPage * {
+  if (!IsFingerCacheEnabled()) {
+    return nullptr;
+  }
+  const Finger &finger = LocalFinger();
+  // 调用方已经进入 epoch：代数未变说明记录之后叶子没有被释放，
+  // 之后才释放的页面要等本操作结束才会回收
+  if (finger.generation != leaf_generation_.load(std::memory_order_seq_cst)) {
+    return nullptr;
+  }
+  const KeyRange &range = finger.range;
+  if ((range.has_low && comparator_(key, range.low) < 0) ||
+      (range.has_high && comparator_(key, range.high) >= 0)) {
+    return nullptr;
+  }
+  return finger.leaf;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::SetFinger(LeafPage *leaf, const KeyRange &range, bool exclusive) -> void {
+  Finger &finger = LocalFinger();
+  // 持锁期间叶子不会被释放，之后只要代数不变叶子就仍在树上；叶子的范围只有在它本身被写时才会缩小，
+  // 加锁模式下用锁版本确认
+  finger.generation = leaf_generation_.load(std::memory_order_seq_cst);
+  finger.leaf = leaf;
+  finger.version = UsesLatches() ? leaf->LatchVersion() + (exclusive ? 1 : 0) : 0;
+  finger.range = range;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::Scan(const KeyType &start_key, size_t max_count,
+                          std::vector<std::pair<KeyType, ValueType>> *result) -> size_t {
+  ScopedLatency latency(metrics_, MetricOp::SCAN);
+  Trace(TraceOp::SCAN, start_key,
+        static_cast<uint32_t>(std::min<size_t>(max_count, UINT32_MAX)));
+  auto tree_lock = SharedTreeLock();
+  EpochGuard epoch_guard(epoch_, UsesLatches());
+  size_t found = 0;
+  KeyType from = start_key;
+  bool inclusive = true;  // 重新下降时跳过已经返回的最后一个键
+  while (found < max_count) {
+    Context ctx(mutex_, ActiveLatchProfiler(), UsesLatches());
+    ctx.RLockRoot();
+    if (root_page_id_ == INVALID_PAGE_ID) {
+      return found;
+    }
+    BPlusTreePage *page = GetPage(root_page_id_);
+    if (!page) {
+      return found;
+    }
+    ctx.RPush(page);
+    // 根页面已经加锁，根不会再变化，可以放开根互斥量
+    ctx.RUnlockRoot();
+    while (!page->IsLeafPage()) {
+      auto *internal_page = static_cast<InternalPage *>(page);
+      page = ResolveChild(internal_page->FindValue(from, comparator_, nullptr));
+      if (!page) {
+        return found;
+      }
+      ctx.RPush(page);
+      ctx.RPopFront();
+    }
+
+    auto *leaf_page = static_cast<LeafPage *>(page);
+    int index = leaf_page->KeyIndex(from, comparator_);
+    if (!inclusive && index < leaf_page->GetSize() &&
+        comparator_(leaf_page->KeyAt(index), from) == 0) {
+      index++;
+    }
+    bool restart = false;
+    while (!restart) {
+      for (; index < leaf_page->GetSize() && found < max_count; index++) {
+        result->emplace_back(leaf_page->KeyAt(index), leaf_page->ValueAt(index));
+        found++;
+      }
+      if (found == max_count || leaf_page->GetNextPageId() == INVALID_PAGE_ID) {
+        return found;
+      }
+      if (leaf_page->GetSize() > 0) {
+        from = leaf_page->KeyAt(leaf_page->GetSize() - 1);
+        inclusive = false;
+      }
+      auto *next_page = static_cast<LeafPage *>(GetPage(leaf_page->GetNextPageId()));
+      if (next_page == nullptr) {
+        return found;
+      }
+      // 持有当前叶子时只尝试加锁下一个叶子，失败则放开所有锁重新下降，避免与写者死锁
+      if (UsesLatches() && !next_page->TryRLock()) {
+        metrics_.Increment(MetricCounter::RESTART);
+        restart = true;
+        continue;
+      }
+      ctx.RPushLocked(next_page);
+      ctx.RPopFront();
+      leaf_page = next_page;
+      index = 0;
+    }
+    std::this_thread::yield();
+  }
+  return found;
 }
 
 /*****************************************************************************
@@ -136,11 +337,42 @@ auto BPLUSTREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result
 
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value) -> bool {
-#ifdef USING_CRABBING_PROTOCOL
-#else
-  std::unique_lock<std::shared_mutex> lock(mutex_);
-#endif
-  Context ctx(mutex_);
+  ScopedLatency latency(metrics_, MetricOp::INSERT);
+  Trace(TraceOp::INSERT, key);
+  auto tree_lock = ExclusiveTreeLock();
+  EpochGuard epoch_guard(epoch_, UsesLatches());
+  if (IsAppendMode() && TryAppend(key, value)) {
+    return true;
+  }
+  if (bool inserted = false; TryFingerInsert(key, value, &inserted)) {
+    return inserted;
+  }
+  bool track = IsFingerCacheEnabled();
+  // 乐观下降：内部页面只加读锁，叶子不需要分裂时直接插入
+  if (mode_ == ConcurrencyMode::OPTIMISTIC) {
+    Context ctx(mutex_, ActiveLatchProfiler(), UsesLatches());
+    KeyRange range;
+    LeafPage *leaf_page = FindLeafForWrite(key, &ctx, track ? &range : nullptr);
+    if (leaf_page != nullptr) {
+      if (track) {
+        SetFinger(leaf_page, range, true);
+      }
+      ValueType existing_value;
+      if (leaf_page->FindValue(key, comparator_, existing_value, nullptr)) {
+        return false;
+      }
+      if (leaf_page->IsSafe(OperationType::INSERT)) {
+        leaf_page->Insert(key, value, comparator_);
+        stat_keys_.fetch_add(1, std::memory_order_relaxed);
+        RememberRightmostLeaf(leaf_page);
+        return true;
+      }
+      metrics_.Increment(MetricCounter::RESTART);
+    }
+  }
+
+  // 叶子需要分裂（或树为空），从根开始加写锁重新下降
+  Context ctx(mutex_, ActiveLatchProfiler(), UsesLatches());
   ctx.WLockRoot();
   ctx.root_page_id_ = root_page_id_;
 
@@ -153,6 +385,9 @@ auto BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value) -> bool
     new_leaf_page->Insert(key, value, comparator_);
     root_page_id_ = new_page_id;
     ctx.root_page_id_ = new_page_id;
+    stat_keys_.fetch_add(1, std::memory_order_relaxed);
+    stat_height_.store(1, std::memory_order_relaxed);
+    RememberRightmostLeaf(new_leaf_page);
     return true;
   }
 
@@ -160,55 +395,133 @@ auto BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value) -> bool
   BPlusTreePage *page = GetPage(ctx.root_page_id_);
   ctx.WPush(page);
 
+  KeyRange range;
   while (!page->IsLeafPage()) {
     InternalPage *internal_page = static_cast<InternalPage *>(page);
-    page_id_t next_page_id = internal_page->FindValue(key, comparator_, nullptr);
-    page = GetPage(next_page_id);
+    int index = 0;
+    page = ResolveChild(internal_page->FindValue(key, comparator_, &index));
     if (!page) {
       ctx.Clear();
       return false;  // 页面不存在
     }
+    if (track) {
+      NarrowRange(internal_page, index, &range);
+    }
     ctx.WPush(page);
     // 蟹锁
     ctx.CheckAndReleaseAncestors(page, OperationType::INSERT);
   }
   LeafPage *leaf_page = static_cast<LeafPage *>(page);
-  // REVIEW - 如果在得到子页面之前就解锁根页面会降低性能？
-  ctx.WUnlockRoot();
   ValueType existing_value;
   int existing_index = -1;
   if (leaf_page->FindValue(key, comparator_, existing_value, &existing_index)) {
+    if (track) {
+      SetFinger(leaf_page, range, true);
+    }
     ctx.Clear();
     return false;
   }
 
   // 如果页面有足够空间，直接插入
   if (leaf_page->IsSafe(OperationType::INSERT)) {
+    if (track) {
+      SetFinger(leaf_page, range, true);
+    }
     bool result = leaf_page->Insert(key, value, comparator_);
+    if (result) {
+      stat_keys_.fetch_add(1, std::memory_order_relaxed);
+      RememberRightmostLeaf(leaf_page);
+    }
     ctx.Clear();
     return result;
   }
 
-  // 页面需要分裂
+  // 页面需要分裂；在最右叶子末尾追加时旧页面保持满，新页面只放新键
+  bool append = IsAppendMode() && leaf_page->GetNextPageId() == INVALID_PAGE_ID &&
+                comparator_(key, leaf_page->KeyAt(leaf_page->GetSize() - 1)) > 0;
   page_id_t new_page_id;
   LeafPage *new_leaf_page = NewLeafPage(&new_page_id);
   if (!new_leaf_page) {
     return false;
   }
-  KeyType new_key = SplitLeafPage(leaf_page, new_leaf_page, key, value, new_page_id);
-  if (comparator_(KeyType(), new_key) == 0) {
-    DeletePage(new_page_id);
-    return false;
-  }
+  KeyType new_key = SplitLeafPage(leaf_page, new_leaf_page, key, value, new_page_id, append);
+  metrics_.Increment(MetricCounter::LEAF_SPLIT);
+  stat_keys_.fetch_add(1, std::memory_order_relaxed);
+  RememberRightmostLeaf(new_leaf_page);
 
   // 插入到父节点
   ctx.WPopBack();
-  return InsertIntoParent(leaf_page, new_key, new_leaf_page, &ctx);
+  return InsertIntoParent(leaf_page, new_key, new_leaf_page, &ctx, append);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::TryAppend(const KeyType &key, const ValueType &value) -> bool {
+  // 页面由 epoch 保护，即使缓存的叶子已被删除，指针仍然可以访问
+  LeafPage *leaf_page = rightmost_leaf_.load(std::memory_order_acquire);
+  if (leaf_page == nullptr) {
+    return false;
+  }
+  if (UsesLatches()) {
+    leaf_page->WLock();
+  }
+  // 加锁后确认：仍是缓存的页面（离开树的叶子会在持锁时移出缓存）、仍是最右叶子、
+  // key 大于页面中所有键并且插入后不需要分裂
+  bool appended = rightmost_leaf_.load(std::memory_order_relaxed) == leaf_page &&
+                  leaf_page->GetNextPageId() == INVALID_PAGE_ID && leaf_page->GetSize() > 0 &&
+                  comparator_(key, leaf_page->KeyAt(leaf_page->GetSize() - 1)) > 0 &&
+                  leaf_page->IsSafe(OperationType::INSERT);
+  if (appended) {
+    leaf_page->Insert(key, value, comparator_);
+    stat_keys_.fetch_add(1, std::memory_order_relaxed);
+    metrics_.Increment(MetricCounter::APPEND_HIT);
+  }
+  if (UsesLatches()) {
+    leaf_page->Unlock();
+  }
+  return appended;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::TryFingerInsert(const KeyType &key, const ValueType &value, bool *inserted)
+    -> bool {
+  LeafPage *leaf_page = FingerLeaf(key);
+  if (leaf_page == nullptr) {
+    return false;
+  }
+  if (UsesLatches()) {
+    leaf_page->WLock();
+  }
+  bool handled = FingerStillValid(leaf_page);
+  if (handled) {
+    ValueType existing_value;
+    if (leaf_page->FindValue(key, comparator_, existing_value, nullptr)) {
+      *inserted = false;
+    } else if (leaf_page->IsSafe(OperationType::INSERT)) {
+      leaf_page->Insert(key, value, comparator_);
+      stat_keys_.fetch_add(1, std::memory_order_relaxed);
+      RememberRightmostLeaf(leaf_page);
+      *inserted = true;
+    } else {
+      handled = false;
+    }
+    // 叶子的范围没有变化，只是解锁后版本加一
+    if (UsesLatches()) {
+      LocalFinger().version = leaf_page->LatchVersion() + 1;
+    }
+  }
+  if (UsesLatches()) {
+    leaf_page->Unlock();
+  }
+  if (handled) {
+    metrics_.Increment(MetricCounter::FINGER_HIT);
+  }
+  return handled;
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::InsertIntoParent(BPlusTreePage *old_node, const KeyType &key,
-                                      BPlusTreePage *new_node, Context *ctx) -> bool {
+                                      BPlusTreePage *new_node, Context *ctx, bool append)
+    -> bool {
   // 如果旧节点是根节点
   if (old_node->GetPageId() == ctx->root_page_id_) {
     ctx->WLockRoot();
@@ -220,10 +533,12 @@ auto BPLUSTREE_TYPE::InsertIntoParent(BPlusTreePage *old_node, const KeyType &ke
 
     new_internal_page->SetPageId(new_page_id);
     new_internal_page->Init(internal_max_size_);
-    new_internal_page->PopulateNewRoot(old_node->GetPageId(), key, new_node->GetPageId());
+    new_internal_page->PopulateNewRoot(ChildRef::FromPage(old_node), key,
+                                       ChildRef::FromPage(new_node));
 
     ctx->root_page_id_ = new_page_id;
     root_page_id_ = new_page_id;
+    stat_height_.fetch_add(1, std::memory_order_relaxed);
     return true;
   }
 
@@ -233,7 +548,7 @@ auto BPLUSTREE_TYPE::InsertIntoParent(BPlusTreePage *old_node, const KeyType &ke
 
   // 如果父页面有足够空间，直接插入
   if (parent_page->IsSafe(OperationType::INSERT)) {
-    parent_internal->Insert(key, new_node->GetPageId(), comparator_);
+    parent_internal->Insert(key, ChildRef::FromPage(new_node), comparator_);
     return true;
   }
 
@@ -247,11 +562,71 @@ auto BPLUSTREE_TYPE::InsertIntoParent(BPlusTreePage *old_node, const KeyType &ke
   new_internal_page->Init(internal_max_size_);
   new_internal_page->SetPageId(new_page_id);
 
-  KeyType middle_key =
-      SplitInternalPage(parent_internal, new_internal_page, key, new_node->GetPageId());
+  KeyType middle_key = SplitInternalPage(parent_internal, new_internal_page, key,
+                                         ChildRef::FromPage(new_node), append);
+  metrics_.Increment(MetricCounter::INTERNAL_SPLIT);
   ctx->WPopBack();
 
-  return InsertIntoParent(parent_internal, middle_key, new_internal_page, ctx);
+  return InsertIntoParent(parent_internal, middle_key, new_internal_page, ctx, append);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::Update(const KeyType &key, const ValueType &value) -> bool {
+  ScopedLatency latency(metrics_, MetricOp::UPDATE);
+  Trace(TraceOp::UPDATE, key);
+  auto tree_lock = ExclusiveTreeLock();
+  EpochGuard epoch_guard(epoch_, UsesLatches());
+  // 结构不变，内部页面只加读锁，叶子页面加写锁
+  Context ctx(mutex_, ActiveLatchProfiler(), UsesLatches());
+  LeafPage *leaf_page = FindLeafForWrite(key, &ctx);
+  if (leaf_page == nullptr) {
+    return false;
+  }
+  ValueType old_value;
+  int index = -1;
+  if (!leaf_page->FindValue(key, comparator_, old_value, &index)) {
+    return false;
+  }
+  leaf_page->SetAt(index, key, value);
+  return true;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::FindLeafForWrite(const KeyType &key, Context *ctx, KeyRange *range)
+    -> LeafPage * {
+  ctx->RLockRoot();
+  if (root_page_id_ == INVALID_PAGE_ID) {
+    return nullptr;
+  }
+  BPlusTreePage *page = GetPage(root_page_id_);
+  if (!page) {
+    return nullptr;
+  }
+  if (page->IsLeafPage()) {
+    ctx->WPush(page);
+  } else {
+    ctx->RPush(page);
+  }
+  ctx->RUnlockRoot();
+  while (!page->IsLeafPage()) {
+    auto *internal_page = static_cast<InternalPage *>(page);
+    int index = 0;
+    page = ResolveChild(internal_page->FindValue(key, comparator_, &index));
+    if (!page) {
+      return nullptr;
+    }
+    if (range != nullptr) {
+      NarrowRange(internal_page, index, range);
+    }
+    if (page->IsLeafPage()) {
+      ctx->WPush(page);
+    } else {
+      ctx->RPush(page);
+    }
+    // 子页面加锁之后即可释放父页面
+    ctx->RPopFront();
+  }
+  return static_cast<LeafPage *>(page);
 }
 
 /*****************************************************************************
@@ -259,11 +634,32 @@ auto BPLUSTREE_TYPE::InsertIntoParent(BPlusTreePage *old_node, const KeyType &ke
  *****************************************************************************/
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::Remove(const KeyType &key) {
-#ifdef USING_CRABBING_PROTOCOL
-#else
-  std::unique_lock<std::shared_mutex> lock(mutex_);
-#endif
-  Context ctx(mutex_);
+  ScopedLatency latency(metrics_, MetricOp::REMOVE);
+  Trace(TraceOp::REMOVE, key);
+  auto tree_lock = ExclusiveTreeLock();
+  EpochGuard epoch_guard(epoch_, UsesLatches());
+  // 乐观下降：叶子删除后不会下溢时直接删除
+  if (mode_ == ConcurrencyMode::OPTIMISTIC) {
+    Context ctx(mutex_, ActiveLatchProfiler(), UsesLatches());
+    LeafPage *leaf_page = FindLeafForWrite(key, &ctx);
+    if (leaf_page == nullptr) {
+      return;
+    }
+    ValueType value;
+    int delete_index = -1;
+    if (!leaf_page->FindValue(key, comparator_, value, &delete_index)) {
+      return;
+    }
+    if (leaf_page->IsSafe(OperationType::DELETE)) {
+      leaf_page->Delete(delete_index);
+      stat_keys_.fetch_sub(1, std::memory_order_relaxed);
+      return;
+    }
+    metrics_.Increment(MetricCounter::RESTART);
+  }
+
+  // 需要借用或合并，从根开始加写锁重新下降
+  Context ctx(mutex_, ActiveLatchProfiler(), UsesLatches());
   ctx.WLockRoot();
   ctx.root_page_id_ = root_page_id_;
   if (ctx.root_page_id_ == INVALID_PAGE_ID) {
@@ -272,16 +668,16 @@ void BPLUSTREE_TYPE::Remove(const KeyType &key) {
   // 查找要删除的叶子页面
   BPlusTreePage *page = GetPage(ctx.root_page_id_);
   ctx.WPush(page);
-  ctx.WUnlockRoot();
   while (!page->IsLeafPage()) {
     InternalPage *internal_page = static_cast<InternalPage *>(page);
-    page_id_t next_page_id = internal_page->FindValue(key, comparator_, nullptr);
-    page = GetPage(next_page_id);
+    int slot;
+    page = ResolveChild(internal_page->FindValue(key, comparator_, &slot));
     if (!page) {
       ctx.Clear();
       return;  // 页面不存在
     }
-    ctx.WPush(page);
+    // 记录子页面在父页面中的位置，借用与合并时不必再扫描父页面
+    ctx.WPush(page, slot);
     // 蟹锁
     ctx.CheckAndReleaseAncestors(page, OperationType::DELETE);
   }
@@ -301,10 +697,12 @@ void BPLUSTREE_TYPE::Remove(const KeyType &key) {
     }
     if (leaf_page->FindValue(key, comparator_, value, &delete_index)) {
       leaf_page->Delete(delete_index);
+      stat_keys_.fetch_sub(1, std::memory_order_relaxed);
     }
 
     // 如果是根页面且为空，删除根页面
     if (leaf_page->GetPageId() == ctx.root_page_id_ && leaf_page->GetSize() == 0) {
+      ForgetRightmostLeaf(leaf_page);
       // 先释放锁
       ctx.WPopBack();
       DeletePage(leaf_page->GetPageId());
@@ -312,6 +710,7 @@ void BPLUSTREE_TYPE::Remove(const KeyType &key) {
 
       ctx.root_page_id_ = INVALID_PAGE_ID;
       root_page_id_ = INVALID_PAGE_ID;
+      stat_height_.store(0, std::memory_order_relaxed);
     }
     ctx.Clear();
     return;
@@ -320,41 +719,33 @@ void BPLUSTREE_TYPE::Remove(const KeyType &key) {
   // 页面不安全，需要借用或合并
   InternalPage *parent_page = static_cast<InternalPage *>(ctx.WritePath[ctx.WSize() - 2]);
   leaf_page->Delete(delete_index);
-  ctx.WPopBack();  // 删除当前叶子页面的写锁
-  RemoveLeafEntry(leaf_page, parent_page, key, &ctx);
+  stat_keys_.fetch_sub(1, std::memory_order_relaxed);
+  // 叶子的写锁保持到借用或合并结束：追加模式下其他线程不经过父页面也能访问最右叶子
+  RemoveLeafEntry(leaf_page, parent_page, ctx.WBackSlot(), &ctx);
 
   ctx.Clear();
 }
 
 INDEX_TEMPLATE_ARGUMENTS
-auto BPLUSTREE_TYPE::RemoveLeafEntry(LeafPage *leaf_page, InternalPage *parent_page,
-                                     const KeyType &key, Context *ctx) -> void {
-  // int delete_index = -1;
-  // ValueType value;
-  // if (!leaf_page->FindValue(key, comparator_, value, &delete_index)) {
-  //   return;
-  // }
-
-  // leaf_page->Delete(delete_index);
-
+auto BPLUSTREE_TYPE::RemoveLeafEntry(LeafPage *leaf_page, InternalPage *parent_page, int index,
+                                     Context *ctx) -> void {
   // 查找兄弟节点
+  assert(parent_page->ValueAt(index) == ChildRef::FromPage(leaf_page));
+  ctx->WMarkBackSibling();
   LeafPage *left_bro = nullptr;
   LeafPage *right_bro = nullptr;
-  int index = parent_page->ValueIndex(leaf_page->GetPageId());
 
   if (index > 0) {
-    page_id_t left_page_id = parent_page->ValueAt(index - 1);
-    BPlusTreePage *left_page = GetPage(left_page_id);
+    BPlusTreePage *left_page = ResolveChild(parent_page->ValueAt(index - 1));
     if (left_page && left_page->IsLeafPage()) {
-      ctx->WPush(left_page);
+      ctx->WPushSibling(left_page);
       left_bro = static_cast<LeafPage *>(left_page);
     }
   }
   if (index < parent_page->GetSize() - 1) {
-    page_id_t right_page_id = parent_page->ValueAt(index + 1);
-    BPlusTreePage *right_page = GetPage(right_page_id);
+    BPlusTreePage *right_page = ResolveChild(parent_page->ValueAt(index + 1));
     if (right_page && right_page->IsLeafPage()) {
-      ctx->WPush(right_page);
+      ctx->WPushSibling(right_page);
       right_bro = static_cast<LeafPage *>(right_page);
     }
   }
@@ -378,8 +769,7 @@ auto BPLUSTREE_TYPE::RemoveLeafEntry(LeafPage *leaf_page, InternalPage *parent_p
       borrow_page->Delete(last_idx);
       leaf_page->InsertFirst(borrow_key, borrow_value);
 
-      int parent_index = parent_page->ValueIndex(leaf_page->GetPageId());
-      parent_page->SetKeyAt(parent_index, borrow_key);
+      parent_page->SetKeyAt(index, borrow_key);
     } else {
       // 从右兄弟借用
       KeyType borrow_key = borrow_page->KeyAt(0);
@@ -387,9 +777,10 @@ auto BPLUSTREE_TYPE::RemoveLeafEntry(LeafPage *leaf_page, InternalPage *parent_p
       borrow_page->Delete(0);
       leaf_page->Insert(borrow_key, borrow_value, comparator_);
 
-      int right_parent_index = parent_page->ValueIndex(borrow_page->GetPageId());
-      parent_page->SetKeyAt(right_parent_index, borrow_page->KeyAt(0));
+      parent_page->SetKeyAt(index + 1, borrow_page->KeyAt(0));
     }
+    LeafRangeChanged();
+    metrics_.Increment(MetricCounter::LEAF_BORROW);
     return;
   }
 
@@ -406,25 +797,29 @@ auto BPLUSTREE_TYPE::RemoveLeafEntry(LeafPage *leaf_page, InternalPage *parent_p
       removed_page = right_bro;
     }
 
-    int merge_index = parent_page->ValueIndex(removed_page->GetPageId());
-    KeyType parent_key = parent_page->KeyAt(merge_index);
+    int merge_index = isLeft ? index : index + 1;
     kept_page->MergeFrom(removed_page->GetData(), removed_page->GetSize());
-    // 解锁两个兄弟节点
+    metrics_.Increment(MetricCounter::LEAF_MERGE);
+    // 无论父节点是否需要继续调整，叶子链都要跳过被删除的页面
+    kept_page->SetNextPageId(removed_page->GetNextPageId());
+    ForgetRightmostLeaf(removed_page);
+    // 解锁两个兄弟节点和当前叶子
     if (left_bro && left_bro->IsLeafPage()) {
       ctx->WPopBack();
     }
     if (right_bro && right_bro->IsLeafPage()) {
       ctx->WPopBack();
     }
+    ctx->WPopBack();
     if (parent_page->IsSafe(OperationType::DELETE)) {
       parent_page->Delete(merge_index);
-      kept_page->SetNextPageId(removed_page->GetNextPageId());
     } else {
       parent_page->Delete(merge_index);
 
+      int parent_slot = ctx->WBackSlot();
       ctx->WPopBack();  // 删除父节点的写锁
       InternalPage *grandparent_page = static_cast<InternalPage *>(ctx->WBack());
-      RemoveInternalEntry(parent_page, grandparent_page, parent_key, ctx);
+      RemoveInternalEntry(parent_page, grandparent_page, parent_slot, ctx);
     }
     DeletePage(removed_page->GetPageId());
   }
@@ -432,21 +827,15 @@ auto BPLUSTREE_TYPE::RemoveLeafEntry(LeafPage *leaf_page, InternalPage *parent_p
 
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::RemoveInternalEntry(InternalPage *internal_page, InternalPage *parent_page,
-                                         const KeyType &key, Context *ctx) -> void {
-  // int delete_index = -1;
-  // if (!internal_page->FindValue(key, comparator_, &delete_index)) {
-  //   return;
-  // }
-
-  // internal_page->Delete(delete_index);
-
+                                         int index, Context *ctx) -> void {
   // 如果是根页面且只有一个子节点
   if (internal_page->GetPageId() == ctx->root_page_id_ && internal_page->GetSize() == 1) {
     ctx->WLockRoot();
-    page_id_t new_root_id = internal_page->ValueAt(0);
+    page_id_t new_root_id = internal_page->ValueAt(0).GetPageId();
     ctx->root_page_id_ = new_root_id;
     // std::lock_guard<std::mutex> root_lock(root_mutex_);
     root_page_id_ = new_root_id;
+    stat_height_.fetch_sub(1, std::memory_order_relaxed);
     ctx->WPopBack();  // 删除根页面的写锁
     DeletePage(internal_page->GetPageId());
     return;
@@ -463,23 +852,21 @@ auto BPLUSTREE_TYPE::RemoveInternalEntry(InternalPage *internal_page, InternalPa
   }
 
   // 查找兄弟节点
+  assert(parent_page->ValueAt(index) == ChildRef::FromPage(internal_page));
   InternalPage *left_bro = nullptr;
   InternalPage *right_bro = nullptr;
-  int index = parent_page->ValueIndex(internal_page->GetPageId());
 
   if (index > 0) {
-    page_id_t left_page_id = parent_page->ValueAt(index - 1);
-    BPlusTreePage *left_page = GetPage(left_page_id);
+    BPlusTreePage *left_page = ResolveChild(parent_page->ValueAt(index - 1));
     if (left_page && !left_page->IsLeafPage()) {
-      ctx->WPush(left_page);
+      ctx->WPushSibling(left_page);
       left_bro = static_cast<InternalPage *>(left_page);
     }
   }
   if (index < parent_page->GetSize() - 1) {
-    page_id_t right_page_id = parent_page->ValueAt(index + 1);
-    BPlusTreePage *right_page = GetPage(right_page_id);
+    BPlusTreePage *right_page = ResolveChild(parent_page->ValueAt(index + 1));
     if (right_page && !right_page->IsLeafPage()) {
-      ctx->WPush(right_page);
+      ctx->WPushSibling(right_page);
       right_bro = static_cast<InternalPage *>(right_page);
     }
   }
@@ -502,7 +889,7 @@ auto BPLUSTREE_TYPE::RemoveInternalEntry(InternalPage *internal_page, InternalPa
       // 获取父节点的分隔键，以及左兄弟的最后一个键和指针
       KeyType separator_key = parent_page->KeyAt(index);
       KeyType borrow_key = borrow_page->KeyAt(source_idx);
-      page_id_t borrow_ptr = borrow_page->ValueAt(source_idx);
+      ChildRef borrow_ptr = borrow_page->ValueAt(source_idx);
 
       // 从左兄弟删除最后一个条目
       borrow_page->Delete(source_idx);
@@ -514,15 +901,16 @@ auto BPLUSTREE_TYPE::RemoveInternalEntry(InternalPage *internal_page, InternalPa
       parent_page->SetKeyAt(index, borrow_key);
     } else {
       // 从右兄弟借用（旋转操作）
-      int parent_sep_index = parent_page->ValueIndex(borrow_page->GetPageId());
+      int parent_sep_index = index + 1;
       KeyType separator_key = parent_page->KeyAt(parent_sep_index);
-      page_id_t borrow_page_id = borrow_page->ValueAt(0);
+      ChildRef borrow_child = borrow_page->ValueAt(0);
 
-      internal_page->Insert(separator_key, borrow_page_id, comparator_);
+      internal_page->Insert(separator_key, borrow_child, comparator_);
       KeyType new_separator_key = borrow_page->KeyAt(1);
       parent_page->SetKeyAt(parent_sep_index, new_separator_key);
       borrow_page->Delete(0);
     }
+    metrics_.Increment(MetricCounter::INTERNAL_BORROW);
     return;
   }
 
@@ -539,12 +927,13 @@ auto BPLUSTREE_TYPE::RemoveInternalEntry(InternalPage *internal_page, InternalPa
       removed_page = right_bro;
     }
 
-    int merge_index = parent_page->ValueIndex(removed_page->GetPageId());
+    int merge_index = isLeft ? index : index + 1;
     KeyType parent_key = parent_page->KeyAt(merge_index);
 
     kept_page->Insert(parent_key, removed_page->ValueAt(0), comparator_);
     // 合并剩余键值
     kept_page->MergeFrom(removed_page, &comparator_);
+    metrics_.Increment(MetricCounter::INTERNAL_MERGE);
     // 解锁两个兄弟节点
     if (left_bro && !left_bro->IsLeafPage()) {
       ctx->WPopBack();
@@ -558,10 +947,11 @@ auto BPLUSTREE_TYPE::RemoveInternalEntry(InternalPage *internal_page, InternalPa
     } else {
       parent_page->Delete(merge_index);
 
+      int parent_slot = ctx->WBackSlot();
       ctx->WPopBack();  // 删除父节点的写锁
       InternalPage *grandparent_page = static_cast<InternalPage *>(ctx->WBack());
 
-      RemoveInternalEntry(parent_page, grandparent_page, parent_key, ctx);
+      RemoveInternalEntry(parent_page, grandparent_page, parent_slot, ctx);
     }
 
     DeletePage(removed_page->GetPageId());
@@ -580,12 +970,14 @@ auto BPLUSTREE_TYPE::GetRootPageId() -> page_id_t {
 
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::SplitLeafPage(LeafPage *leaf_page, LeafPage *new_page, const KeyType &key,
-                                   const ValueType &value, page_id_t new_page_id) -> KeyType {
+                                   const ValueType &value, page_id_t new_page_id, bool append)
+    -> KeyType {
   // 插入新键到旧节点
   leaf_page->Insert(key, value, comparator_);
 
   int cur_size = leaf_page->GetSize();
-  int split_index = cur_size / 2;
+  // 追加时只把新键移到新页面，之后的追加继续填满新页面
+  int split_index = append ? cur_size - 1 : cur_size / 2;
 
   // 分裂节点
   new_page->CopyHalfFrom(leaf_page->GetData(), split_index, cur_size);
@@ -596,17 +988,22 @@ auto BPLUSTREE_TYPE::SplitLeafPage(LeafPage *leaf_page, LeafPage *new_page, cons
   KeyType middle_key = new_page->KeyAt(0);
   new_page->SetNextPageId(leaf_page->GetNextPageId());
   leaf_page->SetNextPageId(new_page_id);
+  LeafRangeChanged();
   return middle_key;
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::SplitInternalPage(InternalPage *internal_page, InternalPage *new_page,
-                                       const KeyType &key, page_id_t new_page_id) -> KeyType {
+                                       const KeyType &key, const ChildRef &new_child, bool append)
+    -> KeyType {
   // 插入新键到旧节点
-  internal_page->Insert(key, new_page_id, comparator_);
+  internal_page->Insert(key, new_child, comparator_);
 
   int cur_size = internal_page->GetSize();
-  int split_index = cur_size / 2;
+  // 追加时新页面只取最后两个子页面（第一个键上移到父页面）
+  int split_index =
+      append && comparator_(internal_page->KeyAt(cur_size - 1), key) == 0 ? cur_size - 2
+                                                                           : cur_size / 2;
 
   // 分裂节点
   new_page->CopyHalfFrom(internal_page->GetData(), split_index, cur_size);
@@ -647,9 +1044,11 @@ auto BPLUSTREE_TYPE::InternalCanMerge(InternalPage *merge_page, InternalPage *le
 }
 
 INDEX_TEMPLATE_ARGUMENTS
-void BPLUSTREE_TYPE::CreateAndRegisterPage(page_id_t page_id, bool is_leaf) {
-  if (pages_.count(page_id) > 0) {
-    return;
+auto BPLUSTREE_TYPE::CreateAndRegisterPage(page_id_t page_id, bool is_leaf) -> BPlusTreePage * {
+  // 并行反序列化时多个线程同时注册页面
+  std::lock_guard<std::mutex> lock(pages_mutex_);
+  if (auto it = pages_.find(page_id); it != pages_.end()) {
+    return it->second;
   }
 
   BPlusTreePage *page = nullptr;
@@ -663,8 +1062,165 @@ void BPLUSTREE_TYPE::CreateAndRegisterPage(page_id_t page_id, bool is_leaf) {
 
   page->SetPageId(page_id);
   pages_[page_id] = page;
+  metrics_.Increment(MetricCounter::PAGE_ALLOC);
+  (is_leaf ? stat_leaf_pages_ : stat_internal_pages_).fetch_add(1, std::memory_order_relaxed);
 
   next_page_id_ = std::max(next_page_id_, page_id + 1);
+  return page;
+}
+
+/*****************************************************************************
+ * BULK LOAD
+ *****************************************************************************/
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::BeginBulkLoad(size_t expected_entries, double fill_factor) -> void {
+  Clear();
+  bulk_levels_.clear();
+  bulk_prev_leaf_ = nullptr;
+  bulk_has_last_key_ = false;
+  // 填充率低于一半时页面会低于 GetMinSize
+  bulk_fill_factor_ = std::clamp(fill_factor, kMinBulkFillFactor, 1.0);
+
+  // 叶子页面最多容纳 max - 1 个元素（见 IsSafe），内部页面最多 max 个子节点
+  int leaf_capacity = std::max(1, leaf_max_size_ - 1);
+  int capacity =
+      std::clamp(static_cast<int>(leaf_capacity * bulk_fill_factor_), 1, leaf_capacity);
+  int min_size = std::max(1, leaf_max_size_ / 2);
+
+  // 预先规划每一层的页面数，使元素均匀分布
+  auto items = static_cast<int64_t>(expected_entries);
+  while (true) {
+    BulkLevel level;
+    level.capacity = capacity;
+    if (items > 0) {
+      level.items_left = items;
+      level.pages_left = (items + capacity - 1) / capacity;
+      // 页面数不超过 items / min_size，每个页面都不低于最小大小
+      level.pages_left = std::min(level.pages_left, std::max<int64_t>(1, items / min_size));
+    }
+    bulk_levels_.push_back(level);
+    if (level.pages_left <= 1) {
+      break;
+    }
+    items = level.pages_left;
+    int internal_capacity = std::max(2, internal_max_size_);
+    capacity = std::clamp(static_cast<int>(internal_capacity * bulk_fill_factor_), 2,
+                          internal_capacity);
+    // 内部页面至少要有两个子节点
+    min_size = std::max(2, internal_max_size_ / 2);
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::BulkLoadAppend(const KeyType &key, const ValueType &value) -> bool {
+  if (bulk_levels_.empty()) {
+    return false;
+  }
+  // 键必须严格递增
+  if (bulk_has_last_key_ && comparator_(bulk_last_key_, key) >= 0) {
+    return false;
+  }
+  BulkAppendToLevel(0, key, &value, nullptr);
+  stat_keys_.fetch_add(1, std::memory_order_relaxed);
+  bulk_last_key_ = key;
+  bulk_has_last_key_ = true;
+  return true;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::BulkAppendToLevel(size_t level, const KeyType &key, const ValueType *value,
+                                       BPlusTreePage *child) -> void {
+  BulkLevel *state = &bulk_levels_[level];
+  if (state->page == nullptr || state->count >= state->target) {
+    // 本层开始一个新页面
+    page_id_t new_page_id;
+    BPlusTreePage *new_page;
+    if (level == 0) {
+      LeafPage *leaf = NewLeafPage(&new_page_id);
+      if (bulk_prev_leaf_ != nullptr) {
+        bulk_prev_leaf_->SetNextPageId(new_page_id);
+      }
+      bulk_prev_leaf_ = leaf;
+      new_page = leaf;
+    } else {
+      new_page = NewInternalPage(&new_page_id);
+    }
+
+    int max_size = level == 0 ? leaf_max_size_ - 1 : internal_max_size_;
+    if (state->pages_left > 0) {
+      state->target = static_cast<int>((state->items_left + state->pages_left - 1) /
+                                       state->pages_left);
+      state->pages_left--;
+    } else {
+      // 超出预期数量的部分按容量填充
+      state->target = state->capacity;
+    }
+    state->target = std::clamp(state->target, 1, std::max(1, max_size));
+
+    BPlusTreePage *prev_page = state->page;
+    state->page = new_page;
+    state->count = 0;
+    if (prev_page == nullptr) {
+      state->first_page = new_page;
+      state->first_key = key;
+    } else {
+      // 本层出现第二个页面，需要把两个页面都挂到上一层
+      if (level + 1 == bulk_levels_.size()) {
+        BulkLevel parent;
+        int internal_capacity = std::max(2, internal_max_size_);
+        parent.capacity = std::clamp(static_cast<int>(internal_capacity * bulk_fill_factor_), 2,
+                                     internal_capacity);
+        bulk_levels_.push_back(parent);
+      }
+      if (bulk_levels_[level + 1].page == nullptr) {
+        BulkAppendToLevel(level + 1, bulk_levels_[level].first_key, nullptr,
+                          bulk_levels_[level].first_page);
+      }
+      BulkAppendToLevel(level + 1, key, nullptr, new_page);
+    }
+    // push_back 可能使 state 失效
+    state = &bulk_levels_[level];
+  }
+
+  if (level == 0) {
+    auto *leaf = static_cast<LeafPage *>(state->page);
+    leaf->SetAt(state->count, key, *value);
+    leaf->SetSize(state->count + 1);
+  } else {
+    auto *internal = static_cast<InternalPage *>(state->page);
+    // 内部页面第一个位置没有键
+    if (state->count > 0) {
+      internal->SetKeyAt(state->count, key);
+    }
+    internal->SetValueAt(state->count, ChildRef::FromPage(child));
+    internal->SetSize(state->count + 1);
+  }
+  state->count++;
+  if (state->items_left > 0) {
+    state->items_left--;
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::FinishBulkLoad() -> bool {
+  if (bulk_levels_.empty()) {
+    return false;
+  }
+  // 最高的非空层只有一个页面，就是根页面
+  root_page_id_ = INVALID_PAGE_ID;
+  stat_height_.store(0, std::memory_order_relaxed);
+  for (auto it = bulk_levels_.rbegin(); it != bulk_levels_.rend(); ++it) {
+    if (it->first_page != nullptr) {
+      root_page_id_ = it->first_page->GetPageId();
+      stat_height_.store(static_cast<int>(bulk_levels_.rend() - it), std::memory_order_relaxed);
+      break;
+    }
+  }
+  bulk_levels_.clear();
+  bulk_prev_leaf_ = nullptr;
+  bulk_has_last_key_ = false;
+  return true;
 }
 
 INDEX_TEMPLATE_ARGUMENTS
@@ -673,8 +1229,149 @@ auto BPLUSTREE_TYPE::Clear() -> void {
     delete pair.second;
   }
   pages_.clear();
+  epoch_.ReclaimAll();
+  rightmost_leaf_.store(nullptr, std::memory_order_relaxed);
+  InvalidateCachedLeaves();
+  hash_index_.Clear();
   root_page_id_ = INVALID_PAGE_ID;
   next_page_id_ = 0;  // 或者您的起始ID
+  stat_keys_.store(0, std::memory_order_relaxed);
+  stat_leaf_pages_.store(0, std::memory_order_relaxed);
+  stat_internal_pages_.store(0, std::memory_order_relaxed);
+  stat_height_.store(0, std::memory_order_relaxed);
+}
+
+/*****************************************************************************
+ * STATISTICS
+ *****************************************************************************/
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::GetStats(bool full_scan) -> TreeStats {
+  TreeStats stats;
+  stats.height = stat_height_.load(std::memory_order_relaxed);
+  stats.key_count = std::max<int64_t>(0, stat_keys_.load(std::memory_order_relaxed));
+  stats.leaf_pages = std::max<int64_t>(0, stat_leaf_pages_.load(std::memory_order_relaxed));
+  stats.internal_pages =
+      std::max<int64_t>(0, stat_internal_pages_.load(std::memory_order_relaxed));
+  if (!full_scan) {
+    return stats;
+  }
+
+  auto tree_lock = SharedTreeLock();
+  EpochGuard epoch_guard(epoch_, UsesLatches());
+  stats.full_scan = true;
+  stats.height = 0;
+  stats.key_count = stats.leaf_pages = stats.internal_pages = 0;
+  Context ctx(mutex_, nullptr, UsesLatches());
+  ctx.RLockRoot();
+  BPlusTreePage *root = root_page_id_ == INVALID_PAGE_ID ? nullptr : GetPage(root_page_id_);
+  if (root == nullptr) {
+    return stats;
+  }
+  // 持有根页面的读锁直到遍历结束，会改变树结构的写操作都要对根页面加写锁，遍历期间结构不变；
+  // 乐观路径和 append/finger/哈希索引只锁叶子的写入仍会并发进行，统计到的键数与填充率只是近似值
+  ctx.RPush(root);
+  ctx.RUnlockRoot();
+  CollectStats(root, 0, &stats);
+  stats.height = static_cast<int>(stats.pages_per_level.size());
+  return stats;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::CollectStats(BPlusTreePage *page, size_t level, TreeStats *stats) -> void {
+  if (stats->pages_per_level.size() <= level) {
+    stats->pages_per_level.resize(level + 1, 0);
+  }
+  stats->pages_per_level[level]++;
+
+  constexpr size_t entry_size = sizeof(MappingType);
+  int size = page->GetSize();
+  int max_size = page->GetMaxSize();
+  auto fill_bucket = [](int size, int capacity) {
+    int bucket = capacity > 0 ? size * TreeStats::kFillBuckets / capacity : 0;
+    return std::clamp(bucket, 0, TreeStats::kFillBuckets - 1);
+  };
+
+  if (page->IsLeafPage()) {
+    auto *leaf = static_cast<LeafPage *>(page);
+    stats->leaf_pages++;
+    stats->key_count += size;
+    // 叶子页面最多容纳 max - 1 个元素
+    stats->leaf_fill[fill_bucket(size, std::max(1, max_size - 1))]++;
+    stats->bytes_used += size * entry_size;
+    stats->bytes_allocated += sizeof(LeafPage) + leaf->GetCapacity() * entry_size;
+    if (leaf->GetCapacity() > static_cast<size_t>(max_size)) {
+      stats->bytes_excess_capacity += (leaf->GetCapacity() - max_size) * entry_size;
+    }
+    return;
+  }
+
+  auto *internal = static_cast<InternalPage *>(page);
+  constexpr size_t child_size = sizeof(std::pair<KeyType, ChildRef>);
+  stats->internal_pages++;
+  stats->internal_fill[fill_bucket(size, max_size)]++;
+  stats->bytes_used += size * child_size;
+  stats->bytes_allocated += sizeof(InternalPage) + internal->GetCapacity() * child_size;
+  // 内部页面分裂时临时多容纳一个元素
+  if (internal->GetCapacity() > static_cast<size_t>(max_size) + 1) {
+    stats->bytes_excess_capacity += (internal->GetCapacity() - max_size - 1) * child_size;
+  }
+  for (int i = 0; i < size; i++) {
+    BPlusTreePage *child = ResolveChild(internal->ValueAt(i));
+    if (child == nullptr) {
+      continue;
+    }
+    if (UsesLatches()) {
+      child->RLock();
+    }
+    CollectStats(child, level + 1, stats);
+    if (UsesLatches()) {
+      child->RUnlock();
+    }
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::RecountStats() -> void {
+  TreeStats stats = GetStats(true);
+  stat_keys_.store(stats.key_count, std::memory_order_relaxed);
+  stat_leaf_pages_.store(stats.leaf_pages, std::memory_order_relaxed);
+  stat_internal_pages_.store(stats.internal_pages, std::memory_order_relaxed);
+  stat_height_.store(stats.height, std::memory_order_relaxed);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::SwizzleChildren() -> void {
+  for (auto &pair : pages_) {
+    if (pair.second->IsLeafPage()) {
+      continue;
+    }
+    auto *internal = static_cast<InternalPage *>(pair.second);
+    for (int i = 0; i < internal->GetSize(); i++) {
+      ChildRef child = internal->ValueAt(i);
+      if (child.IsSwizzled()) {
+        continue;
+      }
+      // 找不到的子页面保持为页面 id
+      auto it = pages_.find(child.GetPageId());
+      if (it != pages_.end()) {
+        internal->SetValueAt(i, ChildRef::FromPage(it->second));
+      }
+    }
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::UnswizzleChildren() -> void {
+  for (auto &pair : pages_) {
+    if (pair.second->IsLeafPage()) {
+      continue;
+    }
+    auto *internal = static_cast<InternalPage *>(pair.second);
+    for (int i = 0; i < internal->GetSize(); i++) {
+      internal->SetValueAt(i, ChildRef::FromPageId(internal->ValueAt(i).GetPageId()));
+    }
+  }
 }
 
 INDEX_TEMPLATE_ARGUMENTS
@@ -707,7 +1404,7 @@ void BPLUSTREE_TYPE::PrintTree(page_id_t page_id, const BPlusTreePage *page) {
     // Print the contents of the internal page.
     std::cout << "Contents: ";
     for (int i = 0; i < internal->GetSize(); i++) {
-      std::cout << internal->KeyAt(i) << ": " << internal->ValueAt(i);
+      std::cout << internal->KeyAt(i) << ": " << internal->ValueAt(i).GetPageId();
       if ((i + 1) < internal->GetSize()) {
         std::cout << ", ";
       }
@@ -715,7 +1412,7 @@ void BPLUSTREE_TYPE::PrintTree(page_id_t page_id, const BPlusTreePage *page) {
     std::cout << std::endl;
     std::cout << std::endl;
     for (int i = 0; i < internal->GetSize(); i++) {
-      auto page = GetPage(internal->ValueAt(i));
+      auto page = ResolveChild(internal->ValueAt(i));
       PrintTree(page->GetPageId(), page);
     }
   }
@@ -786,7 +1483,7 @@ auto BPLUSTREE_TYPE::ToPrintableBPlusTree(page_id_t root_id) -> PrintableBPlusTr
   proot.keys_ = oss.str();
   proot.size_ = 0;
   for (int i = 0; i < internal_page->GetSize(); i++) {
-    page_id_t child_id = internal_page->ValueAt(i);
+    page_id_t child_id = internal_page->ValueAt(i).GetPageId();
     // 添加递归深度限制和有效性检查
     if (child_id != INVALID_PAGE_ID) {
       try {
@@ -0,0 +1,110 @@
+#include "b_plus_tree_codec.h"
+
+#include <string.h>
+
+int codec_key_width(const int64_t *keys, int count) {
+  if (count <= 1) {
+    return 0;
+  }
+  // 键有序，最大差值就是首尾之差
+  uint64_t range = (uint64_t)keys[count - 1] - (uint64_t)keys[0];
+  if (range == 0) {
+    return 0;
+  }
+  if (range <= UINT8_MAX) {
+    return 1;
+  }
+  if (range <= UINT16_MAX) {
+    return 2;
+  }
+  if (range <= UINT32_MAX) {
+    return 4;
+  }
+  return 8;
+}
+
+size_t codec_keys_size(int count, int width) {
+  return (size_t)count * (size_t)width;
+}
+
+void codec_encode_keys(const int64_t *keys, int count, int width, uint8_t *out) {
+  uint64_t base = (uint64_t)keys[0];
+  for (int i = 0; i < count; i++) {
+    uint64_t delta = (uint64_t)keys[i] - base;
+    switch (width) {
+      case 1: {
+        uint8_t v = (uint8_t)delta;
+        memcpy(out + i, &v, sizeof(v));
+        break;
+      }
+      case 2: {
+        uint16_t v = (uint16_t)delta;
+        memcpy(out + (size_t)i * 2, &v, sizeof(v));
+        break;
+      }
+      case 4: {
+        uint32_t v = (uint32_t)delta;
+        memcpy(out + (size_t)i * 4, &v, sizeof(v));
+        break;
+      }
+      case 8:
+        memcpy(out + (size_t)i * 8, &delta, sizeof(delta));
+        break;
+      default:
+        break;
+    }
+  }
+}
+
+// 每种宽度一个无分支的循环，-O2 以上会被展开成 SIMD 的零扩展加法
+static void decode_width1(const uint8_t *in, int count, uint64_t base, int64_t *out) {
+  for (int i = 0; i < count; i++) {
+    out[i] = (int64_t)(base + in[i]);
+  }
+}
+
+static void decode_width2(const uint8_t *in, int count, uint64_t base, int64_t *out) {
+  for (int i = 0; i < count; i++) {
+    uint16_t v;
+    memcpy(&v, in + (size_t)i * 2, sizeof(v));
+    out[i] = (int64_t)(base + v);
+  }
+}
+
+static void decode_width4(const uint8_t *in, int count, uint64_t base, int64_t *out) {
+  for (int i = 0; i < count; i++) {
+    uint32_t v;
+    memcpy(&v, in + (size_t)i * 4, sizeof(v));
+    out[i] = (int64_t)(base + v);
+  }
+}
+
+static void decode_width8(const uint8_t *in, int count, uint64_t base, int64_t *out) {
+  for (int i = 0; i < count; i++) {
+    uint64_t v;
+    memcpy(&v, in + (size_t)i * 8, sizeof(v));
+    out[i] = (int64_t)(base + v);
+  }
+}
+
+void codec_decode_keys(const uint8_t *in, int count, int64_t base, int width, int64_t *out) {
+  switch (width) {
+    case 1:
+      decode_width1(in, count, (uint64_t)base, out);
+      break;
+    case 2:
+      decode_width2(in, count, (uint64_t)base, out);
+      break;
+    case 4:
+      decode_width4(in, count, (uint64_t)base, out);
+      break;
+    case 8:
+      decode_width8(in, count, (uint64_t)base, out);
+      break;
+    default:
+      for (int i = 0; i < count; i++) {
+        out[i] = base;
+      }
+      break;
+  }
+}
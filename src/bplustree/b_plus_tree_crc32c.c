@@ -0,0 +1,101 @@
+#include "b_plus_tree_crc32c.h"
+
+#include <pthread.h>
+#include <string.h>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <nmmintrin.h>
+#define CRC32C_HAVE_SSE42 1
+#endif
+
+#define CRC32C_POLY 0x82F63B78u  // 反射后的 Castagnoli 多项式
+
+static uint32_t crc_table[8][256];
+static uint32_t (*crc_impl)(uint32_t, const uint8_t *, size_t);
+static pthread_once_t crc_once = PTHREAD_ONCE_INIT;
+
+static uint32_t crc32c_software(uint32_t crc, const uint8_t *p, size_t len) {
+  // 先按字节对齐到 8 字节边界，再每次处理 8 字节
+  while (len > 0 && ((uintptr_t)p & 7) != 0) {
+    crc = crc_table[0][(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    len--;
+  }
+  while (len >= 8) {
+    uint64_t word;
+    memcpy(&word, p, sizeof(word));
+    word ^= crc;
+    crc = crc_table[7][word & 0xFF] ^ crc_table[6][(word >> 8) & 0xFF] ^
+          crc_table[5][(word >> 16) & 0xFF] ^ crc_table[4][(word >> 24) & 0xFF] ^
+          crc_table[3][(word >> 32) & 0xFF] ^ crc_table[2][(word >> 40) & 0xFF] ^
+          crc_table[1][(word >> 48) & 0xFF] ^ crc_table[0][word >> 56];
+    p += 8;
+    len -= 8;
+  }
+  while (len > 0) {
+    crc = crc_table[0][(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    len--;
+  }
+  return crc;
+}
+
+#ifdef CRC32C_HAVE_SSE42
+__attribute__((target("sse4.2"))) static uint32_t crc32c_sse42(uint32_t crc, const uint8_t *p,
+                                                                 size_t len) {
+  while (len > 0 && ((uintptr_t)p & 7) != 0) {
+    crc = _mm_crc32_u8(crc, *p++);
+    len--;
+  }
+  uint64_t crc64 = crc;
+  while (len >= 8) {
+    uint64_t word;
+    memcpy(&word, p, sizeof(word));
+    crc64 = _mm_crc32_u64(crc64, word);
+    p += 8;
+    len -= 8;
+  }
+  crc = (uint32_t)crc64;
+  while (len > 0) {
+    crc = _mm_crc32_u8(crc, *p++);
+    len--;
+  }
+  return crc;
+}
+#endif
+
+static void crc32c_init(void) {
+  for (uint32_t i = 0; i < 256; i++) {
+    uint32_t crc = i;
+    for (int j = 0; j < 8; j++) {
+      crc = (crc >> 1) ^ ((crc & 1) ? CRC32C_POLY : 0);
+    }
+    crc_table[0][i] = crc;
+  }
+  for (uint32_t i = 0; i < 256; i++) {
+    for (int k = 1; k < 8; k++) {
+      crc_table[k][i] = (crc_table[k - 1][i] >> 8) ^ crc_table[0][crc_table[k - 1][i] & 0xFF];
+    }
+  }
+
+  crc_impl = crc32c_software;
+#ifdef CRC32C_HAVE_SSE42
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("sse4.2")) {
+    crc_impl = crc32c_sse42;
+  }
+#endif
+}
+
+uint32_t crc32c_extend(uint32_t crc, const void *data, size_t len) {
+  pthread_once(&crc_once, crc32c_init);
+  return ~crc_impl(~crc, (const uint8_t *)data, len);
+}
+
+uint32_t crc32c_extend_portable(uint32_t crc, const void *data, size_t len) {
+  pthread_once(&crc_once, crc32c_init);
+  return ~crc32c_software(~crc, (const uint8_t *)data, len);
+}
+
+bool crc32c_is_hardware_accelerated(void) {
+  pthread_once(&crc_once, crc32c_init);
+  return crc_impl != crc32c_software;
+}
@@ -0,0 +1,98 @@
+#include "b_plus_tree_epoch.h"
+
+#include <algorithm>
+
+namespace mybplus {
+
+namespace {
+std::atomic<int> next_slot{0};
+}  // namespace
+
+auto EpochManager::LocalSlot() -> int {
+  thread_local int slot = next_slot.fetch_add(1, std::memory_order_relaxed) % kSlots;
+  return slot;
+}
+
+auto EpochManager::Enter() -> int {
+  int index = LocalSlot();
+  Slot &slot = slots_[index];
+  uint64_t state = slot.state.load(std::memory_order_relaxed);
+  while (true) {
+    // 槽位空闲时记录当前 epoch；已被占用时保留更早的 epoch，只增加计数
+    uint64_t desired = (state & kCountMask) == 0
+                           ? (global_epoch_.load(std::memory_order_seq_cst) << 32) | 1
+                           : state + 1;
+    if (slot.state.compare_exchange_weak(state, desired, std::memory_order_seq_cst,
+                                         std::memory_order_relaxed)) {
+      return index;
+    }
+  }
+}
+
+auto EpochManager::Exit(int slot) -> void {
+  slots_[slot].state.fetch_sub(1, std::memory_order_release);
+}
+
+auto EpochManager::Retire(void *object, Destroy destroy) -> void {
+  Slot &slot = slots_[LocalSlot()];
+  // 对象已经从树上摘除之后再读取 epoch
+  uint64_t epoch = global_epoch_.load(std::memory_order_seq_cst);
+  std::lock_guard<std::mutex> lock(slot.limbo_mutex);
+  slot.limbo.push_back({object, destroy, epoch});
+  if (slot.limbo.size() >= kReclaimBatch) {
+    global_epoch_.fetch_add(1, std::memory_order_seq_cst);
+    ReclaimSlot(&slot, MinActiveEpoch());
+  }
+}
+
+auto EpochManager::Reclaim() -> size_t {
+  global_epoch_.fetch_add(1, std::memory_order_seq_cst);
+  uint64_t safe_epoch = MinActiveEpoch();
+  size_t reclaimed = 0;
+  for (auto &slot : slots_) {
+    std::lock_guard<std::mutex> lock(slot.limbo_mutex);
+    reclaimed += ReclaimSlot(&slot, safe_epoch);
+  }
+  return reclaimed;
+}
+
+auto EpochManager::ReclaimAll() -> void {
+  for (auto &slot : slots_) {
+    std::lock_guard<std::mutex> lock(slot.limbo_mutex);
+    ReclaimSlot(&slot, UINT64_MAX);
+  }
+}
+
+auto EpochManager::PendingCount() -> size_t {
+  size_t pending = 0;
+  for (auto &slot : slots_) {
+    std::lock_guard<std::mutex> lock(slot.limbo_mutex);
+    pending += slot.limbo.size();
+  }
+  return pending;
+}
+
+auto EpochManager::MinActiveEpoch() const -> uint64_t {
+  uint64_t min_epoch = global_epoch_.load(std::memory_order_seq_cst);
+  for (const auto &slot : slots_) {
+    uint64_t state = slot.state.load(std::memory_order_seq_cst);
+    if ((state & kCountMask) != 0) {
+      min_epoch = std::min(min_epoch, state >> 32);
+    }
+  }
+  return min_epoch;
+}
+
+auto EpochManager::ReclaimSlot(Slot *slot, uint64_t safe_epoch) -> size_t {
+  // 在 safe_epoch 之前退休的对象，所有仍在运行的操作都是之后才开始的，不可能再访问到
+  auto keep = std::partition(slot->limbo.begin(), slot->limbo.end(),
+                             [safe_epoch](const Retired &r) { return r.epoch >= safe_epoch; });
+  size_t reclaimed = slot->limbo.end() - keep;
+  for (auto it = keep; it != slot->limbo.end(); ++it) {
+    it->destroy(it->object);
+  }
+  slot->limbo.erase(keep, slot->limbo.end());
+  return reclaimed;
+}
+
+}  // namespace mybplus
@@ -0,0 +1,167 @@
+#include "b_plus_tree_hash_index.h"
+
+#include <functional>
+
+#include "config.h"
+
+namespace mybplus {
+
+template <typename KeyType, typename KeyComparator>
+auto AdaptiveHashIndex<KeyType, KeyComparator>::Resize(size_t capacity) -> void {
+  if (capacity == 0) {
+    buckets_.reset();
+    heat_.reset();
+    generations_.reset();
+    capacity_ = 0;
+    shift_ = 64;
+    return;
+  }
+  int bits = 0;
+  while ((size_t{1} << bits) < capacity) {
+    bits++;
+  }
+  capacity_ = size_t{1} << bits;
+  shift_ = 64 - bits;
+  buckets_ = std::make_unique<Bucket[]>(capacity_);
+  heat_ = std::make_unique<std::atomic<uint8_t>[]>(capacity_);
+  generations_ = std::make_unique<std::atomic<uint64_t>[]>(capacity_);
+  Clear();
+}
+
+template <typename KeyType, typename KeyComparator>
+auto AdaptiveHashIndex<KeyType, KeyComparator>::Clear() -> void {
+  for (size_t i = 0; i < capacity_; i++) {
+    buckets_[i].leaf.store(nullptr, std::memory_order_relaxed);
+    heat_[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+template <typename KeyType, typename KeyComparator>
+auto AdaptiveHashIndex<KeyType, KeyComparator>::BucketFor(const KeyType &key) -> Bucket & {
+  // 只有一个桶时 shift_ 为 64，移位未定义
+  size_t index = shift_ >= 64 ? 0 : Mix(std::hash<KeyType>{}(key)) >> shift_;
+  return buckets_[index];
+}
+
+template <typename KeyType, typename KeyComparator>
+auto AdaptiveHashIndex<KeyType, KeyComparator>::LeafIndex(const BPlusTreePage *leaf) const
+    -> size_t {
+  auto address = reinterpret_cast<uintptr_t>(leaf);
+  return shift_ >= 64 ? 0 : Mix(address >> 4) >> shift_;
+}
+
+template <typename KeyType, typename KeyComparator>
+auto AdaptiveHashIndex<KeyType, KeyComparator>::Lookup(const KeyType &key, Location *location)
+    -> bool {
+  LocalCounters().lookups.fetch_add(1, std::memory_order_relaxed);
+  Bucket &bucket = BucketFor(key);
+  // 乐观读取：先复制桶的内容，版本校验通过才使用
+  uint32_t version;
+  if (!bucket.latch.OptimisticRead(&version)) {
+    return false;
+  }
+  KeyType stored_key = bucket.key.load(std::memory_order_relaxed);
+  Location stored{bucket.leaf.load(std::memory_order_relaxed),
+                  bucket.slot.load(std::memory_order_relaxed),
+                  bucket.version.load(std::memory_order_relaxed)};
+  uint64_t generation = bucket.generation.load(std::memory_order_relaxed);
+  if (!bucket.latch.Validate(version) || stored.leaf == nullptr ||
+      comparator_(stored_key, key) != 0) {
+    return false;
+  }
+  // 调用方已经进入 epoch：代数未变说明记录之后叶子没有被释放，
+  // 之后才释放的页面要等调用方退出才会回收
+  if (generations_[LeafIndex(stored.leaf)].load(std::memory_order_seq_cst) != generation) {
+    return false;
+  }
+  *location = stored;
+  return true;
+}
+
+template <typename KeyType, typename KeyComparator>
+auto AdaptiveHashIndex<KeyType, KeyComparator>::RecordHit() -> void {
+  LocalCounters().hits.fetch_add(1, std::memory_order_relaxed);
+}
+
+template <typename KeyType, typename KeyComparator>
+auto AdaptiveHashIndex<KeyType, KeyComparator>::Touch(const BPlusTreePage *leaf) -> bool {
+  // 计数之间的竞争只会让热度略有偏差，不需要原子的加一
+  std::atomic<uint8_t> &heat = heat_[LeafIndex(leaf)];
+  uint8_t count = heat.load(std::memory_order_relaxed);
+  if (count < kHotThreshold) {
+    heat.store(count + 1, std::memory_order_relaxed);
+  }
+
+  // 定期把一段计数减半，不再被访问的叶子会逐渐变冷
+  thread_local uint32_t touches = 0;
+  if (++touches % kAgingInterval == 0) {
+    size_t start = aging_cursor_.fetch_add(kAgingStride, std::memory_order_relaxed);
+    for (size_t i = 0; i < kAgingStride; i++) {
+      std::atomic<uint8_t> &aged = heat_[(start + i) & (capacity_ - 1)];
+      aged.store(aged.load(std::memory_order_relaxed) / 2, std::memory_order_relaxed);
+    }
+  }
+  return count >= kHotThreshold;
+}
+
+template <typename KeyType, typename KeyComparator>
+auto AdaptiveHashIndex<KeyType, KeyComparator>::Store(const KeyType &key,
+                                                      const Location &location) -> void {
+  Bucket &bucket = BucketFor(key);
+  if (!bucket.latch.TryLockExclusive()) {
+    return;
+  }
+  // 与 Lookup 的校验配对：读到这里写入的值的读者，校验时一定能看到写锁或新版本
+  std::atomic_thread_fence(std::memory_order_release);
+  bucket.key.store(key, std::memory_order_relaxed);
+  bucket.leaf.store(location.leaf, std::memory_order_relaxed);
+  bucket.slot.store(location.slot, std::memory_order_relaxed);
+  bucket.version.store(location.version, std::memory_order_relaxed);
+  bucket.generation.store(generations_[LeafIndex(location.leaf)].load(std::memory_order_seq_cst),
+                          std::memory_order_relaxed);
+  bucket.latch.UnlockExclusive();
+  LocalCounters().stores.fetch_add(1, std::memory_order_relaxed);
+}
+
+template <typename KeyType, typename KeyComparator>
+auto AdaptiveHashIndex<KeyType, KeyComparator>::InvalidateLeaf(const BPlusTreePage *leaf) -> void {
+  if (capacity_ != 0) {
+    generations_[LeafIndex(leaf)].fetch_add(1, std::memory_order_seq_cst);
+  }
+}
+
+template <typename KeyType, typename KeyComparator>
+auto AdaptiveHashIndex<KeyType, KeyComparator>::Stats() const -> HashIndexStats {
+  HashIndexStats stats;
+  stats.capacity = capacity_;
+  stats.bytes = capacity_ * (sizeof(Bucket) + sizeof(std::atomic<uint8_t>) +
+                            sizeof(std::atomic<uint64_t>));
+  for (const auto &slot : counters_) {
+    stats.lookups += slot.lookups.load(std::memory_order_relaxed);
+    stats.hits += slot.hits.load(std::memory_order_relaxed);
+    stats.stores += slot.stores.load(std::memory_order_relaxed);
+  }
+  return stats;
+}
+
+template <typename KeyType, typename KeyComparator>
+auto AdaptiveHashIndex<KeyType, KeyComparator>::ResetStats() -> void {
+  for (auto &slot : counters_) {
+    slot.lookups.store(0, std::memory_order_relaxed);
+    slot.hits.store(0, std::memory_order_relaxed);
+    slot.stores.store(0, std::memory_order_relaxed);
+  }
+}
+
+template <typename KeyType, typename KeyComparator>
+auto AdaptiveHashIndex<KeyType, KeyComparator>::LocalCounters() -> CounterSlot & {
+  // 线程按创建顺序分配计数槽位，超过 kCounterSlots 个线程时共享（计数仍是原子的）
+  static std::atomic<uint32_t> next_thread_index{0};
+  thread_local uint32_t thread_index =
+      next_thread_index.fetch_add(1, std::memory_order_relaxed) % kCounterSlots;
+  return counters_[thread_index];
+}
+
+template class AdaptiveHashIndex<int64_t, Comparator>;
+
+}  // namespace mybplus
@@ -1,5 +1,6 @@
 #include "b_plus_tree_internal.h"
 
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 
@@ -14,17 +15,18 @@ auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::Init(int max_size) -> void {
   SetPageType(IndexPageType::INTERNAL_PAGE);
   KeyType vice_key;
   vice_key = KeyType();
-  array_.resize(max_size);
+  // 分裂前会先插入再拆分，需要多留一个位置
+  array_.resize(max_size + 1);
   SetKeyAt(0, vice_key);
   SetSize(1);
-  SetValueAt(0, INVALID_PAGE_ID);
+  SetValueAt(0, ValueType());
 }
 
 INDEX_TEMPLATE_ARGUMENTS
-auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::PopulateNewRoot(page_id_t page_id_one, const KeyType &key,
-                                                     page_id_t page_id_two) -> void {
-  array_[0] = MappingType{KeyType(), page_id_one};
-  array_[1] = MappingType{key, page_id_two};
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::PopulateNewRoot(const ValueType &child_one, const KeyType &key,
+                                                     const ValueType &child_two) -> void {
+  array_[0] = MappingType{KeyType(), child_one};
+  array_[1] = MappingType{key, child_two};
   SetSize(2);
 }
 
@@ -84,14 +86,10 @@ auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::Insert(const KeyType &key, const ValueType
   if (index < GetSize() && comparator(array_[index].first, key) == 0) {
     return false;
   }
-  // std::move_backward(array_.begin() + index, array_.begin() + size, array_.begin() + size + 1);
-  // array_[index] = MappingType{key, value};
-  array_.insert(array_.begin() + index, MappingType{key, value});
+  std::move_backward(array_.begin() + index, array_.begin() + size, array_.begin() + size + 1);
+  array_[index] = MappingType{key, value};
 
   IncreaseSize(1);
-  // if (GetSize() > GetMaxSize()) {
-  //   array_.resize(GetMaxSize());
-  // }
   return true;
 }
 
@@ -101,7 +99,9 @@ auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::InsertFirst(const KeyType &key, const Value
   if (GetSize() >= GetMaxSize()) {
     return false;
   }
-  array_.insert(array_.begin() + 1, MappingType{key, array_[0].second});
+  int size = GetSize();
+  std::move_backward(array_.begin() + 1, array_.begin() + size, array_.begin() + size + 1);
+  array_[1] = MappingType{key, array_[0].second};
 
   // 然后更新索引0处的指针为从兄弟节点借来的新指针
   array_[0].second = value;
@@ -115,7 +115,8 @@ auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::Delete(int child_page_index) -> bool {
   if (child_page_index < 0 || child_page_index >= size) {
     return false;
   }
-  array_.erase(array_.begin() + child_page_index);
+  std::move(array_.begin() + child_page_index + 1, array_.begin() + size,
+            array_.begin() + child_page_index);
   IncreaseSize(-1);
   return true;
 }
@@ -129,7 +130,7 @@ auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueIndex(const ValueType &value) const ->
   return -1;
 }
 
-// valuetype for internalNode should be page id_t
-template class BPlusTreeInternalPage<int64_t, page_id_t, Comparator>;
+// 内部页面的值是指向子页面的 ChildRef
+template class BPlusTreeInternalPage<int64_t, ChildRef, Comparator>;
 
 }  // namespace mybplus
@@ -0,0 +1,88 @@
+#include "b_plus_tree_latch.h"
+
+#include <climits>
+#include <thread>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace mybplus {
+
+#define LATCH_SPIN_COUNT 64
+
+namespace {
+
+inline auto CpuRelax() -> void {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield");
+#endif
+}
+
+}  // namespace
+
+auto HybridLatch::LockExclusiveSlow() -> void {
+  for (int spin = 0;; spin++) {
+    uint32_t state = state_.load(std::memory_order_relaxed);
+    if ((state & ~kWaiters) == 0) {
+      if (state_.compare_exchange_weak(state, state | kExclusive, std::memory_order_acquire,
+                                       std::memory_order_relaxed)) {
+        return;
+      }
+      continue;
+    }
+    if (spin < LATCH_SPIN_COUNT) {
+      CpuRelax();
+      continue;
+    }
+    Park(state);
+  }
+}
+
+auto HybridLatch::LockSharedSlow() -> void {
+  for (int spin = 0;; spin++) {
+    uint32_t state = state_.load(std::memory_order_relaxed);
+    if (CanShare(state)) {
+      if (state_.compare_exchange_weak(state, state + 1, std::memory_order_acquire,
+                                       std::memory_order_relaxed)) {
+        return;
+      }
+      continue;
+    }
+    if (spin < LATCH_SPIN_COUNT) {
+      CpuRelax();
+      continue;
+    }
+    Park(state);
+  }
+}
+
+auto HybridLatch::Park(uint32_t state) -> void {
+  // 先标记等待者，解锁方看到标记才会唤醒；标记失败说明状态已变，回到调用方重试
+  if ((state & kWaiters) == 0) {
+    if (!state_.compare_exchange_strong(state, state | kWaiters, std::memory_order_relaxed)) {
+      return;
+    }
+    state |= kWaiters;
+  }
+#ifdef __linux__
+  static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex needs a plain word");
+  syscall(SYS_futex, reinterpret_cast<uint32_t *>(&state_), FUTEX_WAIT_PRIVATE, state, nullptr,
+          nullptr, 0);
+#else
+  std::this_thread::yield();
+#endif
+}
+
+auto HybridLatch::WakeAll() -> void {
+#ifdef __linux__
+  syscall(SYS_futex, reinterpret_cast<uint32_t *>(&state_), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr,
+          nullptr, 0);
+#endif
+}
+
+}  // namespace mybplus
@@ -0,0 +1,184 @@
+#include "b_plus_tree_latch_profiler.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+namespace mybplus {
+
+#define PAGE_TABLE_PROBES 32  // 线性探测的最大步数
+
+LatchProfiler::LatchProfiler() : pages_(new PageEntry[kPageTableSize]) {}
+
+LatchProfiler::~LatchProfiler() {
+  for (auto &slot : slots_) {
+    delete slot.load(std::memory_order_relaxed);
+  }
+  delete[] pages_;
+}
+
+auto LatchProfiler::LocalSlot() -> Slot * {
+  static std::atomic<uint32_t> next_thread_index{0};
+  thread_local uint32_t thread_index =
+      next_thread_index.fetch_add(1, std::memory_order_relaxed) % kMaxSlots;
+
+  std::atomic<Slot *> &entry = slots_[thread_index];
+  Slot *slot = entry.load(std::memory_order_acquire);
+  if (slot != nullptr) {
+    return slot;
+  }
+  auto *created = new Slot();
+  if (entry.compare_exchange_strong(slot, created, std::memory_order_acq_rel)) {
+    return created;
+  }
+  delete created;
+  return slot;
+}
+
+auto LatchProfiler::Record(int level, page_id_t page_id, LatchMode mode, uint64_t wait_ns,
+                           bool contended) -> void {
+  Slot *slot = LocalSlot();
+  int m = static_cast<int>(mode);
+  Counters &counters = level == kRootLevel
+                           ? slot->root[m]
+                           : slot->levels[std::clamp(level, 0, kMaxLevels - 1)][m];
+  counters.acquisitions.fetch_add(1, std::memory_order_relaxed);
+  if (!contended) {
+    return;
+  }
+  counters.contended.fetch_add(1, std::memory_order_relaxed);
+  counters.wait_ns.fetch_add(wait_ns, std::memory_order_relaxed);
+  uint64_t current = counters.max_wait_ns.load(std::memory_order_relaxed);
+  while (wait_ns > current &&
+         !counters.max_wait_ns.compare_exchange_weak(current, wait_ns,
+                                                     std::memory_order_relaxed)) {
+  }
+  if (page_id != INVALID_PAGE_ID) {
+    RecordPage(page_id, wait_ns);
+  }
+}
+
+auto LatchProfiler::RecordPage(page_id_t page_id, uint64_t wait_ns) -> void {
+  uint32_t hash = static_cast<uint32_t>(page_id) * 2654435761u;
+  for (int i = 0; i < PAGE_TABLE_PROBES; i++) {
+    PageEntry &entry = pages_[(hash + i) % kPageTableSize];
+    page_id_t current = entry.page_id.load(std::memory_order_relaxed);
+    if (current == INVALID_PAGE_ID) {
+      // 占用空位；失败说明别的线程刚刚占用，current 变为它写入的页面 id
+      entry.page_id.compare_exchange_strong(current, page_id, std::memory_order_relaxed);
+      current = entry.page_id.load(std::memory_order_relaxed);
+    }
+    if (current == page_id) {
+      entry.contended.fetch_add(1, std::memory_order_relaxed);
+      entry.wait_ns.fetch_add(wait_ns, std::memory_order_relaxed);
+      return;
+    }
+  }
+  untracked_.fetch_add(1, std::memory_order_relaxed);
+}
+
+auto LatchProfiler::Snapshot(size_t top_pages) const -> LatchProfileSnapshot {
+  LatchProfileSnapshot snapshot;
+  snapshot.levels.resize(kMaxLevels);
+  auto merge = [](LatchStats *dst, const Counters &src) {
+    dst->acquisitions += src.acquisitions.load(std::memory_order_relaxed);
+    dst->contended += src.contended.load(std::memory_order_relaxed);
+    dst->wait_ns += src.wait_ns.load(std::memory_order_relaxed);
+    dst->max_wait_ns =
+        std::max(dst->max_wait_ns, src.max_wait_ns.load(std::memory_order_relaxed));
+  };
+  for (const auto &entry : slots_) {
+    const Slot *slot = entry.load(std::memory_order_acquire);
+    if (slot == nullptr) {
+      continue;
+    }
+    for (int m = 0; m < 2; m++) {
+      merge(&snapshot.root[m], slot->root[m]);
+      for (int level = 0; level < kMaxLevels; level++) {
+        merge(&snapshot.levels[level][m], slot->levels[level][m]);
+      }
+    }
+  }
+  // 去掉末尾没有访问过的层
+  while (!snapshot.levels.empty() && snapshot.levels.back()[0].acquisitions == 0 &&
+         snapshot.levels.back()[1].acquisitions == 0) {
+    snapshot.levels.pop_back();
+  }
+
+  for (int i = 0; i < kPageTableSize; i++) {
+    page_id_t page_id = pages_[i].page_id.load(std::memory_order_relaxed);
+    if (page_id != INVALID_PAGE_ID) {
+      snapshot.top_pages.push_back({page_id, pages_[i].contended.load(std::memory_order_relaxed),
+                                    pages_[i].wait_ns.load(std::memory_order_relaxed)});
+    }
+  }
+  auto by_wait = [](const LatchProfileSnapshot::HotPage &a,
+                    const LatchProfileSnapshot::HotPage &b) { return a.wait_ns > b.wait_ns; };
+  if (snapshot.top_pages.size() > top_pages) {
+    std::partial_sort(snapshot.top_pages.begin(), snapshot.top_pages.begin() + top_pages,
+                      snapshot.top_pages.end(), by_wait);
+    snapshot.top_pages.resize(top_pages);
+  } else {
+    std::sort(snapshot.top_pages.begin(), snapshot.top_pages.end(), by_wait);
+  }
+  snapshot.untracked_contentions = untracked_.load(std::memory_order_relaxed);
+  return snapshot;
+}
+
+auto LatchProfiler::Reset() -> void {
+  auto clear = [](Counters *counters) {
+    counters->acquisitions.store(0, std::memory_order_relaxed);
+    counters->contended.store(0, std::memory_order_relaxed);
+    counters->wait_ns.store(0, std::memory_order_relaxed);
+    counters->max_wait_ns.store(0, std::memory_order_relaxed);
+  };
+  for (auto &entry : slots_) {
+    Slot *slot = entry.load(std::memory_order_acquire);
+    if (slot == nullptr) {
+      continue;
+    }
+    for (int m = 0; m < 2; m++) {
+      clear(&slot->root[m]);
+      for (auto &level : slot->levels) {
+        clear(&level[m]);
+      }
+    }
+  }
+  for (int i = 0; i < kPageTableSize; i++) {
+    pages_[i].page_id.store(INVALID_PAGE_ID, std::memory_order_relaxed);
+    pages_[i].contended.store(0, std::memory_order_relaxed);
+    pages_[i].wait_ns.store(0, std::memory_order_relaxed);
+  }
+  untracked_.store(0, std::memory_order_relaxed);
+}
+
+auto LatchProfileSnapshot::ToString() const -> std::string {
+  std::ostringstream out;
+  auto row = [&out](const std::string &name, const char *mode, const LatchStats &stats) {
+    out << std::left << std::setw(8) << name << std::setw(6) << mode << std::right
+        << std::setw(14) << stats.acquisitions << std::setw(12) << stats.contended
+        << std::setw(10) << std::fixed << std::setprecision(2) << stats.ContentionRate() * 100
+        << "%" << std::setw(14) << stats.wait_ns / 1000 << std::setw(12)
+        << stats.max_wait_ns / 1000 << "\n";
+  };
+  out << std::left << std::setw(8) << "latch" << std::setw(6) << "mode" << std::right
+      << std::setw(14) << "acquired" << std::setw(12) << "contended" << std::setw(11) << "rate"
+      << std::setw(14) << "wait(us)" << std::setw(12) << "max(us)" << "\n";
+  row("root", "S", root[0]);
+  row("root", "X", root[1]);
+  for (size_t level = 0; level < levels.size(); level++) {
+    row("L" + std::to_string(level), "S", levels[level][0]);
+    row("L" + std::to_string(level), "X", levels[level][1]);
+  }
+  out << "top contended pages:\n";
+  for (const auto &page : top_pages) {
+    out << "  page " << std::setw(10) << page.page_id << std::setw(12) << page.contended
+        << " waits" << std::setw(14) << page.wait_ns / 1000 << " us\n";
+  }
+  if (untracked_contentions > 0) {
+    out << "  (" << untracked_contentions << " contentions on untracked pages)\n";
+  }
+  return out.str();
+}
+
+}  // namespace mybplus
@@ -1,5 +1,6 @@
 #include "b_plus_tree_leaf.h"
 
+#include <algorithm>
 #include <cassert>
 #include <sstream>
 
@@ -58,12 +59,11 @@ auto B_PLUS_TREE_LEAF_PAGE_TYPE::Insert(const KeyType &key, const ValueType &val
     return false;  // 键重复
   }
 
-  array_.insert(array_.begin() + index, MappingType{key, value});
+  // 在固定大小的数组内后移，不再让 vector 增长
+  std::move_backward(array_.begin() + index, array_.begin() + size, array_.begin() + size + 1);
+  array_[index] = MappingType{key, value};
 
   IncreaseSize(1);
-  // if (GetSize() > GetMaxSize()) {
-  //   array_.resize(GetMaxSize());
-  // }
   return true;
 }
 
@@ -92,12 +92,23 @@ auto B_PLUS_TREE_LEAF_PAGE_TYPE::FindValue(const KeyType &key, const KeyComparat
   return false;  // 没找到完全匹配的键
 }
 
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::KeyIndex(const KeyType &key, const KeyComparator &comparator) const
+    -> int {
+  auto compare_first = [&comparator](const MappingType &lhs, const KeyType &rhs) -> bool {
+    return comparator(lhs.first, rhs) < 0;
+  };
+  auto it = std::lower_bound(array_.begin(), array_.begin() + GetSize(), key, compare_first);
+  return std::distance(array_.begin(), it);
+}
+
 INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_LEAF_PAGE_TYPE::InsertFirst(const KeyType &key, const ValueType &value) -> bool {
   if (GetSize() >= GetMaxSize()) {
     return false;
   }
-  array_.insert(array_.begin(), MappingType{key, value});
+  std::move_backward(array_.begin(), array_.begin() + GetSize(), array_.begin() + GetSize() + 1);
+  array_[0] = MappingType{key, value};
   IncreaseSize(1);
 
   return true;
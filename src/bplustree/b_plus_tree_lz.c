@@ -0,0 +1,194 @@
+#include "b_plus_tree_lz.h"
+
+#include <limits.h>
+#include <string.h>
+
+#define LZ_MIN_MATCH 4
+#define LZ_LAST_LITERALS 5  // 块末尾必须是字面量
+#define LZ_MF_LIMIT 12      // 最后一个匹配必须在距离末尾 12 字节之前开始
+#define LZ_MAX_OFFSET 65535
+#define LZ_HASH_LOG 12
+#define LZ_SKIP_TRIGGER 6  // 连续未命中时加大步长
+
+static uint32_t read32(const uint8_t *p) {
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static uint32_t lz_hash(uint32_t sequence) {
+  return (sequence * 2654435761u) >> (32 - LZ_HASH_LOG);
+}
+
+int lz_compress_bound(int src_size) {
+  return src_size + src_size / 255 + 16;
+}
+
+// 写出长度的扩展字节
+static uint8_t *write_length(uint8_t *op, int len) {
+  while (len >= 255) {
+    *op++ = 255;
+    len -= 255;
+  }
+  *op++ = (uint8_t)len;
+  return op;
+}
+
+static uint8_t *write_literals(uint8_t *op, uint8_t *token, const uint8_t *anchor, int lit_len) {
+  if (lit_len >= 15) {
+    *token = 15 << 4;
+    op = write_length(op, lit_len - 15);
+  } else {
+    *token = (uint8_t)(lit_len << 4);
+  }
+  memcpy(op, anchor, lit_len);
+  return op + lit_len;
+}
+
+int lz_compress(const uint8_t *src, int src_size, uint8_t *dst, int dst_capacity) {
+  const uint8_t *ip = src;
+  const uint8_t *anchor = src;
+  const uint8_t *iend = src + src_size;
+  const uint8_t *mflimit = iend - LZ_MF_LIMIT;
+  const uint8_t *matchlimit = iend - LZ_LAST_LITERALS;
+  uint8_t *op = dst;
+  uint8_t *oend = dst + dst_capacity;
+
+  // 表中存放位置 + 1，0 表示空
+  uint32_t table[1 << LZ_HASH_LOG];
+  memset(table, 0, sizeof(table));
+
+  if (src_size >= LZ_MF_LIMIT + 1) {
+    uint32_t misses = 0;
+    while (ip < mflimit) {
+      uint32_t sequence = read32(ip);
+      uint32_t h = lz_hash(sequence);
+      uint32_t candidate = table[h];
+      table[h] = (uint32_t)(ip - src) + 1;
+
+      if (candidate == 0 || (uint32_t)(ip - src) + 1 - candidate > LZ_MAX_OFFSET ||
+          read32(src + candidate - 1) != sequence) {
+        ip += 1 + (misses++ >> LZ_SKIP_TRIGGER);
+        continue;
+      }
+      misses = 0;
+
+      const uint8_t *ref = src + candidate - 1;
+      int match_len = LZ_MIN_MATCH;
+      while (ip + match_len < matchlimit && ref[match_len] == ip[match_len]) {
+        match_len++;
+      }
+
+      int lit_len = (int)(ip - anchor);
+      // token + 字面量 + 偏移 + 两段长度扩展字节
+      if (op + 1 + lit_len + lit_len / 255 + 2 + match_len / 255 + 2 > oend) {
+        return 0;
+      }
+      uint8_t *token = op++;
+      op = write_literals(op, token, anchor, lit_len);
+
+      uint16_t offset = (uint16_t)(ip - ref);
+      *op++ = (uint8_t)(offset & 0xFF);
+      *op++ = (uint8_t)(offset >> 8);
+
+      int ml = match_len - LZ_MIN_MATCH;
+      if (ml >= 15) {
+        *token |= 15;
+        op = write_length(op, ml - 15);
+      } else {
+        *token |= (uint8_t)ml;
+      }
+
+      ip += match_len;
+      anchor = ip;
+    }
+  }
+
+  // 最后一段字面量
+  int lit_len = (int)(iend - anchor);
+  if (op + 1 + lit_len + lit_len / 255 + 1 > oend) {
+    return 0;
+  }
+  uint8_t *token = op++;
+  op = write_literals(op, token, anchor, lit_len);
+  return (int)(op - dst);
+}
+
+// 读取长度的扩展字节，失败返回 -1；长度超出 int 范围时按输入损坏处理
+static int read_length(const uint8_t **ip, const uint8_t *iend) {
+  int len = 0;
+  uint8_t b;
+  do {
+    if (*ip >= iend || len > INT_MAX - 255 - 15) {
+      return -1;
+    }
+    b = *(*ip)++;
+    len += b;
+  } while (b == 255);
+  return len;
+}
+
+int lz_decompress(const uint8_t *src, int src_size, uint8_t *dst, int dst_capacity) {
+  const uint8_t *ip = src;
+  const uint8_t *iend = src + src_size;
+  uint8_t *op = dst;
+  uint8_t *oend = dst + dst_capacity;
+
+  while (ip < iend) {
+    uint8_t token = *ip++;
+
+    int lit_len = token >> 4;
+    if (lit_len == 15) {
+      int extra = read_length(&ip, iend);
+      if (extra < 0) {
+        return -1;
+      }
+      lit_len += extra;
+    }
+    if (lit_len > iend - ip || lit_len > oend - op) {
+      return -1;
+    }
+    memcpy(op, ip, lit_len);
+    ip += lit_len;
+    op += lit_len;
+
+    // 最后一个序列只有字面量
+    if (ip == iend) {
+      break;
+    }
+
+    if (iend - ip < 2) {
+      return -1;
+    }
+    int offset = ip[0] | (ip[1] << 8);
+    ip += 2;
+    if (offset == 0 || offset > op - dst) {
+      return -1;
+    }
+
+    int match_len = token & 15;
+    if (match_len == 15) {
+      int extra = read_length(&ip, iend);
+      if (extra < 0) {
+        return -1;
+      }
+      match_len += extra;
+    }
+    match_len += LZ_MIN_MATCH;
+    if (match_len > oend - op) {
+      return -1;
+    }
+
+    const uint8_t *match = op - offset;
+    if (offset >= match_len) {
+      memcpy(op, match, match_len);
+      op += match_len;
+    } else {
+      // 重叠拷贝，用于重复模式
+      for (int i = 0; i < match_len; i++) {
+        *op++ = *match++;
+      }
+    }
+  }
+  return (int)(op - dst);
+}
@@ -0,0 +1,242 @@
+#include "b_plus_tree_metrics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+namespace mybplus {
+
+auto MetricOpName(MetricOp op) -> const char * {
+  switch (op) {
+    case MetricOp::GET:
+      return "get";
+    case MetricOp::INSERT:
+      return "insert";
+    case MetricOp::REMOVE:
+      return "remove";
+    case MetricOp::UPDATE:
+      return "update";
+    case MetricOp::SCAN:
+      return "scan";
+    default:
+      return "unknown";
+  }
+}
+
+auto MetricCounterName(MetricCounter counter) -> const char * {
+  switch (counter) {
+    case MetricCounter::LEAF_SPLIT:
+      return "leaf_splits";
+    case MetricCounter::INTERNAL_SPLIT:
+      return "internal_splits";
+    case MetricCounter::LEAF_MERGE:
+      return "leaf_merges";
+    case MetricCounter::INTERNAL_MERGE:
+      return "internal_merges";
+    case MetricCounter::LEAF_BORROW:
+      return "leaf_borrows";
+    case MetricCounter::INTERNAL_BORROW:
+      return "internal_borrows";
+    case MetricCounter::RESTART:
+      return "restarts";
+    case MetricCounter::PAGE_ALLOC:
+      return "pages_allocated";
+    case MetricCounter::PAGE_FREE:
+      return "pages_freed";
+    case MetricCounter::APPEND_HIT:
+      return "append_hits";
+    case MetricCounter::FINGER_HIT:
+      return "finger_hits";
+    default:
+      return "unknown";
+  }
+}
+
+/*****************************************************************************
+ * HISTOGRAM
+ *****************************************************************************/
+
+auto HistogramSnapshot::BucketIndex(uint64_t value) -> int {
+  // 小于 2 * kSubBucketCount 的值一一对应
+  if (value < 2 * kSubBucketCount) {
+    return static_cast<int>(value);
+  }
+  int exponent = 63 - __builtin_clzll(value);
+  if (exponent > kMaxExponent) {
+    return kBucketCount - 1;
+  }
+  int sub = static_cast<int>((value >> (exponent - kSubBucketBits)) & (kSubBucketCount - 1));
+  return (exponent - kSubBucketBits + 1) * kSubBucketCount + sub;
+}
+
+auto HistogramSnapshot::BucketUpperBound(int index) -> uint64_t {
+  if (index < 2 * kSubBucketCount) {
+    return static_cast<uint64_t>(index);
+  }
+  int exponent = index / kSubBucketCount + kSubBucketBits - 1;
+  uint64_t sub = index % kSubBucketCount;
+  uint64_t width = 1ULL << (exponent - kSubBucketBits);
+  return ((kSubBucketCount + sub) << (exponent - kSubBucketBits)) + width - 1;
+}
+
+auto HistogramSnapshot::Percentile(double q) const -> uint64_t {
+  if (count == 0) {
+    return 0;
+  }
+  auto target = static_cast<uint64_t>(std::ceil(std::clamp(q, 0.0, 1.0) * count));
+  target = std::max<uint64_t>(target, 1);
+  uint64_t seen = 0;
+  for (int i = 0; i < kBucketCount; i++) {
+    seen += buckets[i];
+    if (seen >= target) {
+      // 桶上界可能超过实际记录到的最大值
+      return std::clamp(BucketUpperBound(i), min, max);
+    }
+  }
+  return max;
+}
+
+auto HistogramSnapshot::Record(uint64_t value) -> void {
+  buckets[BucketIndex(value)]++;
+  min = count == 0 ? value : std::min(min, value);
+  max = std::max(max, value);
+  count++;
+  sum += value;
+}
+
+auto HistogramSnapshot::Merge(const HistogramSnapshot &other) -> void {
+  if (other.count == 0) {
+    return;
+  }
+  for (int i = 0; i < kBucketCount; i++) {
+    buckets[i] += other.buckets[i];
+  }
+  min = count == 0 ? other.min : std::min(min, other.min);
+  max = std::max(max, other.max);
+  count += other.count;
+  sum += other.sum;
+}
+
+auto MetricsSnapshot::ToString() const -> std::string {
+  std::ostringstream out;
+  out << std::left << std::setw(10) << "op" << std::right << std::setw(12) << "count"
+      << std::setw(12) << "mean(ns)" << std::setw(10) << "p50" << std::setw(10) << "p90"
+      << std::setw(10) << "p99" << std::setw(10) << "p999" << std::setw(12) << "max" << "\n";
+  for (int i = 0; i < kMetricOpCount; i++) {
+    const HistogramSnapshot &h = latency[i];
+    out << std::left << std::setw(10) << MetricOpName(static_cast<MetricOp>(i)) << std::right
+        << std::setw(12) << h.count << std::setw(12) << std::fixed << std::setprecision(1)
+        << h.Mean() << std::setw(10) << h.Percentile(0.5) << std::setw(10) << h.Percentile(0.9)
+        << std::setw(10) << h.Percentile(0.99) << std::setw(10) << h.Percentile(0.999)
+        << std::setw(12) << h.max << "\n";
+  }
+  for (int i = 0; i < kMetricCounterCount; i++) {
+    out << std::left << std::setw(20) << MetricCounterName(static_cast<MetricCounter>(i))
+        << std::right << counters[i] << "\n";
+  }
+  return out.str();
+}
+
+/*****************************************************************************
+ * TREE METRICS
+ *****************************************************************************/
+
+TreeMetrics::~TreeMetrics() {
+  for (auto &slot : slots_) {
+    delete slot.load(std::memory_order_relaxed);
+  }
+}
+
+auto TreeMetrics::LocalSlot() -> Slot * {
+  // 线程按创建顺序分配槽位，超过 kMaxSlots 个线程时共享槽位（计数仍是原子的）
+  static std::atomic<uint32_t> next_thread_index{0};
+  thread_local uint32_t thread_index =
+      next_thread_index.fetch_add(1, std::memory_order_relaxed) % kMaxSlots;
+
+  std::atomic<Slot *> &entry = slots_[thread_index];
+  Slot *slot = entry.load(std::memory_order_acquire);
+  if (slot != nullptr) {
+    return slot;
+  }
+  auto *created = new Slot();
+  if (entry.compare_exchange_strong(slot, created, std::memory_order_acq_rel)) {
+    return created;
+  }
+  delete created;
+  return slot;
+}
+
+auto TreeMetrics::RecordLatency(MetricOp op, uint64_t nanos) -> void {
+  if (!IsEnabled()) {
+    return;
+  }
+  Histogram &h = LocalSlot()->latency[static_cast<int>(op)];
+  h.buckets[HistogramSnapshot::BucketIndex(nanos)].fetch_add(1, std::memory_order_relaxed);
+  h.count.fetch_add(1, std::memory_order_relaxed);
+  h.sum.fetch_add(nanos, std::memory_order_relaxed);
+  uint64_t current = h.min.load(std::memory_order_relaxed);
+  while (nanos < current &&
+         !h.min.compare_exchange_weak(current, nanos, std::memory_order_relaxed)) {
+  }
+  current = h.max.load(std::memory_order_relaxed);
+  while (nanos > current &&
+         !h.max.compare_exchange_weak(current, nanos, std::memory_order_relaxed)) {
+  }
+}
+
+auto TreeMetrics::Snapshot() const -> MetricsSnapshot {
+  MetricsSnapshot snapshot;
+  for (auto &h : snapshot.latency) {
+    h.min = UINT64_MAX;
+  }
+  for (const auto &entry : slots_) {
+    const Slot *slot = entry.load(std::memory_order_acquire);
+    if (slot == nullptr) {
+      continue;
+    }
+    for (int i = 0; i < kMetricCounterCount; i++) {
+      snapshot.counters[i] += slot->counters[i].load(std::memory_order_relaxed);
+    }
+    for (int op = 0; op < kMetricOpCount; op++) {
+      const Histogram &src = slot->latency[op];
+      HistogramSnapshot &dst = snapshot.latency[op];
+      for (int i = 0; i < HistogramSnapshot::kBucketCount; i++) {
+        dst.buckets[i] += src.buckets[i].load(std::memory_order_relaxed);
+      }
+      dst.count += src.count.load(std::memory_order_relaxed);
+      dst.sum += src.sum.load(std::memory_order_relaxed);
+      dst.min = std::min(dst.min, src.min.load(std::memory_order_relaxed));
+      dst.max = std::max(dst.max, src.max.load(std::memory_order_relaxed));
+    }
+  }
+  for (auto &h : snapshot.latency) {
+    if (h.count == 0) {
+      h.min = 0;
+    }
+  }
+  return snapshot;
+}
+
+auto TreeMetrics::Reset() -> void {
+  for (auto &entry : slots_) {
+    Slot *slot = entry.load(std::memory_order_acquire);
+    if (slot == nullptr) {
+      continue;
+    }
+    for (auto &counter : slot->counters) {
+      counter.store(0, std::memory_order_relaxed);
+    }
+    for (auto &h : slot->latency) {
+      for (auto &bucket : h.buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+      }
+      h.count.store(0, std::memory_order_relaxed);
+      h.sum.store(0, std::memory_order_relaxed);
+      h.min.store(UINT64_MAX, std::memory_order_relaxed);
+      h.max.store(0, std::memory_order_relaxed);
+    }
+  }
+}
+
+}  // namespace mybplus
@@ -1,5 +1,14 @@
 #include "b_plus_tree_serializer.h"
 
+#include <pthread.h>
+#include <stddef.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "b_plus_tree_codec.h"
+#include "b_plus_tree_crc32c.h"
+#include "b_plus_tree_lz.h"
+
 Queue *queue_create() {
   Queue *q = (Queue *)malloc(sizeof(Queue));
   q->front = q->rear = NULL;
@@ -50,6 +59,10 @@ BPlusTreeSerializer *serializer_create(CBPlusTree *tree, const char *storage_pat
   BPlusTreeSerializer *serializer = (BPlusTreeSerializer *)malloc(sizeof(BPlusTreeSerializer));
   serializer->tree = tree;
   serializer->storage_path = strdup(storage_path);
+  serializer->flags = 0;
+  serializer->threads = 0;
+  serializer->fill_factor = 1.0;
+  serializer->verify = true;
   return serializer;
 }
 
@@ -61,6 +74,870 @@ void serializer_destroy(BPlusTreeSerializer *serializer) {
   }
 }
 
+void serializer_set_flags(BPlusTreeSerializer *serializer, uint32_t flags) {
+  serializer->flags = flags;
+}
+
+void serializer_set_threads(BPlusTreeSerializer *serializer, int threads) {
+  serializer->threads = threads;
+}
+
+void serializer_set_fill_factor(BPlusTreeSerializer *serializer, double fill_factor) {
+  if (fill_factor < SERIALIZER_MIN_FILL_FACTOR) {
+    fill_factor = SERIALIZER_MIN_FILL_FACTOR;
+  } else if (fill_factor > 1.0) {
+    fill_factor = 1.0;
+  }
+  serializer->fill_factor = fill_factor;
+}
+
+void serializer_set_verify(BPlusTreeSerializer *serializer, bool verify) {
+  serializer->verify = verify;
+}
+
+/*****************************************************************************
+ * 页面编码/解码
+ *****************************************************************************/
+
+// 可增长的字节缓冲区，一个页面先完整编码到这里再一次性写出
+typedef struct {
+  uint8_t *data;
+  size_t size;
+  size_t capacity;
+} ByteBuffer;
+
+static bool buffer_reserve(ByteBuffer *buffer, size_t capacity) {
+  if (capacity <= buffer->capacity) {
+    return true;
+  }
+  size_t new_capacity = buffer->capacity ? buffer->capacity : 4096;
+  while (new_capacity < capacity) {
+    new_capacity *= 2;
+  }
+  uint8_t *data = (uint8_t *)realloc(buffer->data, new_capacity);
+  if (!data) {
+    return false;
+  }
+  buffer->data = data;
+  buffer->capacity = new_capacity;
+  return true;
+}
+
+static bool buffer_append(ByteBuffer *buffer, const void *src, size_t n) {
+  if (!buffer_reserve(buffer, buffer->size + n)) {
+    return false;
+  }
+  memcpy(buffer->data + buffer->size, src, n);
+  buffer->size += n;
+  return true;
+}
+
+static void buffer_free(ByteBuffer *buffer) {
+  free(buffer->data);
+  buffer->data = NULL;
+  buffer->size = buffer->capacity = 0;
+}
+
+// 从文件或内存中顺序读取
+typedef struct {
+  FILE *file;
+  const uint8_t *data;
+  size_t size;
+  size_t pos;
+  bool track_crc;  // 为 true 时把读出的字节累计到 crc 中
+  uint32_t crc;
+} ByteReader;
+
+static bool reader_read(ByteReader *reader, void *dst, size_t n) {
+  if (reader->file) {
+    if (n != 0 && fread(dst, n, 1, reader->file) != 1) {
+      return false;
+    }
+  } else {
+    if (reader->size - reader->pos < n) {
+      return false;
+    }
+    memcpy(dst, reader->data + reader->pos, n);
+    reader->pos += n;
+  }
+  if (reader->track_crc) {
+    reader->crc = crc32c_extend(reader->crc, dst, n);
+  }
+  return true;
+}
+
+// 读取时的公共参数
+typedef struct {
+  CBPlusTree *tree;  // 为 NULL 时只检查文件，不创建页面
+  const FileHeader *header;
+  bool verify;  // 是否校验页面校验和
+} LoadOptions;
+
+// 开始读取一个页面记录
+static void record_begin(const LoadOptions *options, ByteReader *reader) {
+  reader->track_crc = options->verify && (options->header->flags & SERIALIZER_FLAG_CHECKSUM);
+  reader->crc = 0;
+}
+
+// 读完一个页面记录，CHECKSUM 格式下读出并比较记录之后的校验和
+static bool record_end(const LoadOptions *options, ByteReader *reader, page_id_t page_id) {
+  if (!(options->header->flags & SERIALIZER_FLAG_CHECKSUM)) {
+    return true;
+  }
+  bool tracked = reader->track_crc;
+  uint32_t actual = reader->crc;
+  reader->track_crc = false;
+  uint32_t expected;
+  if (!reader_read(reader, &expected, sizeof(expected))) {
+    return false;
+  }
+  if (tracked && expected != actual) {
+    fprintf(stderr, "Deserialization failed: Checksum mismatch in page %d\n", (int)page_id);
+    return false;
+  }
+  return true;
+}
+
+// 编解码时复用的临时列
+typedef struct {
+  KeyType *keys;
+  ValueType *values;
+  uint8_t *packed;
+  int capacity;
+} PageScratch;
+
+static bool scratch_reserve(PageScratch *scratch, int count) {
+  if (count <= scratch->capacity) {
+    return true;
+  }
+  KeyType *keys = (KeyType *)realloc(scratch->keys, sizeof(KeyType) * count);
+  if (keys) {
+    scratch->keys = keys;
+  }
+  ValueType *values = (ValueType *)realloc(scratch->values, sizeof(ValueType) * count);
+  if (values) {
+    scratch->values = values;
+  }
+  uint8_t *packed = (uint8_t *)realloc(scratch->packed, sizeof(KeyType) * count);
+  if (packed) {
+    scratch->packed = packed;
+  }
+  if (!keys || !values || !packed) {
+    return false;
+  }
+  scratch->capacity = count;
+  return true;
+}
+
+static void scratch_free(PageScratch *scratch) {
+  free(scratch->keys);
+  free(scratch->values);
+  free(scratch->packed);
+  memset(scratch, 0, sizeof(PageScratch));
+}
+
+static bool encode_leaf_columns(PageScratch *scratch, int size, ByteBuffer *out) {
+  if (size == 0) {
+    return true;
+  }
+  int width = codec_key_width(scratch->keys, size);
+  uint8_t width_byte = (uint8_t)width;
+  codec_encode_keys(scratch->keys, size, width, scratch->packed);
+  return buffer_append(out, &scratch->keys[0], sizeof(KeyType)) &&
+         buffer_append(out, &width_byte, sizeof(width_byte)) &&
+         buffer_append(out, scratch->packed, codec_keys_size(size, width)) &&
+         buffer_append(out, scratch->values, sizeof(ValueType) * size);
+}
+
+static bool decode_leaf_columns(ByteReader *reader, PageScratch *scratch, int size) {
+  if (size == 0) {
+    return true;
+  }
+  KeyType base;
+  uint8_t width;
+  if (!reader_read(reader, &base, sizeof(KeyType)) ||
+      !reader_read(reader, &width, sizeof(width))) {
+    return false;
+  }
+  if (width != 0 && width != 1 && width != 2 && width != 4 && width != 8) {
+    return false;
+  }
+  if (!reader_read(reader, scratch->packed, codec_keys_size(size, width)) ||
+      !reader_read(reader, scratch->values, sizeof(ValueType) * size)) {
+    return false;
+  }
+  codec_decode_keys(scratch->packed, size, base, width, scratch->keys);
+  return true;
+}
+
+/**
+ * 将一个页面编码追加到 out 中；内部页面的子页面会被加入 children 队列。
+ */
+static bool encode_page(CBPlusTreePage *page, uint32_t flags, PageScratch *scratch,
+                        ByteBuffer *out, Queue *children) {
+  PageHeader page_header;
+  memset(&page_header, 0, sizeof(PageHeader));
+  page_header.page_id = page_get_id(page);
+  page_header.page_type = page_is_leaf(page) ? 1 : 2;
+  page_header.size = page_get_size(page);
+  if (!buffer_append(out, &page_header, sizeof(PageHeader))) {
+    return false;
+  }
+
+  if (page_is_leaf(page)) {
+    if (!scratch_reserve(scratch, page_header.size)) {
+      return false;
+    }
+    leaf_page_get_columns(page, scratch->keys, scratch->values);
+    if (flags & SERIALIZER_FLAG_ENCODED) {
+      if (!encode_leaf_columns(scratch, page_header.size, out)) {
+        return false;
+      }
+    } else {
+      // 原始格式：键值对交替存放
+      for (int i = 0; i < page_header.size; i++) {
+        if (!buffer_append(out, &scratch->keys[i], sizeof(KeyType)) ||
+            !buffer_append(out, &scratch->values[i], sizeof(ValueType))) {
+          return false;
+        }
+      }
+    }
+    // 写入下一页指针
+    page_id_t next_page_id = leaf_page_get_next_id(page);
+    return buffer_append(out, &next_page_id, sizeof(page_id_t));
+  }
+
+  // 内部页面：写入键和子页面指针
+  for (int i = 0; i < page_header.size; i++) {
+    page_id_t child_page_id = internal_page_get_value_at(page, i);
+    if (!buffer_append(out, &child_page_id, sizeof(page_id_t))) {
+      return false;
+    }
+    // 第一个位置没有键
+    if (i > 0) {
+      KeyType key = internal_page_get_key_at(page, i);
+      if (!buffer_append(out, &key, sizeof(KeyType))) {
+        return false;
+      }
+    }
+    if (children) {
+      queue_push(children, child_page_id);
+    }
+  }
+  return true;
+}
+
+// 读出叶子页面的键值列和下一页指针到 scratch
+static bool decode_leaf_payload(ByteReader *reader, uint32_t flags, PageScratch *scratch,
+                                int size, page_id_t *next_page_id) {
+  if (!scratch_reserve(scratch, size)) {
+    return false;
+  }
+  if (flags & SERIALIZER_FLAG_ENCODED) {
+    if (!decode_leaf_columns(reader, scratch, size)) {
+      return false;
+    }
+  } else {
+    for (int j = 0; j < size; ++j) {
+      if (!reader_read(reader, &scratch->keys[j], sizeof(KeyType)) ||
+          !reader_read(reader, &scratch->values[j], sizeof(ValueType))) {
+        return false;
+      }
+    }
+  }
+  return reader_read(reader, next_page_id, sizeof(page_id_t));
+}
+
+/**
+ * 从 reader 中读出一个页面并注册到树中；options->tree 为 NULL 时只检查页面记录。
+ */
+static bool decode_page(const LoadOptions *options, ByteReader *reader, PageScratch *scratch) {
+  const FileHeader *header = options->header;
+  PageHeader p_header;
+  record_begin(options, reader);
+  if (!reader_read(reader, &p_header, sizeof(PageHeader))) {
+    return false;
+  }
+  bool is_leaf = p_header.page_type == 1;
+  int max_size = is_leaf ? header->leaf_max_size : header->internal_max_size;
+  if ((p_header.page_type != 1 && p_header.page_type != 2) || p_header.size < 0 ||
+      p_header.size > max_size) {
+    return false;
+  }
+
+  CBPlusTreePage *page = NULL;
+  if (options->tree) {
+    // 并行读入时其他线程正在注册页面，不能再用 get_page 查页表
+    page = bpt_create_page_with_id(options->tree, p_header.page_id, is_leaf);
+    bpt_page_set_size(page, p_header.size);
+  }
+
+  if (is_leaf) {
+    page_id_t next_page_id;
+    if (!decode_leaf_payload(reader, header->flags, scratch, p_header.size, &next_page_id)) {
+      return false;
+    }
+    if (page) {
+      leaf_page_set_columns(page, scratch->keys, scratch->values, p_header.size);
+      leaf_page_set_next_id(page, next_page_id);
+    }
+    return record_end(options, reader, p_header.page_id);
+  }
+
+  for (int j = 0; j < p_header.size; ++j) {
+    page_id_t child_id;
+    if (!reader_read(reader, &child_id, sizeof(page_id_t))) {
+      return false;
+    }
+    if (page) {
+      internal_page_set_value_at(page, j, child_id);
+    }
+
+    if (j > 0) {
+      KeyType key;
+      if (!reader_read(reader, &key, sizeof(KeyType))) {
+        return false;
+      }
+      if (page) {
+        internal_page_set_key_at(page, j, key);
+      }
+    }
+  }
+  return record_end(options, reader, p_header.page_id);
+}
+
+/*****************************************************************************
+ * 块压缩
+ *****************************************************************************/
+
+// 单个块解压后的上限，用于拒绝损坏的块头
+#define MAX_BLOCK_SIZE (1u << 30)
+
+// 页面写出器：未压缩时逐页写出，压缩时攒够一个块再写出
+typedef struct {
+  FILE *file;
+  ByteBuffer *sink;  // file 为 NULL 时写入内存（并行写出的段）
+  uint32_t flags;
+  ByteBuffer pages;  // 当前块中已编码的页面
+  ByteBuffer compressed;
+  uint32_t page_count;  // 当前块中的页面数
+} PageWriter;
+
+static bool writer_output(PageWriter *writer, const void *data, size_t n) {
+  if (writer->file) {
+    return n == 0 || fwrite(data, n, 1, writer->file) == 1;
+  }
+  return buffer_append(writer->sink, data, n);
+}
+
+static bool writer_flush(PageWriter *writer) {
+  if (writer->pages.size == 0) {
+    return true;
+  }
+  bool ok;
+  if (writer->flags & SERIALIZER_FLAG_COMPRESSED) {
+    BlockHeader block;
+    block.page_count = writer->page_count;
+    block.raw_size = (uint32_t)writer->pages.size;
+    block.stored_size = block.raw_size;
+    const uint8_t *data = writer->pages.data;
+
+    int bound = lz_compress_bound((int)writer->pages.size);
+    if (!buffer_reserve(&writer->compressed, bound)) {
+      return false;
+    }
+    int compressed_size =
+        lz_compress(writer->pages.data, (int)writer->pages.size, writer->compressed.data, bound);
+    // 压缩后没有变小则原样存储
+    if (compressed_size > 0 && (uint32_t)compressed_size < block.raw_size) {
+      block.stored_size = (uint32_t)compressed_size;
+      data = writer->compressed.data;
+    }
+    ok = writer_output(writer, &block, sizeof(BlockHeader)) &&
+         writer_output(writer, data, block.stored_size);
+  } else {
+    ok = writer_output(writer, writer->pages.data, writer->pages.size);
+  }
+  writer->pages.size = 0;
+  writer->page_count = 0;
+  return ok;
+}
+
+/**
+ * 把一个页面编码到当前块中；CHECKSUM 格式下在页面记录之后追加它的 CRC32C。
+ * 校验和按未压缩的记录计算，压缩与否不影响校验。
+ */
+static bool writer_add_page(PageWriter *writer, CBPlusTreePage *page, PageScratch *scratch,
+                            Queue *children) {
+  size_t start = writer->pages.size;
+  if (!encode_page(page, writer->flags, scratch, &writer->pages, children)) {
+    return false;
+  }
+  if (writer->flags & SERIALIZER_FLAG_CHECKSUM) {
+    uint32_t crc = crc32c_extend(0, writer->pages.data + start, writer->pages.size - start);
+    if (!buffer_append(&writer->pages, &crc, sizeof(crc))) {
+      return false;
+    }
+  }
+  writer->page_count++;
+  if (!(writer->flags & SERIALIZER_FLAG_COMPRESSED) ||
+      writer->page_count >= SERIALIZER_PAGES_PER_BLOCK) {
+    return writer_flush(writer);
+  }
+  return true;
+}
+
+static void writer_free(PageWriter *writer) {
+  buffer_free(&writer->pages);
+  buffer_free(&writer->compressed);
+}
+
+// 页面读取器：压缩格式下按块读入并解压，再从内存中解码页面
+typedef struct {
+  ByteReader *source;
+  uint32_t flags;
+  ByteBuffer stored;
+  ByteBuffer raw;
+  ByteReader block;
+  uint32_t block_pages_left;
+} PageReader;
+
+static bool reader_load_block(PageReader *reader, uint32_t pages_left) {
+  BlockHeader block;
+  if (!reader_read(reader->source, &block, sizeof(BlockHeader)) || block.page_count == 0 ||
+      block.page_count > pages_left || block.raw_size > MAX_BLOCK_SIZE ||
+      block.stored_size > block.raw_size) {
+    return false;
+  }
+  if (!buffer_reserve(&reader->stored, block.stored_size) ||
+      !reader_read(reader->source, reader->stored.data, block.stored_size)) {
+    return false;
+  }
+
+  const uint8_t *data = reader->stored.data;
+  if (block.stored_size < block.raw_size) {
+    if (!buffer_reserve(&reader->raw, block.raw_size) ||
+        lz_decompress(reader->stored.data, (int)block.stored_size, reader->raw.data,
+                      (int)block.raw_size) != (int)block.raw_size) {
+      return false;
+    }
+    data = reader->raw.data;
+  }
+  reader->block.file = NULL;
+  reader->block.data = data;
+  reader->block.size = block.raw_size;
+  reader->block.pos = 0;
+  reader->block_pages_left = block.page_count;
+  return true;
+}
+
+/**
+ * 返回用于解码下一个页面的 ByteReader，pages_left 为包括该页面在内剩余的页面数。
+ */
+static ByteReader *reader_next_page(PageReader *reader, uint32_t pages_left) {
+  if (!(reader->flags & SERIALIZER_FLAG_COMPRESSED)) {
+    return reader->source;
+  }
+  if (reader->block_pages_left == 0) {
+    // 上一个块必须恰好被读完
+    if (reader->block.pos != reader->block.size || !reader_load_block(reader, pages_left)) {
+      return NULL;
+    }
+  }
+  reader->block_pages_left--;
+  return &reader->block;
+}
+
+static void page_reader_free(PageReader *reader) {
+  buffer_free(&reader->stored);
+  buffer_free(&reader->raw);
+}
+
+/*****************************************************************************
+ * 页面流
+ *****************************************************************************/
+
+/**
+ * 从 start_page_id 开始按 BFS 顺序写出页面；recursive 为 false 时只写出该页面本身。
+ */
+static bool write_page_stream(CBPlusTree *tree, page_id_t start_page_id, bool recursive,
+                              PageWriter *writer, PageScratch *scratch, uint32_t *page_count) {
+  Queue *queue = queue_create();
+  bool ok = true;
+  *page_count = 0;
+
+  queue_push(queue, start_page_id);
+  while (!queue_empty(queue)) {
+    page_id_t current_page_id = queue_pop(queue);
+
+    CBPlusTreePage *page = get_page(tree, current_page_id);
+    if (!page) {
+      continue;
+    }
+
+    if (!writer_add_page(writer, page, scratch, recursive ? queue : NULL)) {
+      ok = false;
+      break;
+    }
+    (*page_count)++;
+  }
+  ok = ok && writer_flush(writer);
+
+  queue_destroy(queue);
+  return ok;
+}
+
+static bool read_page_stream(const LoadOptions *options, ByteReader *source,
+                             uint32_t page_count, PageScratch *scratch) {
+  PageReader pages = {source, options->header->flags, {0}, {0}, {NULL, NULL, 0, 0, false, 0}, 0};
+  bool ok = true;
+  for (uint32_t i = 0; i < page_count; ++i) {
+    ByteReader *page_reader = reader_next_page(&pages, page_count - i);
+    if (!page_reader || !decode_page(options, page_reader, scratch)) {
+      fprintf(stderr, "Deserialization failed: Corrupted page %u\n", i);
+      ok = false;
+      break;
+    }
+  }
+  page_reader_free(&pages);
+  return ok;
+}
+
+/*****************************************************************************
+ * 并行段
+ *****************************************************************************/
+
+// 段表项，offset 为段数据在文件中的绝对位置
+typedef struct {
+  uint64_t offset;
+  uint64_t size;
+  uint32_t page_count;
+  uint32_t reserved;
+} SegmentEntry;
+
+typedef bool (*TaskFunc)(void *context, uint32_t index);
+
+typedef struct {
+  pthread_mutex_t mutex;
+  uint32_t next;
+  uint32_t count;
+  bool failed;
+  TaskFunc func;
+  void *context;
+} TaskPool;
+
+static void *task_pool_worker(void *arg) {
+  TaskPool *pool = (TaskPool *)arg;
+  for (;;) {
+    pthread_mutex_lock(&pool->mutex);
+    if (pool->failed || pool->next >= pool->count) {
+      pthread_mutex_unlock(&pool->mutex);
+      return NULL;
+    }
+    uint32_t index = pool->next++;
+    pthread_mutex_unlock(&pool->mutex);
+
+    if (!pool->func(pool->context, index)) {
+      pthread_mutex_lock(&pool->mutex);
+      pool->failed = true;
+      pthread_mutex_unlock(&pool->mutex);
+    }
+  }
+}
+
+/**
+ * 用最多 thread_count 个线程（包括调用线程）执行 count 个任务，任一任务失败则返回 false。
+ */
+static bool run_tasks(uint32_t count, int thread_count, TaskFunc func, void *context) {
+  TaskPool pool;
+  pthread_mutex_init(&pool.mutex, NULL);
+  pool.next = 0;
+  pool.count = count;
+  pool.failed = false;
+  pool.func = func;
+  pool.context = context;
+
+  if (thread_count > (int)count) {
+    thread_count = (int)count;
+  }
+  pthread_t *threads = NULL;
+  int started = 0;
+  if (thread_count > 1) {
+    threads = (pthread_t *)malloc(sizeof(pthread_t) * (thread_count - 1));
+    for (int i = 0; threads && i < thread_count - 1; i++) {
+      if (pthread_create(&threads[i], NULL, task_pool_worker, &pool) != 0) {
+        break;
+      }
+      started++;
+    }
+  }
+  task_pool_worker(&pool);
+  for (int i = 0; i < started; i++) {
+    pthread_join(threads[i], NULL);
+  }
+  free(threads);
+  pthread_mutex_destroy(&pool.mutex);
+  return !pool.failed;
+}
+
+static int resolve_thread_count(const BPlusTreeSerializer *serializer) {
+  if (serializer->threads > 0) {
+    return serializer->threads;
+  }
+  long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  return cpus > 0 ? (int)cpus : 1;
+}
+
+typedef struct {
+  CBPlusTree *tree;
+  CBPlusTreePage *root;
+  uint32_t flags;
+  const LoadOptions *options;  // 只在读取时使用
+  int fd;
+  ByteBuffer *buffers;
+  SegmentEntry *entries;
+} SegmentContext;
+
+// 阶段一：把根页面下第 index 个子树编码到内存
+static bool encode_segment_task(void *arg, uint32_t index) {
+  SegmentContext *context = (SegmentContext *)arg;
+  PageWriter writer = {NULL, &context->buffers[index], context->flags, {0}, {0}, 0};
+  PageScratch scratch = {0};
+  page_id_t child_page_id = internal_page_get_value_at(context->root, (int)index);
+  bool ok = write_page_stream(context->tree, child_page_id, true, &writer, &scratch,
+                              &context->entries[index].page_count);
+  writer_free(&writer);
+  scratch_free(&scratch);
+  return ok;
+}
+
+// 阶段二：偏移确定后各段独立写入文件
+static bool write_segment_task(void *arg, uint32_t index) {
+  SegmentContext *context = (SegmentContext *)arg;
+  const ByteBuffer *buffer = &context->buffers[index];
+  size_t written = 0;
+  while (written < buffer->size) {
+    ssize_t n = pwrite(context->fd, buffer->data + written, buffer->size - written,
+                       (off_t)(context->entries[index].offset + written));
+    if (n <= 0) {
+      return false;
+    }
+    written += (size_t)n;
+  }
+  return true;
+}
+
+static bool read_segment_task(void *arg, uint32_t index) {
+  SegmentContext *context = (SegmentContext *)arg;
+  const SegmentEntry *entry = &context->entries[index];
+  uint8_t *data = (uint8_t *)malloc(entry->size ? entry->size : 1);
+  if (!data) {
+    return false;
+  }
+  size_t done = 0;
+  while (done < entry->size) {
+    ssize_t n = pread(context->fd, data + done, entry->size - done, (off_t)(entry->offset + done));
+    if (n <= 0) {
+      free(data);
+      return false;
+    }
+    done += (size_t)n;
+  }
+
+  ByteReader reader = {NULL, data, entry->size, 0, false, 0};
+  PageScratch scratch = {0};
+  bool ok = read_page_stream(context->options, &reader, entry->page_count, &scratch) &&
+            reader.pos == reader.size;
+  scratch_free(&scratch);
+  free(data);
+  return ok;
+}
+
+/**
+ * 段格式：根页面之后是段表，每个根的子树编码为一个独立的段，
+ * 由线程池并行编码、并行写入；读取时每个段并行解码到页面表中。
+ */
+static bool serialize_segments(BPlusTreeSerializer *serializer, FILE *file,
+                               const FileHeader *header) {
+  CBPlusTree *tree = serializer->tree;
+  CBPlusTreePage *root = get_page(tree, header->root_page_id);
+  if (!root) {
+    return false;
+  }
+  uint32_t segment_count = page_is_leaf(root) ? 0 : (uint32_t)page_get_size(root);
+
+  SegmentContext context;
+  context.tree = tree;
+  context.root = root;
+  context.flags = header->flags;
+  context.options = NULL;
+  context.fd = fileno(file);
+  context.buffers = (ByteBuffer *)calloc(segment_count + 1, sizeof(ByteBuffer));
+  context.entries = (SegmentEntry *)calloc(segment_count + 1, sizeof(SegmentEntry));
+  bool ok = context.buffers && context.entries;
+
+  // 根页面单独写出
+  PageWriter writer = {file, NULL, header->flags, {0}, {0}, 0};
+  PageScratch scratch = {0};
+  uint32_t root_pages = 0;
+  ok = ok && write_page_stream(tree, header->root_page_id, false, &writer, &scratch, &root_pages);
+  writer_free(&writer);
+  scratch_free(&scratch);
+
+  ok = ok && run_tasks(segment_count, resolve_thread_count(serializer), encode_segment_task,
+                       &context);
+
+  if (ok) {
+    uint64_t offset = (uint64_t)ftell(file) + sizeof(uint32_t) + sizeof(SegmentEntry) * segment_count;
+    for (uint32_t i = 0; i < segment_count; i++) {
+      context.entries[i].offset = offset;
+      context.entries[i].size = context.buffers[i].size;
+      offset += context.buffers[i].size;
+    }
+    ok = fwrite(&segment_count, sizeof(uint32_t), 1, file) == 1 &&
+         (segment_count == 0 ||
+          fwrite(context.entries, sizeof(SegmentEntry), segment_count, file) == segment_count) &&
+         fflush(file) == 0;
+  }
+  ok = ok && run_tasks(segment_count, resolve_thread_count(serializer), write_segment_task,
+                       &context);
+
+  for (uint32_t i = 0; context.buffers && i < segment_count; i++) {
+    buffer_free(&context.buffers[i]);
+  }
+  free(context.buffers);
+  free(context.entries);
+  return ok;
+}
+
+static bool deserialize_segments(BPlusTreeSerializer *serializer, const LoadOptions *options,
+                                 FILE *file) {
+  const FileHeader *header = options->header;
+  ByteReader file_reader = {file, NULL, 0, 0, false, 0};
+  PageScratch scratch = {0};
+  bool ok = read_page_stream(options, &file_reader, 1, &scratch);
+  scratch_free(&scratch);
+
+  uint32_t segment_count = 0;
+  if (!ok || fread(&segment_count, sizeof(uint32_t), 1, file) != 1 ||
+      segment_count > (uint32_t)header->internal_max_size) {
+    return false;
+  }
+
+  struct stat file_stat;
+  SegmentContext context;
+  context.tree = options->tree;
+  context.root = NULL;
+  context.flags = header->flags;
+  context.options = options;
+  context.fd = fileno(file);
+  context.buffers = NULL;
+  context.entries = (SegmentEntry *)calloc(segment_count + 1, sizeof(SegmentEntry));
+  ok = context.entries && fstat(context.fd, &file_stat) == 0 &&
+       (segment_count == 0 ||
+        fread(context.entries, sizeof(SegmentEntry), segment_count, file) == segment_count);
+  for (uint32_t i = 0; ok && i < segment_count; i++) {
+    const SegmentEntry *entry = &context.entries[i];
+    ok = entry->offset <= (uint64_t)file_stat.st_size &&
+         entry->size <= (uint64_t)file_stat.st_size - entry->offset;
+  }
+
+  ok = ok && run_tasks(segment_count, resolve_thread_count(serializer), read_segment_task,
+                       &context);
+  free(context.entries);
+  return ok;
+}
+
+/*****************************************************************************
+ * 叶子流
+ *****************************************************************************/
+
+static CBPlusTreePage *leftmost_leaf(CBPlusTree *tree, page_id_t root_page_id) {
+  CBPlusTreePage *page = get_page(tree, root_page_id);
+  while (page && !page_is_leaf(page)) {
+    page = get_page(tree, internal_page_get_value_at(page, 0));
+  }
+  return page;
+}
+
+// 沿叶子链统计叶子数和元素数
+static void count_leaf_chain(CBPlusTree *tree, page_id_t root_page_id, uint32_t *leaf_count,
+                             uint64_t *entry_count) {
+  *leaf_count = 0;
+  *entry_count = 0;
+  for (CBPlusTreePage *page = leftmost_leaf(tree, root_page_id); page;
+       page = get_page(tree, leaf_page_get_next_id(page))) {
+    (*leaf_count)++;
+    *entry_count += (uint64_t)page_get_size(page);
+  }
+}
+
+/**
+ * 叶子流格式：文件头之后是元素总数，然后按键序写出每个叶子页面的内容，不包含内部页面。
+ */
+static bool serialize_leaf_stream(CBPlusTree *tree, FILE *file, const FileHeader *header,
+                                  uint64_t entry_count) {
+  if (fwrite(&entry_count, sizeof(uint64_t), 1, file) != 1) {
+    return false;
+  }
+  PageWriter writer = {file, NULL, header->flags, {0}, {0}, 0};
+  PageScratch scratch = {0};
+  bool ok = true;
+  for (CBPlusTreePage *page = leftmost_leaf(tree, header->root_page_id); ok && page;
+       page = get_page(tree, leaf_page_get_next_id(page))) {
+    ok = writer_add_page(&writer, page, &scratch, NULL);
+  }
+  ok = ok && writer_flush(&writer);
+  writer_free(&writer);
+  scratch_free(&scratch);
+  return ok;
+}
+
+// 把叶子流直接送入自底向上的批量构建
+static bool deserialize_leaf_stream(BPlusTreeSerializer *serializer, const LoadOptions *options,
+                                    FILE *file) {
+  const FileHeader *header = options->header;
+  CBPlusTree *tree = options->tree;
+  uint64_t entry_count;
+  if (fread(&entry_count, sizeof(uint64_t), 1, file) != 1) {
+    return false;
+  }
+
+  if (tree) {
+    bpt_bulk_load_begin(tree, entry_count, serializer->fill_factor);
+  }
+  ByteReader file_reader = {file, NULL, 0, 0, false, 0};
+  PageReader pages = {&file_reader, header->flags, {0}, {0}, {NULL, NULL, 0, 0, false, 0}, 0};
+  PageScratch scratch = {0};
+  bool ok = true;
+  for (uint32_t i = 0; ok && i < header->page_count; ++i) {
+    ByteReader *page_reader = reader_next_page(&pages, header->page_count - i);
+    PageHeader p_header;
+    page_id_t next_page_id;
+    if (page_reader) {
+      record_begin(options, page_reader);
+    }
+    ok = page_reader && reader_read(page_reader, &p_header, sizeof(PageHeader)) &&
+         p_header.page_type == 1 && p_header.size >= 0 &&
+         p_header.size <= header->leaf_max_size &&
+         decode_leaf_payload(page_reader, header->flags, &scratch, p_header.size,
+                             &next_page_id) &&
+         record_end(options, page_reader, p_header.page_id) &&
+         (!tree || bpt_bulk_load_append(tree, scratch.keys, scratch.values, p_header.size));
+  }
+  if (tree) {
+    ok = bpt_bulk_load_finish(tree) && ok;
+  }
+
+  page_reader_free(&pages);
+  scratch_free(&scratch);
+  return ok;
+}
+
+/*****************************************************************************
+ * 序列化/反序列化
+ *****************************************************************************/
+
 bool serializer_serialize(BPlusTreeSerializer *serializer) {
   FILE *file = fopen(serializer->storage_path, "wb");
   if (!file) {
@@ -70,12 +947,21 @@ bool serializer_serialize(BPlusTreeSerializer *serializer) {
 
   // 准备文件头
   FileHeader header;
-  strncpy(header.magic_number, MAGIC_NUMBER, sizeof(MAGIC_NUMBER));
+  memset(&header, 0, sizeof(FileHeader));
+  memcpy(header.magic_number, MAGIC_NUMBER, sizeof(header.magic_number));
   header.version = VERSION;
   header.root_page_id = get_root_page_id(serializer->tree);
   header.leaf_max_size = get_leaf_max_size(serializer->tree);
   header.internal_max_size = get_internal_max_size(serializer->tree);
   header.page_count = get_page_count(serializer->tree);
+  header.flags = serializer->flags;
+
+  // 叶子流格式下 page_count 为叶子页面数，并且不分段
+  uint64_t entry_count = 0;
+  if (header.flags & SERIALIZER_FLAG_LEAF_STREAM) {
+    header.flags &= ~SERIALIZER_FLAG_SEGMENTED;
+    count_leaf_chain(serializer->tree, header.root_page_id, &header.page_count, &entry_count);
+  }
 
   // 写入文件头
   if (fwrite(&header, sizeof(FileHeader), 1, file) != 1) {
@@ -89,94 +975,58 @@ bool serializer_serialize(BPlusTreeSerializer *serializer) {
     return true;
   }
 
-  Queue *queue = queue_create();
-  // Set *visited = set_create();
-
-  queue_push(queue, header.root_page_id);
-
-  while (!queue_empty(queue)) {
-    page_id_t current_page_id = queue_pop(queue);
+  bool ok;
+  if (header.flags & SERIALIZER_FLAG_LEAF_STREAM) {
+    ok = serialize_leaf_stream(serializer->tree, file, &header, entry_count);
+  } else if (header.flags & SERIALIZER_FLAG_SEGMENTED) {
+    ok = serialize_segments(serializer, file, &header);
+  } else {
+    PageWriter writer = {file, NULL, header.flags, {0}, {0}, 0};
+    PageScratch scratch = {0};
+    uint32_t page_count = 0;
+    ok = write_page_stream(serializer->tree, header.root_page_id, true, &writer, &scratch,
+                           &page_count);
+    writer_free(&writer);
+    scratch_free(&scratch);
+  }
+  if (!ok) {
+    perror("Failed to write pages");
+  }
 
-    CBPlusTreePage *page = get_page(serializer->tree, current_page_id);
-    if (!page) {
-      continue;
-    }
+  fclose(file);
+  return ok;
+}
 
-    // 写入页面头
-    PageHeader page_header;
-    page_header.page_id = page_get_id(page);
-    page_header.page_type = page_is_leaf(page) ? 1 : 2;
-    page_header.size = page_get_size(page);
+// 读取并检查文件头
+static bool read_file_header(FILE *file, FileHeader *header) {
+  // VERSION 1 的文件头没有 flags 字段，先读公共部分
+  memset(header, 0, sizeof(FileHeader));
+  return fread(header, offsetof(FileHeader, flags), 1, file) == 1 &&
+         strncmp(header->magic_number, MAGIC_NUMBER, 8) == 0 && header->version >= 1 &&
+         header->version <= VERSION &&
+         (header->version < 2 || fread(&header->flags, sizeof(header->flags), 1, file) == 1);
+}
 
-    if (fwrite(&page_header, sizeof(PageHeader), 1, file) != 1) {
-      perror("Failed to write page header");
-      queue_destroy(queue);
-      // set_destroy(visited);
-      fclose(file);
-      return false;
+// 读取文件头之后的全部页面
+static bool load_pages(BPlusTreeSerializer *serializer, const LoadOptions *options, FILE *file) {
+  bool ok;
+  if (options->header->flags & SERIALIZER_FLAG_LEAF_STREAM) {
+    ok = deserialize_leaf_stream(serializer, options, file);
+    if (!ok) {
+      fprintf(stderr, "Deserialization failed: Corrupted leaf stream\n");
     }
-
-    // 写入页面数据
-    if (page_is_leaf(page)) {
-      // 叶子页面：写入键值对
-      for (int i = 0; i < page_header.size; i++) {
-        KeyType key = leaf_page_get_key_at(page, i);
-        ValueType value = leaf_page_get_value_at(page, i);
-
-        if (fwrite(&key, sizeof(KeyType), 1, file) != 1 ||
-            fwrite(&value, sizeof(ValueType), 1, file) != 1) {
-          perror("Failed to write leaf page data");
-          queue_destroy(queue);
-          // set_destroy(visited);
-          fclose(file);
-          return false;
-        }
-      }
-
-      // 写入下一页指针
-      page_id_t next_page_id = leaf_page_get_next_id(page);
-      if (fwrite(&next_page_id, sizeof(page_id_t), 1, file) != 1) {
-        perror("Failed to write next page id");
-        queue_destroy(queue);
-        // set_destroy(visited);
-        fclose(file);
-        return false;
-      }
-    } else {
-      // 内部页面：写入键和子页面指针
-      for (int i = 0; i < page_header.size; i++) {
-        page_id_t child_page_id = internal_page_get_value_at(page, i);
-
-        if (fwrite(&child_page_id, sizeof(page_id_t), 1, file) != 1) {
-          perror("Failed to write child page id");
-          queue_destroy(queue);
-          // set_destroy(visited);
-          fclose(file);
-          return false;
-        }
-
-        // 第一个位置没有键
-        if (i > 0) {
-          KeyType key = internal_page_get_key_at(page, i);
-          if (fwrite(&key, sizeof(KeyType), 1, file) != 1) {
-            perror("Failed to write internal page key");
-            queue_destroy(queue);
-            // set_destroy(visited);
-            fclose(file);
-            return false;
-          }
-        }
-
-        // 将子页面加入队列
-        queue_push(queue, child_page_id);
-      }
+  } else if (options->header->flags & SERIALIZER_FLAG_SEGMENTED) {
+    ok = deserialize_segments(serializer, options, file);
+    if (!ok) {
+      fprintf(stderr, "Deserialization failed: Corrupted segment\n");
     }
+  } else {
+    ByteReader file_reader = {file, NULL, 0, 0, false, 0};
+    PageScratch scratch = {0};
+    ok = read_page_stream(options, &file_reader, options->header->page_count, &scratch);
+    scratch_free(&scratch);
   }
-
-  queue_destroy(queue);
-  // set_destroy(visited);
-  fclose(file);
-  return true;
+  return ok;
 }
 
 bool serializer_deserialize(BPlusTreeSerializer *serializer) {
@@ -186,8 +1036,7 @@ bool serializer_deserialize(BPlusTreeSerializer *serializer) {
     return false;
   }
   FileHeader header;
-  if (fread(&header, sizeof(FileHeader), 1, file) != 1 ||
-      strncmp(header.magic_number, MAGIC_NUMBER, 8) != 0) {
+  if (!read_file_header(file, &header)) {
     fprintf(stderr, "Deserialization failed: Invalid file format\n");
     fclose(file);
     return false;
@@ -202,41 +1051,32 @@ bool serializer_deserialize(BPlusTreeSerializer *serializer) {
     return true;
   }
 
-  for (uint32_t i = 0; i < header.page_count; ++i) {
-    PageHeader p_header;
-    fread(&p_header, sizeof(PageHeader), 1, file);
-
-    bpt_create_page_with_id(tree, p_header.page_id, p_header.page_type == 1);
-
-    CBPlusTreePage *page = get_page(tree, p_header.page_id);
-    bpt_page_set_size(page, p_header.size);
-
-    if (p_header.page_type == 1) {  // Leaf
-      for (int j = 0; j < p_header.size; ++j) {
-        KeyType key;
-        ValueType value;
-        fread(&key, sizeof(KeyType), 1, file);
-        fread(&value, sizeof(ValueType), 1, file);
-        leaf_page_set_kv_at(page, j, key, value);
-      }
-      page_id_t next_page_id;
-      fread(&next_page_id, sizeof(page_id_t), 1, file);
-      leaf_page_set_next_id(page, next_page_id);
-    } else {  // Internal
-      for (int j = 0; j < p_header.size; ++j) {
-        page_id_t child_id;
-        fread(&child_id, sizeof(page_id_t), 1, file);
-        internal_page_set_value_at(page, j, child_id);
-
-        if (j > 0) {
-          KeyType key;
-          fread(&key, sizeof(KeyType), 1, file);
-          internal_page_set_key_at(page, j, key);
-        }
-      }
-    }
+  LoadOptions options = {tree, &header, serializer->verify};
+  bool ok = load_pages(serializer, &options, file);
+  if (ok) {
+    bpt_swizzle_children(tree);
+    bpt_recount_stats(tree);
   }
+  fclose(file);
+  return ok;
+}
 
+/**
+ * 按与反序列化相同的路径扫描文件并校验所有页面的校验和，但不创建任何页面。
+ * 没有 CHECKSUM 标志的文件只做结构检查。
+ */
+bool serializer_verify(BPlusTreeSerializer *serializer) {
+  FILE *file = fopen(serializer->storage_path, "rb");
+  if (!file) {
+    perror("Verification failed: Unable to open file");
+    return false;
+  }
+  FileHeader header;
+  bool ok = read_file_header(file, &header);
+  if (ok && header.root_page_id != INVALID_PAGE_ID) {
+    LoadOptions options = {NULL, &header, true};
+    ok = load_pages(serializer, &options, file);
+  }
   fclose(file);
-  return true;
+  return ok;
 }
@@ -0,0 +1,331 @@
+#include "b_plus_tree_sharded.h"
+
+#include <algorithm>
+#include <limits>
+#include <thread>
+
+namespace mybplus {
+
+#define SHARDED_TREE_TYPE ShardedBPlusTree<KeyType, ValueType, KeyComparator>
+
+INDEX_TEMPLATE_ARGUMENTS
+SHARDED_TREE_TYPE::ShardedBPlusTree(std::string name, const KeyComparator &comparator,
+                                    int num_shards, const std::vector<KeyType> &split_keys,
+                                    int leaf_max_size, int internal_max_size,
+                                    ConcurrencyMode mode)
+    : name_(std::move(name)),
+      comparator_(comparator),
+      num_shards_(static_cast<size_t>(std::max(1, num_shards))),
+      leaf_max_size_(leaf_max_size),
+      internal_max_size_(internal_max_size),
+      mode_(mode) {
+  auto *table = new RoutingTable();
+  KeyType low = std::numeric_limits<KeyType>::lowest();
+  for (const auto &split_key : split_keys) {
+    table->shards.push_back(NewShard(low, &split_key));
+    low = split_key;
+  }
+  table->shards.push_back(NewShard(low, nullptr));
+  table_.store(table, std::memory_order_release);
+  rebalancer_ = std::thread(&ShardedBPlusTree::RebalanceLoop, this);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+SHARDED_TREE_TYPE::~ShardedBPlusTree() {
+  {
+    std::lock_guard<std::mutex> lock(signal_mutex_);
+    stopping_.store(true, std::memory_order_relaxed);
+  }
+  wakeup_.notify_one();
+  rebalancer_.join();
+  RoutingTable *table = table_.load(std::memory_order_relaxed);
+  for (Shard *shard : table->shards) {
+    delete shard;
+  }
+  delete table;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto SHARDED_TREE_TYPE::NewShard(const KeyType &low, const KeyType *high) -> Shard * {
+  auto *shard = new Shard();
+  shard->low = low;
+  if (high != nullptr) {
+    shard->high = *high;
+    shard->has_high = true;
+  }
+  shard->tree = std::make_unique<Tree>(name_ + "_" + std::to_string(next_shard_id_++),
+                                       comparator_, leaf_max_size_, internal_max_size_, mode_);
+  return shard;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto SHARDED_TREE_TYPE::Route(const RoutingTable &table, const KeyType &key) const -> size_t {
+  // 最后一个 low 不大于 key 的分片
+  auto it = std::upper_bound(
+      table.shards.begin() + 1, table.shards.end(), key,
+      [this](const KeyType &k, const Shard *shard) { return comparator_(k, shard->low) < 0; });
+  return std::distance(table.shards.begin(), it) - 1;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+template <typename Fn>
+auto SHARDED_TREE_TYPE::WithShard(const KeyType &key, Fn &&fn) {
+  EpochGuard epoch_guard(epoch_);
+  while (true) {
+    RoutingTable *table = table_.load(std::memory_order_acquire);
+    Shard *shard = table->shards[Route(*table, key)];
+    shard->latch.LockShared();
+    if (!shard->retired.load(std::memory_order_acquire)) {
+      auto result = fn(shard->tree.get());
+      shard->latch.UnlockShared();
+      return result;
+    }
+    // 分片正在被拆分或合并，新的路由表发布之后重试
+    shard->latch.UnlockShared();
+    std::this_thread::yield();
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto SHARDED_TREE_TYPE::GetValue(const KeyType &key, ValueType *value) -> bool {
+  return WithShard(key, [&](Tree *tree) { return tree->GetValue(key, value); });
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto SHARDED_TREE_TYPE::Insert(const KeyType &key, const ValueType &value) -> bool {
+  bool inserted = WithShard(key, [&](Tree *tree) { return tree->Insert(key, value); });
+  MaybeRebalance();
+  return inserted;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto SHARDED_TREE_TYPE::Update(const KeyType &key, const ValueType &value) -> bool {
+  return WithShard(key, [&](Tree *tree) { return tree->Update(key, value); });
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void SHARDED_TREE_TYPE::Remove(const KeyType &key) {
+  WithShard(key, [&](Tree *tree) {
+    tree->Remove(key);
+    return true;
+  });
+  MaybeRebalance();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto SHARDED_TREE_TYPE::Scan(const KeyType &start_key, size_t max_count,
+                             std::vector<std::pair<KeyType, ValueType>> *result) -> size_t {
+  EpochGuard epoch_guard(epoch_);
+  size_t found = 0;
+  KeyType from = start_key;
+  while (found < max_count) {
+    RoutingTable *table = table_.load(std::memory_order_acquire);
+    Shard *shard = table->shards[Route(*table, from)];
+    shard->latch.LockShared();
+    if (shard->retired.load(std::memory_order_acquire)) {
+      shard->latch.UnlockShared();
+      std::this_thread::yield();
+      continue;
+    }
+    found += shard->tree->Scan(from, max_count - found, result);
+    bool last = !shard->has_high;
+    // 下一个分片从本分片的上界开始，每次都按最新的路由表重新定位
+    from = shard->high;
+    shard->latch.UnlockShared();
+    if (last) {
+      break;
+    }
+  }
+  return found;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto SHARDED_TREE_TYPE::MaybeRebalance() -> void {
+  thread_local uint32_t calls = 0;
+  if (++calls % kRebalanceInterval != 0 || !auto_rebalance_.load(std::memory_order_relaxed)) {
+    return;
+  }
+  // 拆分与合并要复制整个分片，交给后台线程，调用方只发出请求
+  {
+    std::lock_guard<std::mutex> lock(signal_mutex_);
+    rebalance_requested_ = true;
+  }
+  wakeup_.notify_one();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto SHARDED_TREE_TYPE::RebalanceLoop() -> void {
+  std::unique_lock<std::mutex> lock(signal_mutex_);
+  while (true) {
+    wakeup_.wait(lock, [this] {
+      return rebalance_requested_ || stopping_.load(std::memory_order_relaxed);
+    });
+    if (stopping_.load(std::memory_order_relaxed)) {
+      return;
+    }
+    rebalance_requested_ = false;
+    lock.unlock();
+    // 一步一步划分直到均衡；关闭自动划分或析构时在两步之间停下
+    while (true) {
+      std::lock_guard<std::mutex> rebalance_lock(rebalance_mutex_);
+      if (!auto_rebalance_.load(std::memory_order_relaxed) ||
+          stopping_.load(std::memory_order_relaxed) || !RebalanceLocked()) {
+        break;
+      }
+    }
+    lock.lock();
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto SHARDED_TREE_TYPE::Rebalance() -> bool {
+  std::lock_guard<std::mutex> lock(rebalance_mutex_);
+  return RebalanceLocked();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto SHARDED_TREE_TYPE::SetAutoRebalance(bool enabled) -> void {
+  auto_rebalance_.store(enabled, std::memory_order_relaxed);
+  if (!enabled) {
+    // 等后台线程正在进行的一步结束；它在下一步之前持有同一把锁检查开关
+    std::lock_guard<std::mutex> lock(rebalance_mutex_);
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto SHARDED_TREE_TYPE::RebalanceLocked() -> bool {
+  // 只有持有 rebalance_mutex_ 的线程会替换路由表，这里读到的表在返回前不会被回收
+  RoutingTable *table = table_.load(std::memory_order_acquire);
+  size_t count = table->shards.size();
+  std::vector<uint64_t> keys(count);
+  uint64_t total = 0;
+  for (size_t i = 0; i < count; i++) {
+    keys[i] = table->shards[i]->tree->GetStats().key_count;
+    total += keys[i];
+  }
+
+  // 分片不足 num_shards_ 个时一直拆分最大的分片；够了以后只拆分键数超过现有分片平均值两倍的分片
+  size_t largest = std::max_element(keys.begin(), keys.end()) - keys.begin();
+  bool skewed = count < num_shards_ || keys[largest] * count > 2 * total;
+  if (keys[largest] >= kMinSplitKeys && skewed) {
+    SplitShard(largest);
+    return true;
+  }
+  if (count > num_shards_) {
+    size_t smallest = 0;
+    for (size_t i = 1; i + 1 < count; i++) {
+      if (keys[i] + keys[i + 1] < keys[smallest] + keys[smallest + 1]) {
+        smallest = i;
+      }
+    }
+    MergeShards(smallest);
+    return true;
+  }
+  return false;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto SHARDED_TREE_TYPE::SplitShard(size_t index) -> void {
+  Shard *shard = table_.load(std::memory_order_relaxed)->shards[index];
+  // 先置 retired 使新的操作等待，再加排他锁等已经进入分片的操作结束
+  shard->retired.store(true, std::memory_order_release);
+  shard->latch.LockExclusive();
+  std::vector<std::pair<KeyType, ValueType>> entries;
+  shard->tree->Scan(shard->low, SIZE_MAX, &entries);
+  if (entries.size() < 2) {
+    shard->retired.store(false, std::memory_order_release);
+    shard->latch.UnlockExclusive();
+    return;
+  }
+
+  size_t middle = entries.size() / 2;
+  KeyType split_key = entries[middle].first;
+  Shard *left = NewShard(shard->low, &split_key);
+  Shard *right = NewShard(split_key, shard->has_high ? &shard->high : nullptr);
+  left->tree->BeginBulkLoad(middle);
+  for (size_t i = 0; i < middle; i++) {
+    left->tree->BulkLoadAppend(entries[i].first, entries[i].second);
+  }
+  left->tree->FinishBulkLoad();
+  right->tree->BeginBulkLoad(entries.size() - middle);
+  for (size_t i = middle; i < entries.size(); i++) {
+    right->tree->BulkLoadAppend(entries[i].first, entries[i].second);
+  }
+  right->tree->FinishBulkLoad();
+  ReplaceShards(index, 1, {left, right});
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto SHARDED_TREE_TYPE::MergeShards(size_t index) -> void {
+  RoutingTable *table = table_.load(std::memory_order_relaxed);
+  Shard *left = table->shards[index];
+  Shard *right = table->shards[index + 1];
+  // 操作一次只持有一个分片的锁，按顺序加锁不会死锁
+  for (Shard *shard : {left, right}) {
+    shard->retired.store(true, std::memory_order_release);
+    shard->latch.LockExclusive();
+  }
+  std::vector<std::pair<KeyType, ValueType>> entries;
+  left->tree->Scan(left->low, SIZE_MAX, &entries);
+  right->tree->Scan(right->low, SIZE_MAX, &entries);
+
+  Shard *merged = NewShard(left->low, right->has_high ? &right->high : nullptr);
+  merged->tree->BeginBulkLoad(entries.size());
+  for (const auto &[key, value] : entries) {
+    merged->tree->BulkLoadAppend(key, value);
+  }
+  merged->tree->FinishBulkLoad();
+  ReplaceShards(index, 2, {merged});
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto SHARDED_TREE_TYPE::ReplaceShards(size_t first, size_t count,
+                                      const std::vector<Shard *> &replacements) -> void {
+  RoutingTable *old_table = table_.load(std::memory_order_relaxed);
+  auto *table = new RoutingTable();
+  const auto &shards = old_table->shards;
+  table->shards.assign(shards.begin(), shards.begin() + first);
+  table->shards.insert(table->shards.end(), replacements.begin(), replacements.end());
+  table->shards.insert(table->shards.end(), shards.begin() + first + count, shards.end());
+  // 新表发布之后再解锁，等待的操作重新读取路由表时一定能看到新的分片
+  table_.store(table, std::memory_order_release);
+  for (size_t i = first; i < first + count; i++) {
+    Shard *shard = shards[i];
+    shard->latch.UnlockExclusive();
+    epoch_.Retire(shard, [](void *p) { delete static_cast<Shard *>(p); });
+  }
+  epoch_.Retire(old_table, [](void *p) { delete static_cast<RoutingTable *>(p); });
+  // 被替换的分片带着整棵树，不等 limbo 列表攒满就尝试回收
+  epoch_.Reclaim();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto SHARDED_TREE_TYPE::GetShards() -> std::vector<ShardInfo<KeyType>> {
+  EpochGuard epoch_guard(epoch_);
+  RoutingTable *table = table_.load(std::memory_order_acquire);
+  std::vector<ShardInfo<KeyType>> shards;
+  for (const Shard *shard : table->shards) {
+    shards.push_back({shard->low, shard->high, shard->has_high,
+                      shard->tree->GetStats().key_count});
+  }
+  return shards;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto SHARDED_TREE_TYPE::ShardCount() -> size_t {
+  EpochGuard epoch_guard(epoch_);
+  return table_.load(std::memory_order_acquire)->shards.size();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto SHARDED_TREE_TYPE::KeyCount() -> uint64_t {
+  uint64_t total = 0;
+  for (const auto &shard : GetShards()) {
+    total += shard.key_count;
+  }
+  return total;
+}
+
+template class ShardedBPlusTree<int64_t, std::array<char, 16>, Comparator>;
+
+}  // namespace mybplus
@@ -0,0 +1,39 @@
+#include "b_plus_tree_stats.h"
+
+#include <iomanip>
+#include <sstream>
+
+namespace mybplus {
+
+auto TreeStats::ToString() const -> std::string {
+  std::ostringstream out;
+  out << "height: " << height << "\n"
+      << "keys: " << key_count << "\n"
+      << "leaf pages: " << leaf_pages << "\n"
+      << "internal pages: " << internal_pages << "\n";
+  if (!full_scan) {
+    return out.str();
+  }
+
+  out << "pages per level:";
+  for (uint64_t pages : pages_per_level) {
+    out << " " << pages;
+  }
+  out << "\n";
+  auto histogram = [&out](const char *name, const std::array<uint64_t, kFillBuckets> &fill) {
+    out << name << " fill:";
+    for (int i = 0; i < kFillBuckets; i++) {
+      out << " " << i * 100 / kFillBuckets << "%:" << fill[i];
+    }
+    out << "\n";
+  };
+  histogram("leaf", leaf_fill);
+  histogram("internal", internal_fill);
+  double used_ratio = bytes_allocated == 0 ? 0.0 : 100.0 * bytes_used / bytes_allocated;
+  out << "bytes used/allocated: " << bytes_used << "/" << bytes_allocated << " (" << std::fixed
+      << std::setprecision(1) << used_ratio << "%)\n"
+      << "excess array capacity: " << bytes_excess_capacity << " bytes\n";
+  return out.str();
+}
+
+}  // namespace mybplus
@@ -0,0 +1,199 @@
+#include "b_plus_tree_trace.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace mybplus {
+
+#define TRACE_FLUSH_INTERVAL std::chrono::milliseconds(1)
+
+namespace {
+std::atomic<uint64_t> next_recorder_id{1};
+}  // namespace
+
+TraceRecorder::TraceRecorder() : id_(next_recorder_id.fetch_add(1, std::memory_order_relaxed)) {}
+
+TraceRecorder::~TraceRecorder() {
+  Stop();
+  for (auto &ring : rings_) {
+    delete ring.load(std::memory_order_relaxed);
+  }
+}
+
+auto TraceRecorder::Start(const std::string &path) -> bool {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (file_ != nullptr) {
+    return false;
+  }
+  file_ = std::fopen(path.c_str(), "wb");
+  if (file_ == nullptr) {
+    return false;
+  }
+  TraceHeader header{};
+  std::memcpy(header.magic, TraceHeader::kMagic, sizeof(header.magic));
+  header.version = TraceHeader::kVersion;
+  header.record_size = sizeof(TraceRecord);
+  std::fwrite(&header, sizeof(header), 1, file_);
+
+  // 上一次 Stop 之前通过 IsEnabled 检查的 Append 可能在最后一次 Drain 之后才写入，
+  // 这些记录属于上一次跟踪，丢弃；此时没有写文件线程，可以直接移动 head
+  for (auto &entry : rings_) {
+    Ring *ring = entry.load(std::memory_order_acquire);
+    if (ring != nullptr) {
+      ring->head.store(ring->tail.load(std::memory_order_acquire), std::memory_order_release);
+    }
+  }
+  dropped_.store(0, std::memory_order_relaxed);
+  written_ = 0;
+  stopping_ = false;
+  start_ = std::chrono::steady_clock::now();
+  flusher_ = std::thread(&TraceRecorder::FlushLoop, this);
+  enabled_.store(true, std::memory_order_release);
+  return true;
+}
+
+auto TraceRecorder::Stop() -> bool {
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (file_ == nullptr) {
+    return false;
+  }
+  enabled_.store(false, std::memory_order_relaxed);
+  stopping_ = true;
+  lock.unlock();
+  wakeup_.notify_one();
+  flusher_.join();
+  lock.lock();
+
+  // 回填记录数和丢弃数
+  TraceHeader header{};
+  std::memcpy(header.magic, TraceHeader::kMagic, sizeof(header.magic));
+  header.version = TraceHeader::kVersion;
+  header.record_size = sizeof(TraceRecord);
+  header.record_count = written_;
+  header.dropped = dropped_.load(std::memory_order_relaxed);
+  std::fseek(file_, 0, SEEK_SET);
+  bool ok = std::fwrite(&header, sizeof(header), 1, file_) == 1;
+  ok = std::fclose(file_) == 0 && ok;
+  file_ = nullptr;
+  return ok;
+}
+
+auto TraceRecorder::Append(TraceOp op, int64_t key, uint32_t arg) -> void {
+  auto [ring, thread] = LocalRing();
+  if (ring == nullptr) {
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+  if (tail - ring->head.load(std::memory_order_acquire) == kRingSize) {
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start_;
+  TraceRecord &record = ring->records[tail & (kRingSize - 1)];
+  record.timestamp_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+  record.key = key;
+  record.arg = arg;
+  record.thread = thread;
+  record.op = static_cast<uint8_t>(op);
+  record.reserved = 0;
+  ring->tail.store(tail + 1, std::memory_order_release);
+}
+
+auto TraceRecorder::LocalRing() -> std::pair<Ring *, uint16_t> {
+  struct Cache {
+    uint64_t recorder_id = 0;
+    Ring *ring = nullptr;
+    uint16_t index = 0;
+  };
+  thread_local Cache cache;
+  if (cache.recorder_id == id_) {
+    return {cache.ring, cache.index};
+  }
+
+  // 先找本线程之前占用的环，再占用一个空位
+  std::thread::id self = std::this_thread::get_id();
+  for (int i = 0; i < kMaxThreads; i++) {
+    Ring *ring = rings_[i].load(std::memory_order_acquire);
+    if (ring != nullptr && ring->owner == self) {
+      cache = {id_, ring, static_cast<uint16_t>(i)};
+      return {ring, cache.index};
+    }
+  }
+  for (int i = 0; i < kMaxThreads; i++) {
+    if (rings_[i].load(std::memory_order_acquire) != nullptr) {
+      continue;
+    }
+    auto *created = new Ring();
+    created->owner = self;
+    Ring *expected = nullptr;
+    if (rings_[i].compare_exchange_strong(expected, created, std::memory_order_acq_rel)) {
+      cache = {id_, created, static_cast<uint16_t>(i)};
+      return {created, cache.index};
+    }
+    delete created;
+  }
+  return {nullptr, 0};
+}
+
+auto TraceRecorder::Drain(std::vector<TraceRecord> *buffer) -> void {
+  for (auto &entry : rings_) {
+    Ring *ring = entry.load(std::memory_order_acquire);
+    if (ring == nullptr) {
+      continue;
+    }
+    uint64_t head = ring->head.load(std::memory_order_relaxed);
+    uint64_t tail = ring->tail.load(std::memory_order_acquire);
+    for (uint64_t i = head; i < tail; i++) {
+      buffer->push_back(ring->records[i & (kRingSize - 1)]);
+    }
+    ring->head.store(tail, std::memory_order_release);
+  }
+}
+
+auto TraceRecorder::FlushLoop() -> void {
+  std::vector<TraceRecord> buffer;
+  bool stopping = false;
+  while (!stopping) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      wakeup_.wait_for(lock, TRACE_FLUSH_INTERVAL, [this] { return stopping_; });
+      stopping = stopping_;
+    }
+    buffer.clear();
+    Drain(&buffer);
+    if (!buffer.empty()) {
+      std::fwrite(buffer.data(), sizeof(TraceRecord), buffer.size(), file_);
+      written_ += buffer.size();
+    }
+  }
+}
+
+auto TraceRecorder::ReadTrace(const std::string &path, TraceHeader *header,
+                              std::vector<TraceRecord> *records) -> bool {
+  FILE *file = std::fopen(path.c_str(), "rb");
+  if (file == nullptr) {
+    return false;
+  }
+  bool ok = std::fread(header, sizeof(*header), 1, file) == 1 &&
+            std::memcmp(header->magic, TraceHeader::kMagic, sizeof(header->magic)) == 0 &&
+            header->version == TraceHeader::kVersion &&
+            header->record_size == sizeof(TraceRecord);
+  if (ok) {
+    records->resize(header->record_count);
+    ok = std::fread(records->data(), sizeof(TraceRecord), records->size(), file) ==
+         records->size();
+  }
+  std::fclose(file);
+  if (!ok) {
+    records->clear();
+    return false;
+  }
+  std::stable_sort(records->begin(), records->end(),
+                   [](const TraceRecord &a, const TraceRecord &b) {
+                     return a.timestamp_ns < b.timestamp_ns;
+                   });
+  return true;
+}
+
+}  // namespace mybplus
@@ -9,7 +9,7 @@ using CppBasePage = mybplus::BPlusTreePage;
 using CppLeafPage =
     mybplus::BPlusTreeLeafPage<mybplus::KeyType, mybplus::ValueType, mybplus::KeyComparator>;
 using CppInternalPage =
-    mybplus::BPlusTreeInternalPage<mybplus::KeyType, page_id_t, mybplus::KeyComparator>;
+    mybplus::BPlusTreeInternalPage<mybplus::KeyType, mybplus::ChildRef, mybplus::KeyComparator>;
 
 extern "C" {
 
@@ -50,17 +50,66 @@ bool bpt_insert(CBPlusTree* tree, KeyType key, ValueType value) {
 }
 
 bool bpt_get_value(CBPlusTree* tree, KeyType key, ValueType* out_value) {
-  std::vector<mybplus::ValueType> results;
-  bool found = reinterpret_cast<BPlusTree*>(tree)->GetValue(key, &results);
-  if (found && !results.empty()) {
-    *out_value = cpp_to_c_value(results[0]);
+  mybplus::ValueType value;
+  bool found = reinterpret_cast<BPlusTree*>(tree)->GetValue(key, &value);
+  if (found) {
+    *out_value = cpp_to_c_value(value);
   }
   return found;
 }
 
-void bpt_create_page_with_id(CBPlusTree* tree, page_id_t page_id, bool is_leaf) {
+bool bpt_update(CBPlusTree* tree, KeyType key, ValueType value) {
+  return reinterpret_cast<BPlusTree*>(tree)->Update(key, c_to_cpp_value(value));
+}
+
+void bpt_remove(CBPlusTree* tree, KeyType key) {
+  reinterpret_cast<BPlusTree*>(tree)->Remove(key);
+}
+
+int bpt_scan(CBPlusTree* tree, KeyType start_key, int max_count, KeyType* keys,
+             ValueType* values) {
+  if (max_count <= 0) {
+    return 0;
+  }
+  std::vector<std::pair<mybplus::KeyType, mybplus::ValueType>> entries;
+  reinterpret_cast<BPlusTree*>(tree)->Scan(start_key, max_count, &entries);
+  for (size_t i = 0; i < entries.size(); i++) {
+    keys[i] = entries[i].first;
+    values[i] = cpp_to_c_value(entries[i].second);
+  }
+  return static_cast<int>(entries.size());
+}
+
+void bpt_bulk_load_begin(CBPlusTree* tree, uint64_t expected_entries, double fill_factor) {
+  reinterpret_cast<BPlusTree*>(tree)->BeginBulkLoad(expected_entries, fill_factor);
+}
+
+bool bpt_bulk_load_append(CBPlusTree* tree, const KeyType* keys, const ValueType* values,
+                          int count) {
+  BPlusTree* cpp_tree = reinterpret_cast<BPlusTree*>(tree);
+  for (int i = 0; i < count; i++) {
+    if (!cpp_tree->BulkLoadAppend(keys[i], c_to_cpp_value(values[i]))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool bpt_bulk_load_finish(CBPlusTree* tree) {
+  return reinterpret_cast<BPlusTree*>(tree)->FinishBulkLoad();
+}
+
+void bpt_recount_stats(CBPlusTree* tree) {
+  reinterpret_cast<BPlusTree*>(tree)->RecountStats();
+}
+
+void bpt_swizzle_children(CBPlusTree* tree) {
+  reinterpret_cast<BPlusTree*>(tree)->SwizzleChildren();
+}
+
+CBPlusTreePage* bpt_create_page_with_id(CBPlusTree* tree, page_id_t page_id, bool is_leaf) {
   BPlusTree* cpp_tree = reinterpret_cast<BPlusTree*>(tree);
-  cpp_tree->CreateAndRegisterPage(page_id, is_leaf);
+  return reinterpret_cast<CBPlusTreePage*>(cpp_tree->CreateAndRegisterPage(page_id, is_leaf));
 }
 page_id_t get_root_page_id(CBPlusTree* tree) {
   return reinterpret_cast<BPlusTree*>(tree)->GetRootPageId();
@@ -116,16 +165,34 @@ void leaf_page_set_next_id(CBPlusTreePage* page, page_id_t next_page_id) {
   reinterpret_cast<CppLeafPage*>(page)->SetNextPageId(next_page_id);
 }
 
+void leaf_page_get_columns(const CBPlusTreePage* page, KeyType* keys, ValueType* values) {
+  auto* leaf = reinterpret_cast<const CppLeafPage*>(page);
+  for (int i = 0; i < leaf->GetSize(); i++) {
+    keys[i] = leaf->KeyAt(i);
+    values[i] = cpp_to_c_value(leaf->ValueAt(i));
+  }
+}
+
+void leaf_page_set_columns(CBPlusTreePage* page, const KeyType* keys, const ValueType* values,
+                           int count) {
+  auto* leaf = reinterpret_cast<CppLeafPage*>(page);
+  for (int i = 0; i < count; i++) {
+    leaf->SetAt(i, keys[i], c_to_cpp_value(values[i]));
+  }
+}
+
 KeyType internal_page_get_key_at(const CBPlusTreePage* page, int index) {
   return reinterpret_cast<const CppInternalPage*>(page)->KeyAt(index);
 }
 
 page_id_t internal_page_get_value_at(const CBPlusTreePage* page, int index) {
-  return reinterpret_cast<const CppInternalPage*>(page)->ValueAt(index);
+  return reinterpret_cast<const CppInternalPage*>(page)->ValueAt(index).GetPageId();
 }
 
 void internal_page_set_value_at(CBPlusTreePage* page, int index, page_id_t value) {
-  reinterpret_cast<CppInternalPage*>(page)->SetValueAt(index, value);
+  // 子页面可能还没有加载，先记录页面 id，加载完成后由 bpt_swizzle_children 换成地址
+  reinterpret_cast<CppInternalPage*>(page)->SetValueAt(index,
+                                                       mybplus::ChildRef::FromPageId(value));
 }
 void internal_page_set_key_at(CBPlusTreePage* page, int index, KeyType key) {
   reinterpret_cast<CppInternalPage*>(page)->SetKeyAt(index, key);
@@ -136,5 +203,5 @@ void internal_page_set_key_at(CBPlusTreePage* page, int index, KeyType key) {
 namespace mybplus {
 template class BPlusTree<KeyType, ValueType, KeyComparator>;
 template class BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>;
-template class BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator>;
+template class BPlusTreeInternalPage<KeyType, ChildRef, KeyComparator>;
 }  // namespace mybplus
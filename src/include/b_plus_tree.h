@@ -1,25 +1,100 @@
 #pragma once
 
 #include <algorithm>
-#include <deque>
+#include <array>
+#include <atomic>
+#include <cassert>
 #include <iostream>
 #include <mutex>
 #include <optional>
 #include <queue>
 #include <shared_mutex>
 #include <string>
+#include <type_traits>
 #include <unordered_map>
 #include <vector>
 
+#include "b_plus_tree_epoch.h"
+#include "b_plus_tree_hash_index.h"
 #include "b_plus_tree_internal.h"
+#include "b_plus_tree_latch_profiler.h"
 #include "b_plus_tree_leaf.h"
+#include "b_plus_tree_metrics.h"
+#include "b_plus_tree_stats.h"
+#include "b_plus_tree_trace.h"
 #include "config.h"
 
 namespace mybplus {
 struct PrintableBPlusTree;
+
+/**
+ * Fixed-capacity double-ended queue of pages, stored inline so a Context never allocates. Sized
+ * for a root-to-leaf path plus the siblings taken during rebalancing; a scan that walks the leaf
+ * chain pushes at the back and pops at the front, so the storage is a ring. Each page carries the
+ * slot its parent on the path points to it from, or -1 when unknown.
+ */
+class PagePath {
+ public:
+  static constexpr size_t kCapacity = 2 * MAX_TREE_HEIGHT;
+  static_assert((kCapacity & (kCapacity - 1)) == 0, "ring index wraps with a mask");
+
+  auto push_back(BPlusTreePage *page, int slot = -1) -> void {
+    assert(size_ < kCapacity);
+    size_t index = (head_ + size_++) & kMask;
+    pages_[index] = page;
+    slots_[index] = slot;
+  }
+  auto pop_back() -> void { size_--; }
+  auto pop_front() -> void {
+    head_ = (head_ + 1) & kMask;
+    size_--;
+  }
+  auto front() const -> BPlusTreePage * { return pages_[head_]; }
+  auto back() const -> BPlusTreePage * { return pages_[(head_ + size_ - 1) & kMask]; }
+  auto back_slot() const -> int { return slots_[(head_ + size_ - 1) & kMask]; }
+  auto operator[](size_t index) const -> BPlusTreePage * {
+    return pages_[(head_ + index) & kMask];
+  }
+  auto size() const -> size_t { return size_; }
+  auto empty() const -> bool { return size_ == 0; }
+  auto clear() -> void {
+    head_ = 0;
+    size_ = 0;
+  }
+
+  class Iterator {
+   public:
+    Iterator(const PagePath *path, size_t index) : path_(path), index_(index) {}
+    auto operator*() const -> BPlusTreePage * { return (*path_)[index_]; }
+    auto operator++() -> Iterator & {
+      index_++;
+      return *this;
+    }
+    auto operator!=(const Iterator &other) const -> bool { return index_ != other.index_; }
+
+   private:
+    const PagePath *path_;
+    size_t index_;
+  };
+  auto begin() const -> Iterator { return {this, 0}; }
+  auto end() const -> Iterator { return {this, size_}; }
+
+ private:
+  static constexpr size_t kMask = kCapacity - 1;
+
+  std::array<BPlusTreePage *, kCapacity> pages_;
+  std::array<int, kCapacity> slots_;
+  size_t head_ = 0;
+  size_t size_ = 0;
+};
+
 class Context {
  public:
-  Context(std::shared_mutex &root_mutex) : root_mutex_(root_mutex) {
+  // profiler 不为空时记录每次加锁的等待时间（见 LatchProfiler）；latching 为 false 时不加任何锁，
+  // 只记录路径（SINGLE_THREADED 与 GLOBAL_LOCK 模式）
+  explicit Context(std::shared_mutex &root_mutex, LatchProfiler *profiler = nullptr,
+                   bool latching = true)
+      : root_mutex_(root_mutex), latching_(latching), profiler_(profiler) {
     root_page_id_ = INVALID_PAGE_ID;
   }
   ~Context() {
@@ -33,89 +108,125 @@ class Context {
   }
 
   inline auto WLockRoot() -> void {
-#ifdef USING_CRABBING_PROTOCOL
-    if (!is_root_wlocked_) {
-      root_mutex_.lock();
+    if (latching_ && !is_root_wlocked_) {
+      if (profiler_ != nullptr) {
+        profiler_->Acquire(
+            LatchProfiler::kRootLevel, INVALID_PAGE_ID, LatchMode::EXCLUSIVE,
+            [this] { return root_mutex_.try_lock(); }, [this] { root_mutex_.lock(); });
+      } else {
+        root_mutex_.lock();
+      }
       is_root_wlocked_ = true;
     }
-#endif
   }
   inline auto RLockRoot() -> void {
-#ifdef USING_CRABBING_PROTOCOL
-    if (!is_root_rlocked_) {
-      root_mutex_.lock_shared();
+    if (latching_ && !is_root_rlocked_) {
+      if (profiler_ != nullptr) {
+        profiler_->Acquire(
+            LatchProfiler::kRootLevel, INVALID_PAGE_ID, LatchMode::SHARED,
+            [this] { return root_mutex_.try_lock_shared(); },
+            [this] { root_mutex_.lock_shared(); });
+      } else {
+        root_mutex_.lock_shared();
+      }
       is_root_rlocked_ = true;
     }
-#endif
   }
   inline auto WUnlockRoot() -> void {
-#ifdef USING_CRABBING_PROTOCOL
     if (is_root_wlocked_) {
       root_mutex_.unlock();
       is_root_wlocked_ = false;
     }
-#endif
   }
   inline auto RUnlockRoot() -> void {
-#ifdef USING_CRABBING_PROTOCOL
     if (is_root_rlocked_) {
       root_mutex_.unlock_shared();
       is_root_rlocked_ = false;
     }
-#endif
   }
 
   auto CheckAndReleaseAncestors(BPlusTreePage *current_page, OperationType op) -> void {
-#ifdef USING_CRABBING_PROTOCOL
-    if (current_page->IsSafe(op)) {
-      // 释放除当前页面外的所有祖先锁
+    // 不加锁时保留整条路径，分裂与合并沿路径找父页面
+    if (latching_ && current_page->IsSafe(op)) {
+      // 释放除当前页面外的所有祖先锁；根页面已经放开，根不会再变化，同时释放根互斥量
       while (WritePath.size() > 1) {
         WPopFront();
       }
+      WUnlockRoot();
     }
-#endif
-  }
-  auto WPush(BPlusTreePage *page) -> void {
-#ifdef USING_CRABBING_PROTOCOL
-    page->WLock();
-#endif
-    WritePath.push_back(page);
   }
+  // 下降时加入路径上的下一个页面，slot 为父页面中指向它的位置
+  auto WPush(BPlusTreePage *page, int slot = -1) -> void { WPushAt(page, false, slot); }
   auto RPush(BPlusTreePage *page) -> void {
-#ifdef USING_CRABBING_PROTOCOL
-    page->RLock();
-#endif
+    if (latching_) {
+      if (profiler_ != nullptr) {
+        int level = NextLevel(read_levels_, false);
+        profiler_->Acquire(
+            level, page->GetPageId(), LatchMode::SHARED, [page] { return page->TryRLock(); },
+            [page] { page->RLock(); });
+        read_levels_.push_back({level, false});
+      } else {
+        page->RLock();
+      }
+    }
+    ReadPath.push_back(page);
+  }
+  // 加入一个已经加了读锁的页面（TryRLock 成功之后），与路径末尾页面同层
+  auto RPushLocked(BPlusTreePage *page) -> void {
+    if (latching_ && profiler_ != nullptr) {
+      read_levels_.push_back({read_levels_.empty() ? 0 : read_levels_.back().level, true});
+    }
     ReadPath.push_back(page);
   }
+  // 加入路径末尾页面的兄弟页面（与之同层），用于借用与合并
+  auto WPushSibling(BPlusTreePage *page) -> void { WPushAt(page, true, -1); }
+  // 路径末尾页面按兄弟页面统计层数，之后加入的兄弟页面与它同层（只影响 profiler）
+  auto WMarkBackSibling() -> void {
+    if (latching_ && profiler_ != nullptr && !write_levels_.empty()) {
+      write_levels_.back().sibling = true;
+    }
+  }
   auto WPopBack() -> void {
     if (!WritePath.empty()) {
-#ifdef USING_CRABBING_PROTOCOL
-      WritePath.back()->Unlock();
-#endif
+      if (latching_) {
+        WritePath.back()->Unlock();
+        if (profiler_ != nullptr) {
+          write_levels_.pop_back();
+        }
+      }
       WritePath.pop_back();
     }
   }
   auto RPopBack() -> void {
     if (!ReadPath.empty()) {
-#ifdef USING_CRABBING_PROTOCOL
-      ReadPath.back()->RUnlock();
-#endif
+      if (latching_) {
+        ReadPath.back()->RUnlock();
+        if (profiler_ != nullptr) {
+          read_levels_.pop_back();
+        }
+      }
       ReadPath.pop_back();
     }
   }
   auto WPopFront() -> void {
     if (!WritePath.empty()) {
-#ifdef USING_CRABBING_PROTOCOL
-      WritePath.front()->Unlock();
-#endif
+      if (latching_) {
+        WritePath.front()->Unlock();
+        if (profiler_ != nullptr) {
+          write_levels_.erase(write_levels_.begin());
+        }
+      }
       WritePath.pop_front();
     }
   }
   auto RPopFront() -> void {
     if (!ReadPath.empty()) {
-#ifdef USING_CRABBING_PROTOCOL
-      ReadPath.front()->RUnlock();
-#endif
+      if (latching_) {
+        ReadPath.front()->RUnlock();
+        if (profiler_ != nullptr) {
+          read_levels_.erase(read_levels_.begin());
+        }
+      }
       ReadPath.pop_front();
     }
   }
@@ -125,6 +236,8 @@ class Context {
     }
     return nullptr;
   }
+  // 路径末尾页面在父页面中的位置，不知道时为 -1
+  auto WBackSlot() const -> int { return WritePath.empty() ? -1 : WritePath.back_slot(); }
   auto RBack() -> BPlusTreePage * {
     if (!ReadPath.empty()) {
       return ReadPath.back();
@@ -132,14 +245,16 @@ class Context {
     return nullptr;
   }
   auto Clear() -> void {
-#ifdef USING_CRABBING_PROTOCOL
-    for (auto &page : WritePath) {
-      page->Unlock();
-    }
-    for (auto &page : ReadPath) {
-      page->RUnlock();
+    if (latching_) {
+      for (auto *page : WritePath) {
+        page->Unlock();
+      }
+      for (auto *page : ReadPath) {
+        page->RUnlock();
+      }
+      write_levels_.clear();
+      read_levels_.clear();
     }
-#endif
     if (is_root_wlocked_) {
       WUnlockRoot();
     }
@@ -152,12 +267,49 @@ class Context {
   auto IsEmpty() const -> bool { return WritePath.empty() && ReadPath.empty(); }
   auto WSize() const -> size_t { return WritePath.size(); }
   auto RSize() const -> size_t { return ReadPath.size(); }
-  std::deque<BPlusTreePage *> WritePath;
-  std::deque<BPlusTreePage *> ReadPath;
+  PagePath WritePath;
+  PagePath ReadPath;
   page_id_t root_page_id_ = INVALID_PAGE_ID;
   std::shared_mutex &root_mutex_;
   bool is_root_wlocked_ = false;
   bool is_root_rlocked_ = false;
+
+ private:
+  // 路径上页面所在的层（根页面为 0），只在开启 profiler 时维护
+  struct PathLevel {
+    int level;
+    bool sibling;
+  };
+
+  static auto NextLevel(const std::vector<PathLevel> &levels, bool sibling) -> int {
+    if (levels.empty()) {
+      return 0;
+    }
+    // 兄弟页面是路径末尾页面（父页面）的子页面；第二个兄弟与第一个兄弟同层
+    const PathLevel &back = levels.back();
+    return sibling && back.sibling ? back.level : back.level + 1;
+  }
+
+  auto WPushAt(BPlusTreePage *page, bool sibling, int slot) -> void {
+    if (latching_) {
+      if (profiler_ != nullptr) {
+        int level = NextLevel(write_levels_, sibling);
+        profiler_->Acquire(
+            level, page->GetPageId(), LatchMode::EXCLUSIVE, [page] { return page->TryWLock(); },
+            [page] { page->WLock(); });
+        write_levels_.push_back({level, sibling});
+      } else {
+        page->WLock();
+      }
+    }
+    WritePath.push_back(page, slot);
+  }
+
+  bool latching_;
+  LatchProfiler *profiler_;
+  // 用 vector 而不是 deque：默认构造不分配内存，关闭 profiler 时没有额外开销
+  std::vector<PathLevel> write_levels_;
+  std::vector<PathLevel> read_levels_;
 };
 
 #define BPLUSTREE_TYPE BPlusTree<KeyType, ValueType, KeyComparator>
@@ -168,13 +320,14 @@ class Context {
 INDEX_TEMPLATE_ARGUMENTS
 class BPlusTree {
   // friend class BPlusTreeSerializer<KeyType, ValueType, KeyComparator>;
-  using InternalPage = BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator>;
+  using InternalPage = BPlusTreeInternalPage<KeyType, ChildRef, KeyComparator>;
   using LeafPage = BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>;
 
  public:
   explicit BPlusTree(std::string name, const KeyComparator &comparator,
                      int leaf_max_size = LEAF_PAGE_SIZE,
-                     int internal_max_size = INTERNAL_PAGE_SIZE);
+                     int internal_max_size = INTERNAL_PAGE_SIZE,
+                     ConcurrencyMode mode = DEFAULT_CONCURRENCY_MODE);
 
   // Destructor
   ~BPlusTree() { Clear(); }
@@ -184,13 +337,28 @@ class BPlusTree {
 
   // Return the value associated with a given key
   auto GetValue(const KeyType &key, std::vector<ValueType> *result) -> bool;
+  // Point lookups that do not touch the heap; value is left unchanged when the key is absent
+  auto GetValue(const KeyType &key, ValueType *value) -> bool;
+  auto GetValue(const KeyType &key) -> std::optional<ValueType>;
 
   // Insert a key-value pair into this B+ tree.
   auto Insert(const KeyType &key, const ValueType &value) -> bool;
 
+  // Replace the value of an existing key; returns false if the key is not present.
+  auto Update(const KeyType &key, const ValueType &value) -> bool;
+
   // Remove a key and its value from this B+ tree.
   void Remove(const KeyType &key);
 
+  /**
+   * Append up to max_count entries with key >= start_key to result, in key order, and return how
+   * many were appended. Leaves are followed through the sibling chain; the next leaf is only
+   * try-latched, and when that fails the scan drops its latches and descends again from the last
+   * key it returned, so it never waits on a writer while holding a latch.
+   */
+  auto Scan(const KeyType &start_key, size_t max_count,
+            std::vector<std::pair<KeyType, ValueType>> *result) -> size_t;
+
   auto Clear() -> void;
 
   // Return the page id of the root node
@@ -200,6 +368,50 @@ class BPlusTree {
 
   auto GetInternalMaxSize() const -> int { return internal_max_size_; }
 
+  auto GetConcurrencyMode() const -> ConcurrencyMode { return mode_; }
+
+  /**
+   * Append mode, for keys that mostly arrive in increasing order (timestamps, sequence numbers).
+   * Insert first tries the cached rightmost leaf without descending the tree, and a full
+   * rightmost page that receives a new largest key is split so the old page stays full and the
+   * new page starts nearly empty, instead of 50/50. Off by default: with random keys the cached
+   * leaf is rarely the target and every insert would pay for the failed attempt.
+   */
+  auto EnableAppendMode(bool enabled = true) -> void {
+    append_mode_.store(enabled, std::memory_order_relaxed);
+  }
+  auto IsAppendMode() const -> bool { return append_mode_.load(std::memory_order_relaxed); }
+
+  /**
+   * Finger cache, for callers whose consecutive calls touch nearby keys. Each thread remembers
+   * the leaf its last GetValue or Insert ended in, with the key range that leaf covers; a call
+   * whose key falls in that range goes straight to the leaf if it has not been written since,
+   * and descends from the root otherwise. A thread keeps one finger per tree type, so a thread
+   * alternating between trees keeps replacing it. Off by default.
+   */
+  auto EnableFingerCache(bool enabled = true) -> void {
+    finger_enabled_.store(enabled, std::memory_order_relaxed);
+  }
+  auto IsFingerCacheEnabled() const -> bool {
+    return finger_enabled_.load(std::memory_order_relaxed);
+  }
+  /**
+   * Adaptive hash index, for point lookups on a small hot set of keys. Once lookups keep ending
+   * in the same leaf, the keys found there are recorded in a hash table of capacity entries, and
+   * a later GetValue of such a key reads the leaf after a single probe. Entries are checked
+   * against the leaf before use, so splits, merges and removes only turn them into misses. The
+   * table is fixed-size and overwrites on collision. Capacity 0 (the default) turns it off.
+   * Not thread safe: no other operation may be running while the capacity changes.
+   */
+  auto EnableHashIndex(size_t capacity = 1 << 16) -> void { hash_index_.Resize(capacity); }
+  auto GetHashIndexStats() const -> HashIndexStats { return hash_index_.Stats(); }
+  auto ResetHashIndexStats() -> void { hash_index_.ResetStats(); }
+  // Not thread safe: no other operation may be running while the mode changes
+  auto SetConcurrencyMode(ConcurrencyMode mode) -> void {
+    mode_ = mode;
+    InvalidateCachedLeaves();
+  }
+
   auto GetPageCount() const -> size_t {
     std::shared_lock<std::shared_mutex> lock(mutex_);
     return pages_.size();
@@ -219,24 +431,199 @@ class BPlusTree {
   auto NewLeafPage(int32_t *new_page_id) -> LeafPage *;
   auto NewInternalPage(int32_t *new_page_id) -> InternalPage *;
   auto DeletePage(page_id_t page_id) -> void;
-  auto CreateAndRegisterPage(page_id_t page_id, bool is_leaf) -> void;
+  // Returns the page registered under page_id, creating it if needed. Safe to call from several
+  // threads at once in every mode; use the returned page rather than GetPage while they run.
+  auto CreateAndRegisterPage(page_id_t page_id, bool is_leaf) -> BPlusTreePage *;
+
+  /**
+   * Bottom-up bulk load. Clears the tree, then builds it from entries appended in strictly
+   * increasing key order. Pages are filled to fill_factor of their capacity, clamped to
+   * [kMinBulkFillFactor, 1]; when expected_entries is known the entries are spread evenly so that
+   * no page is left underfull. Not thread safe: no other operation may run until FinishBulkLoad
+   * returns.
+   */
+  static constexpr double kMinBulkFillFactor = 0.5;
+  auto BeginBulkLoad(size_t expected_entries, double fill_factor = 1.0) -> void;
+  auto BulkLoadAppend(const KeyType &key, const ValueType &value) -> bool;
+  auto FinishBulkLoad() -> bool;
+
+  // Per-operation latency histograms and structure-change counters, disabled by default.
+  auto EnableMetrics(bool enabled = true) -> void { metrics_.SetEnabled(enabled); }
+  auto GetMetrics() const -> MetricsSnapshot { return metrics_.Snapshot(); }
+  auto ResetMetrics() -> void { metrics_.Reset(); }
+
+  // Latch wait time per tree level and per page under the crabbing protocol, off by default.
+  auto EnableLatchProfiling(bool enabled = true) -> void { latch_profiler_.SetEnabled(enabled); }
+  auto GetLatchProfile(size_t top_pages = 10) const -> LatchProfileSnapshot {
+    return latch_profiler_.Snapshot(top_pages);
+  }
+  auto ResetLatchProfile() -> void { latch_profiler_.Reset(); }
+
+  /**
+   * Tree shape and space statistics. By default only the counters maintained on every structural
+   * change are read. A full scan walks every page under shared latches, filling in the per-level
+   * and fill histograms. It holds the root page shared, so splits and merges wait for it, but
+   * writes that only latch a leaf (the optimistic path and the append, finger and hash index fast
+   * paths) keep running: the counts are approximate under concurrent writes, not a snapshot.
+   */
+  auto GetStats(bool full_scan = false) -> TreeStats;
+  // Recompute the maintained counters with a full scan, e.g. after pages were loaded directly.
+  auto RecountStats() -> void;
+
+  /**
+   * Internal pages refer to their children by address (swizzled) so a descent does no page table
+   * lookups. Pages loaded by id, e.g. by the serializer, start out unswizzled; SwizzleChildren
+   * replaces every page id reference with the page's address, UnswizzleChildren turns them back
+   * into page ids. Operations work on either form, but unswizzled children cost a lookup.
+   * Not thread safe: no other operation may run at the same time.
+   */
+  auto SwizzleChildren() -> void;
+  auto UnswizzleChildren() -> void;
+
+  // Record every GetValue/Insert/Remove/Update/Scan call to a binary trace file for offline
+  // replay (see TraceRecorder and bench/replay_bplustree.cpp).
+  auto StartTrace(const std::string &path) -> bool { return tracer_.Start(path); }
+  auto StopTrace() -> bool { return tracer_.Stop(); }
 
  private:
+  // 批量构建时每一层的状态
+  struct BulkLevel {
+    BPlusTreePage *page = nullptr;  // 本层正在填充的页面
+    KeyType first_key{};            // 本层第一个页面的最小键
+    BPlusTreePage *first_page = nullptr;
+    int count = 0;          // 当前页面中已有的元素数
+    int target = 0;         // 当前页面的目标元素数
+    int64_t items_left = 0;  // 按计划本层还剩的元素数
+    int64_t pages_left = 0;  // 按计划本层还剩的页面数
+    int capacity = 0;
+  };
+  auto BulkAppendToLevel(size_t level, const KeyType &key, const ValueType *value,
+                         BPlusTreePage *child) -> void;
+
+  // 叶子负责的键范围 [low, high)，由下降路径上的分隔键确定，没有对应分隔键的一端不设界
+  struct KeyRange {
+    KeyType low{};
+    KeyType high{};
+    bool has_low = false;
+    bool has_high = false;
+  };
+  // 每个线程记住上一次 GetValue/Insert 到达的叶子
+  struct Finger {
+    uint64_t generation = 0;  // 记录时树的 leaf_generation_，0 表示没有记录
+    LeafPage *leaf = nullptr;
+    uint32_t version = 0;  // 记录时叶子的锁版本，只在加锁模式下使用
+    KeyRange range;
+  };
+  static auto LocalFinger() -> Finger & {
+    thread_local Finger finger;
+    return finger;
+  }
+
+  auto CollectStats(BPlusTreePage *page, size_t level, TreeStats *stats) -> void;
+  // 未 swizzle 的子页面引用需要查页表
+  auto ResolveChild(const ChildRef &child) -> BPlusTreePage * {
+    return child.IsSwizzled() ? child.GetPage() : GetPage(child.GetPageId());
+  }
+  // 内部页面加读锁、叶子页面加写锁下降到 key 所在的叶子，树为空时返回 nullptr；
+  // range 不为空时记录叶子负责的键范围
+  auto FindLeafForWrite(const KeyType &key, Context *ctx, KeyRange *range = nullptr)
+      -> LeafPage *;
+
+  auto Trace(TraceOp op, const KeyType &key, uint32_t arg = 0) -> void {
+    if constexpr (std::is_integral_v<KeyType>) {
+      tracer_.Record(op, static_cast<int64_t>(key), arg);
+    }
+  }
+
+  // 页面锁与根互斥量只在 CRABBING 和 OPTIMISTIC 模式下使用
+  auto UsesLatches() const -> bool { return mode_ >= ConcurrencyMode::CRABBING; }
+  // GLOBAL_LOCK 模式下的树级读写锁，其他模式返回不持有锁的 guard
+  auto SharedTreeLock() const -> std::shared_lock<std::shared_mutex> {
+    if (mode_ == ConcurrencyMode::GLOBAL_LOCK) {
+      return std::shared_lock<std::shared_mutex>(mutex_);
+    }
+    return {};
+  }
+  auto ExclusiveTreeLock() const -> std::unique_lock<std::shared_mutex> {
+    if (mode_ == ConcurrencyMode::GLOBAL_LOCK) {
+      return std::unique_lock<std::shared_mutex>(mutex_);
+    }
+    return {};
+  }
+  auto ActiveLatchProfiler() -> LatchProfiler * {
+    return latch_profiler_.IsEnabled() ? &latch_profiler_ : nullptr;
+  }
+
+  // append 为 true 时 key 是最右叶子中最大的键，分裂后旧页面保持满
   auto SplitLeafPage(LeafPage *leaf_page, LeafPage *new_page, const KeyType &key,
-                     const ValueType &value, int32_t new_page_id) -> KeyType;
+                     const ValueType &value, int32_t new_page_id, bool append) -> KeyType;
 
   /**
    * @return The key that should be inserted into the parent page.
    */
   auto SplitInternalPage(InternalPage *internal_page, InternalPage *new_page, const KeyType &key,
-                         int32_t new_page_id) -> KeyType;
+                         const ChildRef &new_child, bool append) -> KeyType;
+  // append 为 true 时 new_node 是所在层最右的页面
   auto InsertIntoParent(BPlusTreePage *old_node, const KeyType &key, BPlusTreePage *new_node,
-                        Context *ctx) -> bool;
-  auto RemoveLeafEntry(LeafPage *leaf_page, InternalPage *parent_page, const KeyType &key,
-                       Context *ctx) -> void;
-
-  auto RemoveInternalEntry(InternalPage *internal_page, InternalPage *parent_page,
-                           const KeyType &key, Context *ctx) -> void;
+                        Context *ctx, bool append) -> bool;
+  // 在缓存的最右叶子末尾插入，不满足条件时返回 false，由调用方从根下降
+  auto TryAppend(const KeyType &key, const ValueType &value) -> bool;
+  // 叶子成为最右叶子时记入缓存
+  auto RememberRightmostLeaf(LeafPage *leaf) -> void {
+    if (IsAppendMode() && leaf->GetNextPageId() == INVALID_PAGE_ID &&
+        rightmost_leaf_.load(std::memory_order_relaxed) != leaf) {
+      rightmost_leaf_.store(leaf, std::memory_order_release);
+    }
+  }
+  // 叶子离开树之前调用，调用方持有叶子的写锁
+  auto ForgetRightmostLeaf(LeafPage *leaf) -> void {
+    LeafPage *expected = leaf;
+    rightmost_leaf_.compare_exchange_strong(expected, nullptr, std::memory_order_release,
+                                            std::memory_order_relaxed);
+  }
+  // 代数全局递增，先后位于同一地址的两棵树记录的叶子也不会互相匹配
+  static auto NextLeafGeneration() -> uint64_t {
+    static std::atomic<uint64_t> next{1};
+    return next.fetch_add(1, std::memory_order_relaxed);
+  }
+  // 使所有线程的 finger 失效。叶子被释放时调用（之后页面可能被回收，不能再访问）；
+  // 不加锁的模式下没有锁版本，叶子范围缩小（分裂、借用）时也要调用
+  auto InvalidateCachedLeaves() -> void {
+    leaf_generation_.store(NextLeafGeneration(), std::memory_order_seq_cst);
+  }
+  auto LeafRangeChanged() -> void {
+    if (!UsesLatches()) {
+      InvalidateCachedLeaves();
+    }
+  }
+  // 下降到内部页面的第 index 个子页面时收紧 range
+  static auto NarrowRange(const InternalPage *page, int index, KeyRange *range) -> void {
+    if (index > 0) {
+      range->low = page->KeyAt(index);
+      range->has_low = true;
+    }
+    if (index + 1 < page->GetSize()) {
+      range->high = page->KeyAt(index + 1);
+      range->has_high = true;
+    }
+  }
+  // 返回可以直接使用的 finger 叶子，调用方随后加锁并用 FingerStillValid 确认
+  auto FingerLeaf(const KeyType &key) -> LeafPage *;
+  auto FingerStillValid(LeafPage *leaf) -> bool {
+    return !UsesLatches() || leaf->LatchVersion() == LocalFinger().version;
+  }
+  // 调用方持有 leaf 的锁；exclusive 表示持有写锁，解锁后版本会再加一
+  auto SetFinger(LeafPage *leaf, const KeyRange &range, bool exclusive) -> void;
+  // 通过哈希索引读取 key 的值，条目不存在或已失效时返回 false
+  auto TryHashIndex(const KeyType &key, ValueType *value) -> bool;
+  // 通过 finger 直接在叶子中插入；叶子需要分裂或 finger 不可用时返回 false，由调用方从根下降
+  auto TryFingerInsert(const KeyType &key, const ValueType &value, bool *inserted) -> bool;
+  // index 为 leaf_page 在 parent_page 中的位置（下降时记录在 Context 中）
+  auto RemoveLeafEntry(LeafPage *leaf_page, InternalPage *parent_page, int index, Context *ctx)
+      -> void;
+
+  auto RemoveInternalEntry(InternalPage *internal_page, InternalPage *parent_page, int index,
+                           Context *ctx) -> void;
   auto LeafCanMerge(LeafPage *merge_page, LeafPage *left_leaf, LeafPage *right_leaf)
       -> std::pair<bool, bool>;
 
@@ -251,15 +638,41 @@ class BPlusTree {
   std::vector<std::string> log;
   int leaf_max_size_;
   int internal_max_size_;
+  ConcurrencyMode mode_;
   // page_id_t header_page_id_;
 
+  // CRABBING/OPTIMISTIC 模式下保护根页面 id 的根互斥量，GLOBAL_LOCK 模式下的树级锁
   mutable std::shared_mutex mutex_;
   //  std::vector<page_id_t> page_ids_;
   std::mutex pages_mutex_;
   std::unordered_map<page_id_t, BPlusTreePage *> pages_;
+  // 已从页表摘除、等待没有操作能访问后再释放的页面
+  EpochManager epoch_;
   page_id_t next_page_id_ = 1;
 
   int32_t root_page_id_ = INVALID_PAGE_ID;
+
+  TreeMetrics metrics_;
+  // GetStats 使用的计数，随结构变化维护
+  std::atomic<int64_t> stat_keys_{0};
+  std::atomic<int64_t> stat_leaf_pages_{0};
+  std::atomic<int64_t> stat_internal_pages_{0};
+  std::atomic<int> stat_height_{0};
+  std::atomic<bool> append_mode_{false};
+  // 追加模式缓存的最右叶子，使用前加写锁并确认它仍是最右叶子
+  std::atomic<LeafPage *> rightmost_leaf_{nullptr};
+  std::atomic<bool> finger_enabled_{false};
+  // 与 finger 或哈希索引条目中记录的值不同时，记录的叶子指针不能再使用
+  std::atomic<uint64_t> leaf_generation_{NextLeafGeneration()};
+  AdaptiveHashIndex<KeyType, KeyComparator> hash_index_{comparator_};
+  LatchProfiler latch_profiler_;
+  TraceRecorder tracer_;
+
+  std::vector<BulkLevel> bulk_levels_;
+  double bulk_fill_factor_ = 1.0;
+  LeafPage *bulk_prev_leaf_ = nullptr;
+  bool bulk_has_last_key_ = false;
+  KeyType bulk_last_key_{};
 };
 
 struct PrintableBPlusTree {
@@ -0,0 +1,25 @@
+#ifndef B_PLUS_TREE_CODEC_H
+#define B_PLUS_TREE_CODEC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * 叶子页面键列的帧参考(frame-of-reference)编码。
+ * 有序键存为 key - keys[0]，宽度取能容纳最大差值的 0/1/2/4/8 字节，
+ * 按字节对齐存储，使解码循环可以被编译器向量化。
+ */
+int codec_key_width(const int64_t *keys, int count);
+size_t codec_keys_size(int count, int width);
+void codec_encode_keys(const int64_t *keys, int count, int width, uint8_t *out);
+void codec_decode_keys(const uint8_t *in, int count, int64_t base, int width, int64_t *out);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // B_PLUS_TREE_CODEC_H
@@ -0,0 +1,28 @@
+#ifndef B_PLUS_TREE_CRC32C_H
+#define B_PLUS_TREE_CRC32C_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * CRC32C (Castagnoli)。支持 SSE4.2 的 x86-64 上使用 crc32 指令，
+ * 否则使用 slicing-by-8 的查表实现，两者结果一致。
+ * crc 为之前数据的校验值（首次为 0），返回追加 data 之后的校验值。
+ */
+uint32_t crc32c_extend(uint32_t crc, const void *data, size_t len);
+
+// 软件实现，用于测试以及不支持 SSE4.2 的平台
+uint32_t crc32c_extend_portable(uint32_t crc, const void *data, size_t len);
+
+bool crc32c_is_hardware_accelerated(void);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // B_PLUS_TREE_CRC32C_H
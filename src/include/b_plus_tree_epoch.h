@@ -0,0 +1,88 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace mybplus {
+
+/**
+ * Epoch-based reclamation. An operation that may hold page pointers without a latch runs inside
+ * an EpochGuard, which publishes the global epoch it started in. Retire queues an object on the
+ * calling thread's limbo list stamped with the current epoch; the object is destroyed once every
+ * operation still running started in a later epoch, so no thread can still reach it.
+ *
+ * Threads map onto a fixed set of slots. Two threads may share a slot; a shared slot keeps the
+ * oldest epoch of its running operations, which only delays reclamation.
+ */
+class EpochManager {
+ public:
+  static constexpr int kSlots = 64;
+  static constexpr size_t kReclaimBatch = 64;  // 每个 limbo 列表攒够这么多对象才尝试回收
+
+  using Destroy = void (*)(void *);
+
+  EpochManager() = default;
+  // Destroys everything still retired; no thread may be inside an epoch
+  ~EpochManager() { ReclaimAll(); }
+  EpochManager(const EpochManager &) = delete;
+  auto operator=(const EpochManager &) -> EpochManager & = delete;
+
+  // Returns the slot to pass to Exit
+  auto Enter() -> int;
+  auto Exit(int slot) -> void;
+
+  auto Retire(void *object, Destroy destroy) -> void;
+  // Advances the epoch and destroys every retired object no running operation can reach.
+  // Returns the number destroyed.
+  auto Reclaim() -> size_t;
+  // Destroys every retired object; no thread may be inside an epoch
+  auto ReclaimAll() -> void;
+  // Objects retired but not destroyed yet
+  auto PendingCount() -> size_t;
+
+ private:
+  struct Retired {
+    void *object;
+    Destroy destroy;
+    uint64_t epoch;
+  };
+  struct alignas(64) Slot {
+    // 高 32 位为进入时的 epoch，低 32 位为正在运行的操作数
+    std::atomic<uint64_t> state{0};
+    std::mutex limbo_mutex;
+    std::vector<Retired> limbo;
+  };
+
+  static constexpr uint64_t kCountMask = 0xffffffffULL;
+
+  static auto LocalSlot() -> int;
+  auto MinActiveEpoch() const -> uint64_t;
+  // 回收 slot 中 epoch 小于 safe_epoch 的对象，调用方持有 limbo_mutex
+  static auto ReclaimSlot(Slot *slot, uint64_t safe_epoch) -> size_t;
+
+  std::atomic<uint64_t> global_epoch_{1};
+  std::array<Slot, kSlots> slots_;
+};
+
+// Keeps the calling thread inside an epoch for its lifetime; does nothing when enter is false
+class EpochGuard {
+ public:
+  explicit EpochGuard(EpochManager &manager, bool enter = true)
+      : manager_(manager), slot_(enter ? manager.Enter() : -1) {}
+  ~EpochGuard() {
+    if (slot_ >= 0) {
+      manager_.Exit(slot_);
+    }
+  }
+  EpochGuard(const EpochGuard &) = delete;
+  auto operator=(const EpochGuard &) -> EpochGuard & = delete;
+
+ private:
+  EpochManager &manager_;
+  int slot_;
+};
+
+}  // namespace mybplus
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "b_plus_tree_latch.h"
+#include "b_plus_tree_page.h"
+
+namespace mybplus {
+
+struct HashIndexStats {
+  auto HitRate() const -> double {
+    return lookups == 0 ? 0.0 : static_cast<double>(hits) / lookups;
+  }
+
+  size_t capacity = 0;  // entries
+  size_t bytes = 0;     // table plus leaf heat and generation counters
+  uint64_t lookups = 0;
+  uint64_t hits = 0;  // lookups answered from the index, after the leaf check
+  uint64_t stores = 0;
+};
+
+/**
+ * Adaptive hash index: a fixed-size table from key to the leaf and slot the key was last found
+ * in, filled only for leaves that point lookups keep reaching, so a hot key costs one probe
+ * instead of a descent. The table never resizes and replaces entries on collision, so its memory
+ * is bounded by the capacity chosen in Resize.
+ *
+ * Entries are hints. A probe reads its bucket optimistically and never blocks. Each leaf address
+ * hashes to a generation that InvalidateLeaf advances before the leaf is freed, so entries that
+ * point at a freed leaf stop matching without touching entries for other leaves. The tree checks
+ * the remaining location against the leaf (latch version and the key in the slot) before using
+ * it, so a split, merge or delete only turns the entry into a miss.
+ */
+template <typename KeyType, typename KeyComparator>
+class AdaptiveHashIndex {
+ public:
+  struct Location {
+    BPlusTreePage *leaf = nullptr;
+    int slot = 0;
+    uint32_t version = 0;  // 叶子的锁版本，只在加锁模式下使用
+  };
+
+  static constexpr uint8_t kHotThreshold = 8;  // 下降到同一叶子这么多次后开始记录它的键
+
+  explicit AdaptiveHashIndex(const KeyComparator &comparator) : comparator_(comparator) {}
+  AdaptiveHashIndex(const AdaptiveHashIndex &) = delete;
+  auto operator=(const AdaptiveHashIndex &) -> AdaptiveHashIndex & = delete;
+
+  // Rounds capacity up to a power of two; 0 frees the table. Not thread safe.
+  auto Resize(size_t capacity) -> void;
+  auto IsEnabled() const -> bool { return capacity_ != 0; }
+  // Drops every entry and leaf heat count. Not thread safe.
+  auto Clear() -> void;
+
+  // False when the key has no entry, the bucket is being written or the leaf was freed since
+  auto Lookup(const KeyType &key, Location *location) -> bool;
+  // Called by the tree once a location from Lookup checked out; hits over lookups is the hit rate
+  auto RecordHit() -> void;
+  // Counts a descent that ended in leaf; true once the leaf is hot enough to index
+  auto Touch(const BPlusTreePage *leaf) -> bool;
+  // Best effort: skipped when another thread is writing the bucket. The caller must keep the leaf
+  // from being freed until Store returns.
+  auto Store(const KeyType &key, const Location &location) -> void;
+  // Called before a leaf is freed; entries recorded for it no longer match afterwards
+  auto InvalidateLeaf(const BPlusTreePage *leaf) -> void;
+
+  auto Stats() const -> HashIndexStats;
+  auto ResetStats() -> void;
+
+ private:
+  // 乐观读与 Store 并发，各字段都是原子的，在 latch 的版本校验之内用 relaxed 读写；
+  // leaf 为空表示未使用
+  struct Bucket {
+    HybridLatch latch;
+    std::atomic<KeyType> key{};
+    std::atomic<BPlusTreePage *> leaf{nullptr};
+    std::atomic<int> slot{0};
+    std::atomic<uint32_t> version{0};
+    std::atomic<uint64_t> generation{0};  // 记录时叶子的代数
+  };
+  struct alignas(64) CounterSlot {
+    std::atomic<uint64_t> lookups{0};
+    std::atomic<uint64_t> hits{0};
+    std::atomic<uint64_t> stores{0};
+  };
+
+  static constexpr int kCounterSlots = 64;
+  static constexpr uint32_t kAgingInterval = 1024;  // 每个线程每访问这么多次叶子，衰减一段热度
+  static constexpr size_t kAgingStride = 64;
+
+  static auto Mix(uint64_t hash) -> uint64_t { return hash * 0x9E3779B97F4A7C15ULL; }
+  auto BucketFor(const KeyType &key) -> Bucket &;
+  // 叶子地址对应的热度与代数下标
+  auto LeafIndex(const BPlusTreePage *leaf) const -> size_t;
+  auto LocalCounters() -> CounterSlot &;
+
+  KeyComparator comparator_;
+  size_t capacity_ = 0;
+  int shift_ = 64;  // 哈希值右移 shift_ 位得到桶下标
+  std::unique_ptr<Bucket[]> buckets_;
+  // 按叶子地址哈希的下降次数，多个叶子可能共用一个计数
+  std::unique_ptr<std::atomic<uint8_t>[]> heat_;
+  // 按叶子地址哈希的代数，叶子释放前递增；共用下标的叶子释放时也会让彼此的条目失效
+  std::unique_ptr<std::atomic<uint64_t>[]> generations_;
+  std::atomic<size_t> aging_cursor_{0};
+  std::array<CounterSlot, kCounterSlots> counters_;
+};
+
+}  // namespace mybplus
@@ -41,13 +41,17 @@ class BPlusTreeInternalPage : public BPlusTreePage {
 
   auto Delete(int child_page_index) -> bool;
 
-  auto PopulateNewRoot(page_id_t page_id_one, const KeyType &key, page_id_t page_id_two) -> void;
+  auto PopulateNewRoot(const ValueType &child_one, const KeyType &key, const ValueType &child_two)
+      -> void;
 
   auto GetData() -> MappingType * { return array_.data(); }
 
-  auto GetMinPageId() const -> page_id_t { return array_[0].second; }
+  // Number of entries the backing array holds without reallocating
+  auto GetCapacity() const -> size_t { return array_.capacity(); }
 
-  auto GetMaxPageId() const -> page_id_t { return array_[GetSize() - 1].second; }
+  auto GetMinPageId() const -> ValueType { return array_[0].second; }
+
+  auto GetMaxPageId() const -> ValueType { return array_[GetSize() - 1].second; }
 
   void CopyHalfFrom(MappingType *array, int min_size, int size) {
     // TODO: Copy half of the array to this page
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace mybplus {
+
+/**
+ * 8-byte page latch with shared, exclusive and optimistic modes. Shared and exclusive acquisition
+ * is a single CAS when uncontended; a contended caller spins briefly and then parks on a futex
+ * (Linux) or yields (elsewhere). Readers are not blocked by waiting writers.
+ *
+ * Optimistic mode takes no latch: OptimisticRead returns the current version, the caller reads
+ * the protected data, and Validate reports whether an exclusive holder could have changed it in
+ * between. The version advances on every exclusive unlock.
+ */
+class HybridLatch {
+ public:
+  HybridLatch() = default;
+  HybridLatch(const HybridLatch &) = delete;
+  auto operator=(const HybridLatch &) -> HybridLatch & = delete;
+
+  auto LockExclusive() -> void {
+    if (!TryLockExclusive()) {
+      LockExclusiveSlow();
+    }
+  }
+  auto TryLockExclusive() -> bool {
+    uint32_t state = state_.load(std::memory_order_relaxed);
+    while ((state & ~kWaiters) == 0) {
+      if (state_.compare_exchange_weak(state, state | kExclusive, std::memory_order_acquire,
+                                       std::memory_order_relaxed)) {
+        return true;
+      }
+    }
+    return false;
+  }
+  auto UnlockExclusive() -> void {
+    version_.store(version_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    uint32_t prev = state_.fetch_and(~(kExclusive | kWaiters), std::memory_order_release);
+    if ((prev & kWaiters) != 0) {
+      WakeAll();
+    }
+  }
+
+  auto LockShared() -> void {
+    if (!TryLockShared()) {
+      LockSharedSlow();
+    }
+  }
+  auto TryLockShared() -> bool {
+    uint32_t state = state_.load(std::memory_order_relaxed);
+    while (CanShare(state)) {
+      if (state_.compare_exchange_weak(state, state + 1, std::memory_order_acquire,
+                                       std::memory_order_relaxed)) {
+        return true;
+      }
+    }
+    return false;
+  }
+  auto UnlockShared() -> void {
+    uint32_t prev = state_.fetch_sub(1, std::memory_order_release);
+    // 最后一个读者离开时唤醒等待的写者
+    if ((prev & kReaderMask) == 1 && (prev & kWaiters) != 0) {
+      state_.fetch_and(~kWaiters, std::memory_order_relaxed);
+      WakeAll();
+    }
+  }
+
+  // Returns false while the latch is held exclusively
+  auto OptimisticRead(uint32_t *version) const -> bool {
+    *version = version_.load(std::memory_order_acquire);
+    return (state_.load(std::memory_order_acquire) & kExclusive) == 0;
+  }
+  // True if no exclusive holder has run since OptimisticRead returned version
+  auto Validate(uint32_t version) const -> bool {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return (state_.load(std::memory_order_relaxed) & kExclusive) == 0 &&
+           version_.load(std::memory_order_relaxed) == version;
+  }
+  // Current version; stable while the caller holds the latch in either mode
+  auto Version() const -> uint32_t { return version_.load(std::memory_order_acquire); }
+
+ private:
+  static constexpr uint32_t kExclusive = 1U << 31;
+  static constexpr uint32_t kWaiters = 1U << 30;
+  static constexpr uint32_t kReaderMask = kWaiters - 1;
+
+  static auto CanShare(uint32_t state) -> bool {
+    return (state & kExclusive) == 0 && (state & kReaderMask) != kReaderMask;
+  }
+
+  auto LockExclusiveSlow() -> void;
+  auto LockSharedSlow() -> void;
+  // 把 kWaiters 标记到 state 上并休眠，直到 state 发生变化
+  auto Park(uint32_t state) -> void;
+  auto WakeAll() -> void;
+
+  std::atomic<uint32_t> state_{0};  // 写锁位 | 等待者位 | 读者数
+  std::atomic<uint32_t> version_{0};
+};
+
+static_assert(sizeof(HybridLatch) == 8, "HybridLatch is counted into PAGE_HEADER_SIZE");
+
+}  // namespace mybplus
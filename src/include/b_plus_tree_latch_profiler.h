@@ -0,0 +1,111 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "config.h"
+
+namespace mybplus {
+
+enum class LatchMode { SHARED = 0, EXCLUSIVE };
+
+struct LatchStats {
+  auto ContentionRate() const -> double {
+    return acquisitions == 0 ? 0.0 : static_cast<double>(contended) / acquisitions;
+  }
+
+  uint64_t acquisitions = 0;
+  uint64_t contended = 0;  // acquisitions that had to block
+  uint64_t wait_ns = 0;    // total time spent blocking
+  uint64_t max_wait_ns = 0;
+};
+
+struct LatchProfileSnapshot {
+  struct HotPage {
+    page_id_t page_id;
+    uint64_t contended;
+    uint64_t wait_ns;
+  };
+
+  // Table with shared and exclusive rows for the root mutex, then each level in depth order (0 is
+  // the root page), followed by the top contended pages, most waited-on first
+  auto ToString() const -> std::string;
+
+  std::array<LatchStats, 2> root;                 // indexed by LatchMode
+  std::vector<std::array<LatchStats, 2>> levels;  // levels[depth][mode]
+  std::vector<HotPage> top_pages;                 // most waited-on pages first
+  uint64_t untracked_contentions = 0;             // events that did not fit in the page table
+};
+
+/**
+ * Optional latch instrumentation for Context. Every acquisition first tries the latch; only when
+ * that fails is the blocking wait timed, so uncontended acquisitions never read the clock.
+ * Acquisition counts are kept in per-thread slots; contended events are also recorded per page
+ * in a fixed-size lock-free table from which the "top contended pages" report is built.
+ */
+class LatchProfiler {
+ public:
+  static constexpr int kRootLevel = -1;  // the tree's root mutex
+  static constexpr int kMaxLevels = 16;
+  static constexpr int kMaxSlots = 64;
+  static constexpr int kPageTableSize = 4096;
+
+  LatchProfiler();
+  ~LatchProfiler();
+  LatchProfiler(const LatchProfiler &) = delete;
+  auto operator=(const LatchProfiler &) -> LatchProfiler & = delete;
+
+  auto SetEnabled(bool enabled) -> void { enabled_.store(enabled, std::memory_order_relaxed); }
+  auto IsEnabled() const -> bool { return enabled_.load(std::memory_order_relaxed); }
+
+  template <typename TryLock, typename Lock>
+  auto Acquire(int level, page_id_t page_id, LatchMode mode, TryLock &&try_lock, Lock &&lock)
+      -> void {
+    if (try_lock()) {
+      Record(level, page_id, mode, 0, false);
+      return;
+    }
+    auto start = std::chrono::steady_clock::now();
+    lock();
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    Record(level, page_id, mode,
+           std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count(), true);
+  }
+
+  auto Snapshot(size_t top_pages = 10) const -> LatchProfileSnapshot;
+  // Not synchronized with concurrent recording; call while the tree is quiescent
+  auto Reset() -> void;
+
+ private:
+  struct Counters {
+    std::atomic<uint64_t> acquisitions{0};
+    std::atomic<uint64_t> contended{0};
+    std::atomic<uint64_t> wait_ns{0};
+    std::atomic<uint64_t> max_wait_ns{0};
+  };
+  struct alignas(64) Slot {
+    std::array<Counters, 2> root;
+    std::array<std::array<Counters, 2>, kMaxLevels> levels;
+  };
+  struct PageEntry {
+    std::atomic<page_id_t> page_id{INVALID_PAGE_ID};
+    std::atomic<uint64_t> contended{0};
+    std::atomic<uint64_t> wait_ns{0};
+  };
+
+  auto Record(int level, page_id_t page_id, LatchMode mode, uint64_t wait_ns, bool contended)
+      -> void;
+  auto RecordPage(page_id_t page_id, uint64_t wait_ns) -> void;
+  auto LocalSlot() -> Slot *;
+
+  std::atomic<bool> enabled_{false};
+  std::array<std::atomic<Slot *>, kMaxSlots> slots_{};
+  PageEntry *pages_;
+  std::atomic<uint64_t> untracked_{0};
+};
+
+}  // namespace mybplus
@@ -42,8 +42,14 @@ class BPlusTreeLeafPage : public BPlusTreePage {
   auto FindValue(const KeyType &key, const KeyComparator &comparator, ValueType &value,
                  int *child_page_index) const -> bool;
 
+  // Index of the first entry whose key is not less than key (GetSize() if there is none)
+  auto KeyIndex(const KeyType &key, const KeyComparator &comparator) const -> int;
+
   auto GetData() -> MappingType * { return array_.data(); }
 
+  // Number of entries the backing array holds without reallocating
+  auto GetCapacity() const -> size_t { return array_.capacity(); }
+
   void CopyHalfFrom(MappingType *array, int min_size, int size);
 
   auto Insert(const KeyType &key, const ValueType &value, const KeyComparator &comparator) -> bool;
@@ -0,0 +1,29 @@
+#ifndef B_PLUS_TREE_LZ_H
+#define B_PLUS_TREE_LZ_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * 快照文件使用的块压缩编码。
+ * 输出为 LZ4 块格式（token + 字面量 + 2 字节偏移 + 匹配长度），
+ * 不依赖任何外部库；压缩端为单哈希表的贪心匹配，解压端对输入做完整的越界检查。
+ */
+
+// 压缩 src_size 字节在最坏情况下需要的输出空间
+int lz_compress_bound(int src_size);
+
+// 返回压缩后的字节数；dst 空间不足时返回 0
+int lz_compress(const uint8_t *src, int src_size, uint8_t *dst, int dst_capacity);
+
+// 返回解压后的字节数；输入损坏或 dst 空间不足时返回 -1
+int lz_decompress(const uint8_t *src, int src_size, uint8_t *dst, int dst_capacity);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // B_PLUS_TREE_LZ_H
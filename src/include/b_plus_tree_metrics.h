@@ -0,0 +1,153 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace mybplus {
+
+// 记录延迟的操作
+enum class MetricOp { GET = 0, INSERT, REMOVE, UPDATE, SCAN, COUNT };
+
+// 结构变化与页面分配计数
+enum class MetricCounter {
+  LEAF_SPLIT = 0,
+  INTERNAL_SPLIT,
+  LEAF_MERGE,
+  INTERNAL_MERGE,
+  LEAF_BORROW,
+  INTERNAL_BORROW,
+  RESTART,
+  PAGE_ALLOC,
+  PAGE_FREE,
+  APPEND_HIT,  // 追加模式下直接插入缓存的最右叶子
+  FINGER_HIT,  // 通过本线程的 finger 直接定位到叶子
+  COUNT
+};
+
+constexpr int kMetricOpCount = static_cast<int>(MetricOp::COUNT);
+constexpr int kMetricCounterCount = static_cast<int>(MetricCounter::COUNT);
+
+auto MetricOpName(MetricOp op) -> const char *;
+auto MetricCounterName(MetricCounter counter) -> const char *;
+
+/**
+ * Log-linear latency histogram in the style of HdrHistogram. Values below 32ns are exact; above
+ * that every power of two is split into 16 linear sub-buckets, so any recorded value is reported
+ * within 1/16 of itself. Values are nanoseconds and saturate at 2^40 (about 18 minutes).
+ */
+struct HistogramSnapshot {
+  static constexpr int kSubBucketBits = 4;
+  static constexpr int kSubBucketCount = 1 << kSubBucketBits;
+  static constexpr int kMaxExponent = 39;
+  static constexpr int kBucketCount = (kMaxExponent - kSubBucketBits + 2) * kSubBucketCount;
+
+  static auto BucketIndex(uint64_t value) -> int;
+  // Largest value that maps to the bucket
+  static auto BucketUpperBound(int index) -> uint64_t;
+
+  // Value at quantile q in [0, 1], e.g. 0.999 for p999
+  auto Percentile(double q) const -> uint64_t;
+  auto Mean() const -> double { return count == 0 ? 0.0 : static_cast<double>(sum) / count; }
+
+  // Plain (non-atomic) recording for callers that keep one histogram per thread and merge them
+  auto Record(uint64_t value) -> void;
+  auto Merge(const HistogramSnapshot &other) -> void;
+
+  std::vector<uint64_t> buckets = std::vector<uint64_t>(kBucketCount, 0);
+  uint64_t count = 0;
+  uint64_t sum = 0;
+  uint64_t min = 0;
+  uint64_t max = 0;
+};
+
+struct MetricsSnapshot {
+  auto Latency(MetricOp op) const -> const HistogramSnapshot & {
+    return latency[static_cast<int>(op)];
+  }
+  auto Counter(MetricCounter counter) const -> uint64_t {
+    return counters[static_cast<int>(counter)];
+  }
+  // Human-readable table of latency percentiles followed by the counters
+  auto ToString() const -> std::string;
+
+  std::array<HistogramSnapshot, kMetricOpCount> latency;
+  std::array<uint64_t, kMetricCounterCount> counters{};
+};
+
+/**
+ * Per-tree metrics. Each thread records into its own cache-line aligned slot, allocated on
+ * first use, so recording never contends with other threads; Snapshot() sums all slots.
+ * Disabled by default, in which case recording costs a single relaxed load.
+ */
+class TreeMetrics {
+ public:
+  static constexpr int kMaxSlots = 64;
+
+  TreeMetrics() = default;
+  ~TreeMetrics();
+  TreeMetrics(const TreeMetrics &) = delete;
+  auto operator=(const TreeMetrics &) -> TreeMetrics & = delete;
+
+  auto SetEnabled(bool enabled) -> void { enabled_.store(enabled, std::memory_order_relaxed); }
+  auto IsEnabled() const -> bool { return enabled_.load(std::memory_order_relaxed); }
+
+  auto RecordLatency(MetricOp op, uint64_t nanos) -> void;
+  auto Increment(MetricCounter counter, uint64_t amount = 1) -> void {
+    if (IsEnabled()) {
+      LocalSlot()->counters[static_cast<int>(counter)].fetch_add(amount,
+                                                                  std::memory_order_relaxed);
+    }
+  }
+
+  auto Snapshot() const -> MetricsSnapshot;
+  auto Reset() -> void;
+
+ private:
+  struct Histogram {
+    std::array<std::atomic<uint64_t>, HistogramSnapshot::kBucketCount> buckets{};
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> sum{0};
+    std::atomic<uint64_t> min{UINT64_MAX};
+    std::atomic<uint64_t> max{0};
+  };
+  struct alignas(64) Slot {
+    std::array<std::atomic<uint64_t>, kMetricCounterCount> counters{};
+    std::array<Histogram, kMetricOpCount> latency;
+  };
+
+  auto LocalSlot() -> Slot *;
+
+  std::atomic<bool> enabled_{false};
+  std::array<std::atomic<Slot *>, kMaxSlots> slots_{};
+};
+
+// Records the lifetime of the object as one operation's latency
+class ScopedLatency {
+ public:
+  ScopedLatency(TreeMetrics &metrics, MetricOp op)
+      : metrics_(metrics.IsEnabled() ? &metrics : nullptr), op_(op) {
+    if (metrics_ != nullptr) {
+      start_ = std::chrono::steady_clock::now();
+    }
+  }
+  ~ScopedLatency() {
+    if (metrics_ != nullptr) {
+      auto elapsed = std::chrono::steady_clock::now() - start_;
+      metrics_->RecordLatency(
+          op_, std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    }
+  }
+  ScopedLatency(const ScopedLatency &) = delete;
+  auto operator=(const ScopedLatency &) -> ScopedLatency & = delete;
+
+ private:
+  TreeMetrics *metrics_;
+  MetricOp op_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+}  // namespace mybplus
@@ -2,11 +2,11 @@
 
 #include <cassert>
 #include <climits>
+#include <cstdint>
 #include <cstdlib>
-#include <mutex>
-#include <shared_mutex>
 #include <string>
 
+#include "b_plus_tree_latch.h"
 #include "config.h"
 namespace mybplus {
 
@@ -14,13 +14,9 @@ namespace mybplus {
 
 #define INDEX_TEMPLATE_ARGUMENTS \
   template <typename KeyType, typename ValueType, typename KeyComparator>
-#ifdef USING_CRABBING_PROTOCOL
 #define PAGE_HEADER_SIZE                                                     \
   (sizeof(int32_t) + sizeof(int) + sizeof(IndexPageType) + sizeof(int32_t) + \
-   sizeof(std::shared_mutex))
-#else
-#define PAGE_HEADER_SIZE (sizeof(int32_t) + sizeof(int) + sizeof(IndexPageType) + sizeof(int32_t))
-#endif
+   sizeof(HybridLatch))
 // define page type enum
 enum class IndexPageType { INVALID_INDEX_PAGE = 0, LEAF_PAGE, INTERNAL_PAGE };
 
@@ -49,22 +45,67 @@ class BPlusTreePage {
   auto GetPageId() const -> int32_t { return page_id_; }
   void SetPageId(int32_t page_id) { page_id_ = page_id; }
 
-#ifdef USING_CRABBING_PROTOCOL
-  auto WLock() const -> void { mutex_.lock(); }
-  auto RLock() const -> void { mutex_.lock_shared(); }
-  auto Unlock() const -> void { mutex_.unlock(); }
-  auto RUnlock() const -> void { mutex_.unlock_shared(); }
-#endif
+  // Page latches; only taken when the tree runs in CRABBING or OPTIMISTIC mode
+  auto WLock() const -> void { latch_.LockExclusive(); }
+  auto RLock() const -> void { latch_.LockShared(); }
+  auto Unlock() const -> void { latch_.UnlockExclusive(); }
+  auto RUnlock() const -> void { latch_.UnlockShared(); }
+  auto TryWLock() const -> bool { return latch_.TryLockExclusive(); }
+  auto TryRLock() const -> bool { return latch_.TryLockShared(); }
+  // Optimistic reads: no latch is taken, ValidateRead fails if a writer ran in between
+  auto OptimisticRead(uint32_t *version) const -> bool { return latch_.OptimisticRead(version); }
+  auto ValidateRead(uint32_t version) const -> bool { return latch_.Validate(version); }
+  // Advances on every exclusive unlock; read it while holding the latch
+  auto LatchVersion() const -> uint32_t { return latch_.Version(); }
 
  private:
   int size_;
   int max_size_;
   IndexPageType page_type_;
   int32_t page_id_;
+  mutable HybridLatch latch_;
+};
+
+/**
+ * Child reference held in internal page slots. A swizzled reference is the child page's address,
+ * so descending a level needs no page table lookup; an unswizzled reference is the child's page
+ * id, for pages that are not in memory yet (deserialization, a buffer pool). Pages are at least
+ * 8-byte aligned, so the low bit tells the two forms apart.
+ */
+class ChildRef {
+ public:
+  ChildRef() = default;
+  static auto FromPage(BPlusTreePage *page) -> ChildRef {
+    return ChildRef(reinterpret_cast<uintptr_t>(page));
+  }
+  static auto FromPageId(page_id_t page_id) -> ChildRef {
+    // 页面 id 放在高位，最低位作为未 swizzle 的标记
+    return ChildRef((static_cast<uintptr_t>(static_cast<uint32_t>(page_id)) << 1) | kUnswizzled);
+  }
+
+  auto IsSwizzled() const -> bool { return (word_ & kUnswizzled) == 0; }
+  // Only valid on a swizzled reference
+  auto GetPage() const -> BPlusTreePage * { return reinterpret_cast<BPlusTreePage *>(word_); }
+  auto GetPageId() const -> page_id_t {
+    return IsSwizzled() ? GetPage()->GetPageId() : static_cast<page_id_t>(word_ >> 1);
+  }
+
+  // Two references are equal when they name the same page, in either form
+  auto operator==(const ChildRef &other) const -> bool {
+    return word_ == other.word_ ||
+           (IsSwizzled() != other.IsSwizzled() && GetPageId() == other.GetPageId());
+  }
+  auto operator!=(const ChildRef &other) const -> bool { return !(*this == other); }
 
-#ifdef USING_CRABBING_PROTOCOL
-  mutable std::shared_mutex mutex_;
-#endif
+ private:
+  static constexpr uintptr_t kUnswizzled = 1;
+
+  explicit ChildRef(uintptr_t word) : word_(word) {}
+
+  uintptr_t word_ = (static_cast<uintptr_t>(static_cast<uint32_t>(INVALID_PAGE_ID)) << 1) |
+                    kUnswizzled;
 };
 
+static_assert(alignof(BPlusTreePage) >= 2, "ChildRef tags the low bit of page addresses");
+
 }  // namespace mybplus
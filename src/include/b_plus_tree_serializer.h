@@ -10,7 +10,21 @@
 #include "b_plus_tree_wrapper.h"
 
 #define MAGIC_NUMBER "MYBPTREE"
-#define VERSION 1
+#define VERSION 2
+
+// 文件头中的格式标志（VERSION >= 2）
+#define SERIALIZER_FLAG_ENCODED 0x1u     // 叶子页面按列存储，键列使用帧参考编码
+#define SERIALIZER_FLAG_COMPRESSED 0x2u  // 页面按块分组后压缩
+#define SERIALIZER_FLAG_SEGMENTED 0x4u   // 根的每个子树独立成段，并行写出/读入
+// 只按键序写出叶子中的元素，读入时自底向上重建（忽略 SEGMENTED）
+#define SERIALIZER_FLAG_LEAF_STREAM 0x8u
+// 每个页面记录之后紧跟该记录的 CRC32C 校验和
+#define SERIALIZER_FLAG_CHECKSUM 0x10u
+
+// 压缩格式下每个块包含的页面数
+#define SERIALIZER_PAGES_PER_BLOCK 64
+// 低于这个填充率时批量构建出的页面会低于最小大小
+#define SERIALIZER_MIN_FILL_FACTOR 0.5
 
 // 文件头结构
 typedef struct {
@@ -20,6 +34,7 @@ typedef struct {
   int leaf_max_size;
   int internal_max_size;
   uint32_t page_count;
+  uint32_t flags;  // VERSION 1 的文件没有该字段
 } FileHeader;
 
 // 页面头结构
@@ -29,6 +44,14 @@ typedef struct {
   int size;
 } PageHeader;
 
+// 块头结构，紧跟 stored_size 字节的块数据
+// stored_size == raw_size 表示该块未压缩（压缩后没有变小）
+typedef struct {
+  uint32_t page_count;
+  uint32_t raw_size;
+  uint32_t stored_size;
+} BlockHeader;
+
 // 用于BFS
 typedef struct QueueNode {
   page_id_t page_id;
@@ -44,6 +67,10 @@ typedef struct {
 typedef struct {
   CBPlusTree *tree;
   char *storage_path;
+  uint32_t flags;  // 写入时使用的格式标志，默认为 0（原始格式）
+  int threads;     // 段格式使用的线程数，0 表示使用全部 CPU
+  double fill_factor;  // 叶子流重建时的填充率，默认 1.0，最低 SERIALIZER_MIN_FILL_FACTOR
+  bool verify;         // 读入时是否校验页面校验和，默认为 true
 } BPlusTreeSerializer;
 
 Queue *queue_create();
@@ -54,6 +81,13 @@ void queue_destroy(Queue *q);
 
 BPlusTreeSerializer *serializer_create(CBPlusTree *tree, const char *storage_path);
 void serializer_destroy(BPlusTreeSerializer *serializer);
+void serializer_set_flags(BPlusTreeSerializer *serializer, uint32_t flags);
+void serializer_set_threads(BPlusTreeSerializer *serializer, int threads);
+void serializer_set_fill_factor(BPlusTreeSerializer *serializer, double fill_factor);
+// 关闭后读入时跳过校验和检查，用于可信的本地文件
+void serializer_set_verify(BPlusTreeSerializer *serializer, bool verify);
 bool serializer_serialize(BPlusTreeSerializer *serializer);
 bool serializer_deserialize(BPlusTreeSerializer *serializer);
+// 只扫描并校验 storage_path 中的文件，不修改树
+bool serializer_verify(BPlusTreeSerializer *serializer);
 #endif  // B_PLUS_TREE_SERIALIZER_H
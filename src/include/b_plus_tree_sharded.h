@@ -0,0 +1,135 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "b_plus_tree.h"
+#include "b_plus_tree_epoch.h"
+#include "b_plus_tree_latch.h"
+
+namespace mybplus {
+
+// One shard's key range [low, high) and size; the last shard has no upper bound
+template <typename KeyType>
+struct ShardInfo {
+  KeyType low{};
+  KeyType high{};
+  bool has_high = false;
+  uint64_t key_count = 0;
+};
+
+/**
+ * Range-partitioned set of BPlusTrees. The key space is split into contiguous ranges, each held
+ * by its own tree with its own root and page table, so writers to different ranges never meet on
+ * a latch. The routing table of range bounds is read without locking: it is replaced as a whole
+ * and the old one retired through an EpochManager.
+ *
+ * Rebalance keeps the shard count at num_shards once the tree holds enough keys. While there are
+ * fewer shards, the largest one is split at its median key as long as it holds at least
+ * kMinSplitKeys keys. After that, a shard holding more than twice the mean number of keys of
+ * the current shards is split, and while there are more than num_shards shards the adjacent pair
+ * with the fewest keys is merged. A split or merge copies the affected shards'
+ * entries and rebuilds them with a bulk load; operations on those ranges wait until the new
+ * shards are published, which takes time proportional to their size. Other shards are not
+ * affected. Unless automatic rebalancing is turned off, every kRebalanceInterval Insert and
+ * Remove calls per thread wake a background thread that runs rebalance steps until the shards
+ * are balanced; the calling operation never does the copy itself.
+ *
+ * Shards start from the lowest KeyType value, so KeyType must have std::numeric_limits.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+class ShardedBPlusTree {
+  using Tree = BPlusTree<KeyType, ValueType, KeyComparator>;
+
+ public:
+  static constexpr uint64_t kMinSplitKeys = 1024;  // 小于这个键数的分片不再分裂
+  static constexpr uint32_t kRebalanceInterval = 4096;
+
+  // split_keys, in increasing order, give the initial shard boundaries; without them the tree
+  // starts as one shard and splits as it grows.
+  explicit ShardedBPlusTree(std::string name, const KeyComparator &comparator, int num_shards,
+                            const std::vector<KeyType> &split_keys = {},
+                            int leaf_max_size = LEAF_PAGE_SIZE,
+                            int internal_max_size = INTERNAL_PAGE_SIZE,
+                            ConcurrencyMode mode = DEFAULT_CONCURRENCY_MODE);
+  ~ShardedBPlusTree();
+  ShardedBPlusTree(const ShardedBPlusTree &) = delete;
+  auto operator=(const ShardedBPlusTree &) -> ShardedBPlusTree & = delete;
+
+  auto GetValue(const KeyType &key, ValueType *value) -> bool;
+  auto Insert(const KeyType &key, const ValueType &value) -> bool;
+  auto Update(const KeyType &key, const ValueType &value) -> bool;
+  void Remove(const KeyType &key);
+  // Same contract as BPlusTree::Scan; continues into the following shards as needed
+  auto Scan(const KeyType &start_key, size_t max_count,
+            std::vector<std::pair<KeyType, ValueType>> *result) -> size_t;
+
+  // Runs one split or merge on the calling thread if the shards are skewed; returns false if
+  // nothing changed
+  auto Rebalance() -> bool;
+  // Turning it off waits for a running background step; no background step starts afterwards
+  auto SetAutoRebalance(bool enabled) -> void;
+
+  auto GetShards() -> std::vector<ShardInfo<KeyType>>;
+  auto ShardCount() -> size_t;
+  auto KeyCount() -> uint64_t;
+
+ private:
+  struct Shard {
+    KeyType low{};
+    KeyType high{};
+    bool has_high = false;
+    std::unique_ptr<Tree> tree;
+    // 操作持有共享锁；重新划分前先置 retired，再加排他锁等正在运行的操作结束
+    HybridLatch latch;
+    std::atomic<bool> retired{false};
+  };
+  // 按 low 递增排列，第一个分片从 KeyType 的最小值开始
+  struct RoutingTable {
+    std::vector<Shard *> shards;
+  };
+
+  auto NewShard(const KeyType &low, const KeyType *high) -> Shard *;
+  auto Route(const RoutingTable &table, const KeyType &key) const -> size_t;
+  // 在 key 所在的分片上执行 fn，分片正在重新划分时等待新的路由表
+  template <typename Fn>
+  auto WithShard(const KeyType &key, Fn &&fn);
+  // 每个线程每 kRebalanceInterval 次写操作唤醒一次后台线程
+  auto MaybeRebalance() -> void;
+  auto RebalanceLoop() -> void;
+  auto RebalanceLocked() -> bool;
+  // 用 replacements 替换路由表中从 first 开始的 count 个分片，调用方持有 rebalance_mutex_
+  auto ReplaceShards(size_t first, size_t count, const std::vector<Shard *> &replacements)
+      -> void;
+  auto SplitShard(size_t index) -> void;
+  auto MergeShards(size_t index) -> void;
+
+  std::string name_;
+  KeyComparator comparator_;
+  size_t num_shards_;
+  int leaf_max_size_;
+  int internal_max_size_;
+  ConcurrencyMode mode_;
+  uint64_t next_shard_id_ = 0;
+
+  std::atomic<RoutingTable *> table_{nullptr};
+  std::mutex rebalance_mutex_;  // 同一时间只有一个线程重新划分
+  std::atomic<bool> auto_rebalance_{true};
+  // 被替换的路由表与分片在没有操作能访问之后释放
+  EpochManager epoch_;
+
+  std::mutex signal_mutex_;  // 保护 rebalance_requested_，以及 stopping_ 的写入
+  std::condition_variable wakeup_;
+  bool rebalance_requested_ = false;
+  std::atomic<bool> stopping_{false};
+  std::thread rebalancer_;
+};
+
+}  // namespace mybplus
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace mybplus {
+
+/**
+ * Tree shape and space usage. The summary fields come from counters the tree maintains on every
+ * structural change and cost nothing to read; the fields marked "full scan" are only filled in
+ * when GetStats is asked to walk the tree.
+ */
+struct TreeStats {
+  static constexpr int kFillBuckets = 10;  // 10% of the page capacity per bucket
+
+  // Fraction of leaf capacity holding live entries
+  auto LeafFillFactor(int leaf_max_size) const -> double {
+    // 叶子页面最多容纳 max - 1 个元素
+    uint64_t per_page = leaf_max_size > 1 ? leaf_max_size - 1 : 1;
+    uint64_t capacity = leaf_pages * per_page;
+    return capacity == 0 ? 0.0 : static_cast<double>(key_count) / capacity;
+  }
+  auto ToString() const -> std::string;
+
+  int height = 0;
+  uint64_t key_count = 0;
+  uint64_t leaf_pages = 0;
+  uint64_t internal_pages = 0;
+
+  bool full_scan = false;
+  std::vector<uint64_t> pages_per_level;               // full scan, index 0 is the root
+  std::array<uint64_t, kFillBuckets> leaf_fill{};      // full scan, pages per fill bucket
+  std::array<uint64_t, kFillBuckets> internal_fill{};  // full scan
+  uint64_t bytes_used = 0;       // full scan, live entries
+  uint64_t bytes_allocated = 0;  // full scan, page objects plus entry array capacity
+  // full scan, entry array capacity beyond the page max size (std::vector growth)
+  uint64_t bytes_excess_capacity = 0;
+};
+
+}  // namespace mybplus
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace mybplus {
+
+enum class TraceOp : uint8_t { GET = 0, INSERT, REMOVE, UPDATE, SCAN };
+
+/**
+ * One traced call, 24 bytes in native byte order. timestamp_ns is the call's start relative to
+ * TraceRecorder::Start; thread is a small per-recorder thread index; arg is the scan length.
+ */
+struct TraceRecord {
+  uint64_t timestamp_ns;
+  int64_t key;
+  uint32_t arg;
+  uint16_t thread;
+  uint8_t op;
+  uint8_t reserved;
+};
+static_assert(sizeof(TraceRecord) == 24, "trace records are written as raw 24-byte structs");
+
+struct TraceHeader {
+  static constexpr char kMagic[8] = {'B', 'P', 'T', 'T', 'R', 'A', 'C', 'E'};
+  static constexpr uint32_t kVersion = 1;
+
+  char magic[8];
+  uint32_t version;
+  uint32_t record_size;
+  uint64_t record_count;  // filled in by Stop
+  uint64_t dropped;       // records lost because a ring buffer was full
+};
+
+/**
+ * Operation trace for offline replay. Each calling thread appends to its own lock-free
+ * single-producer ring, so recording never blocks the tree; when a ring is full the record is
+ * dropped and counted rather than waiting. A background thread drains the rings into the file.
+ * Records from different threads appear in the file in drain order; ReadTrace sorts them by
+ * timestamp. Calls that race with Stop may be missing from the trace.
+ */
+class TraceRecorder {
+ public:
+  static constexpr int kMaxThreads = 64;
+  static constexpr size_t kRingSize = 1 << 16;
+
+  TraceRecorder();
+  ~TraceRecorder();
+  TraceRecorder(const TraceRecorder &) = delete;
+  auto operator=(const TraceRecorder &) -> TraceRecorder & = delete;
+
+  // Returns false if a trace is already running or the file cannot be created
+  auto Start(const std::string &path) -> bool;
+  // Flushes everything recorded so far and closes the file
+  auto Stop() -> bool;
+  auto IsEnabled() const -> bool { return enabled_.load(std::memory_order_acquire); }
+
+  auto Record(TraceOp op, int64_t key, uint32_t arg = 0) -> void {
+    if (IsEnabled()) {
+      Append(op, key, arg);
+    }
+  }
+
+  // Reads a whole trace, sorted by timestamp (ties keep the per-thread order)
+  static auto ReadTrace(const std::string &path, TraceHeader *header,
+                        std::vector<TraceRecord> *records) -> bool;
+
+ private:
+  struct Ring {
+    alignas(64) std::atomic<uint64_t> head{0};  // 下一个待写出的位置，由写文件线程和 Start 修改
+    alignas(64) std::atomic<uint64_t> tail{0};  // 下一个写入的位置，只由所属线程修改
+    std::thread::id owner;
+    std::array<TraceRecord, kRingSize> records;
+  };
+
+  auto Append(TraceOp op, int64_t key, uint32_t arg) -> void;
+  auto LocalRing() -> std::pair<Ring *, uint16_t>;
+  auto Drain(std::vector<TraceRecord> *buffer) -> void;
+  auto FlushLoop() -> void;
+
+  const uint64_t id_;  // 区分不同的 recorder，用于线程本地缓存
+  std::atomic<bool> enabled_{false};
+  std::array<std::atomic<Ring *>, kMaxThreads> rings_{};
+  std::atomic<uint64_t> dropped_{0};
+  std::chrono::steady_clock::time_point start_;
+
+  std::mutex mutex_;  // 保护 Start/Stop 以及 stopping_
+  std::condition_variable wakeup_;
+  bool stopping_ = false;
+  std::thread flusher_;
+  FILE *file_ = nullptr;
+  uint64_t written_ = 0;
+};
+
+}  // namespace mybplus
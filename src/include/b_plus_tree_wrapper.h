@@ -27,13 +27,29 @@ void bpt_destroy(CBPlusTree* tree);
 // 插入和查找的C接口
 bool bpt_insert(CBPlusTree* tree, KeyType key, ValueType value);
 bool bpt_get_value(CBPlusTree* tree, KeyType key, ValueType* out_value);
+bool bpt_update(CBPlusTree* tree, KeyType key, ValueType value);
+void bpt_remove(CBPlusTree* tree, KeyType key);
+// 从 start_key 开始按序读取至多 max_count 个键值，返回读到的个数
+int bpt_scan(CBPlusTree* tree, KeyType start_key, int max_count, KeyType* keys,
+             ValueType* values);
+
+// 自底向上批量构建，键必须严格递增
+void bpt_bulk_load_begin(CBPlusTree* tree, uint64_t expected_entries, double fill_factor);
+bool bpt_bulk_load_append(CBPlusTree* tree, const KeyType* keys, const ValueType* values,
+                          int count);
+bool bpt_bulk_load_finish(CBPlusTree* tree);
+// 直接加载页面之后重新统计树的键数、页面数和高度
+void bpt_recount_stats(CBPlusTree* tree);
+// 直接加载页面之后把内部页面中的子页面 id 换成页面地址
+void bpt_swizzle_children(CBPlusTree* tree);
 
 page_id_t get_root_page_id(CBPlusTree* tree);
 uint32_t get_page_count(const CBPlusTree* tree);
 int get_leaf_max_size(const CBPlusTree* tree);
 int get_internal_max_size(const CBPlusTree* tree);
 CBPlusTreePage* get_page(CBPlusTree* tree, page_id_t page_id);
-void bpt_create_page_with_id(CBPlusTree* tree, page_id_t page_id, bool is_leaf);
+// 返回注册的页面；并行反序列化时使用返回值，不要再调用 get_page
+CBPlusTreePage* bpt_create_page_with_id(CBPlusTree* tree, page_id_t page_id, bool is_leaf);
 bool page_is_leaf(const CBPlusTreePage* page);
 int page_get_size(const CBPlusTreePage* page);
 page_id_t page_get_id(const CBPlusTreePage* page);
@@ -44,6 +60,10 @@ ValueType leaf_page_get_value_at(const CBPlusTreePage* page, int index);
 page_id_t leaf_page_get_next_id(const CBPlusTreePage* page);
 void leaf_page_set_kv_at(CBPlusTreePage* page, int index, KeyType key, ValueType value);
 void leaf_page_set_next_id(CBPlusTreePage* page, page_id_t next_page_id);
+// 按列批量读写叶子页面的键值，keys/values 至少容纳 page_get_size 个元素
+void leaf_page_get_columns(const CBPlusTreePage* page, KeyType* keys, ValueType* values);
+void leaf_page_set_columns(CBPlusTreePage* page, const KeyType* keys, const ValueType* values,
+                           int count);
 
 // 内部页面
 KeyType internal_page_get_key_at(const CBPlusTreePage* page, int index);
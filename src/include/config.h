@@ -9,9 +9,27 @@ namespace mybplus {
 
 #define PAGE_SIZE 4096
 #define INVALID_PAGE_ID -1
+// 内部页面（根除外）至少有两个子页面，page_id_t 为 32 位，树高不会超过 32
+#define MAX_TREE_HEIGHT 32
 #define DEBUG
+// 选择默认的并发控制方式（见 ConcurrencyMode），每棵树也可以在构造时单独指定
 #define USING_CRABBING_PROTOCOL
 
+/**
+ * How a BPlusTree synchronizes its operations. SINGLE_THREADED takes no locks at all and is only
+ * correct when one thread uses the tree at a time. GLOBAL_LOCK guards the whole tree with one
+ * reader/writer lock. CRABBING latches pages top-down and releases ancestors once a page is safe.
+ * OPTIMISTIC is CRABBING where Insert and Remove first descend with shared latches and an
+ * exclusive latch on the leaf only, falling back to CRABBING when the leaf must split or merge.
+ */
+enum class ConcurrencyMode { SINGLE_THREADED = 0, GLOBAL_LOCK, CRABBING, OPTIMISTIC };
+
+#ifdef USING_CRABBING_PROTOCOL
+#define DEFAULT_CONCURRENCY_MODE ConcurrencyMode::OPTIMISTIC
+#else
+#define DEFAULT_CONCURRENCY_MODE ConcurrencyMode::GLOBAL_LOCK
+#endif
+
 struct Comparator {
   inline auto operator()(const int64_t &lhs, const int64_t &rhs) const -> int {
     return (lhs < rhs) ? -1 : (lhs > rhs) ? 1 : 0;
@@ -5,8 +5,10 @@
 #include <cstdio>  // for std::remove
 #include <cstring>
 #include <fstream>  // for ifstream
+#include <optional>
 #include <random>
 #include <set>
+#include <thread>
 #include <vector>
 
 #include "b_plus_tree.h"
@@ -186,6 +188,124 @@ TEST_F(BPlusTreeComplexTest, SequentialPattern) {
   }
 }
 
+TEST_F(BPlusTreeComplexTest, RangeScan) {
+  const int NUM_ITEMS = 2000;
+  ValueType value{};
+  std::vector<std::pair<KeyType, ValueType>> entries;
+  EXPECT_EQ(tree->Scan(0, 10, &entries), 0);
+
+  // 只插入偶数键
+  for (int i = 0; i < NUM_ITEMS; ++i) {
+    tree->Insert(i * 2, value);
+  }
+  EXPECT_EQ(tree->Scan(101, 50, &entries), 50);
+  for (int i = 0; i < 50; ++i) {
+    EXPECT_EQ(entries[i].first, 102 + i * 2);
+  }
+  entries.clear();
+  EXPECT_EQ(tree->Scan(NUM_ITEMS * 2 - 10, 100, &entries), 5);
+  entries.clear();
+  EXPECT_EQ(tree->Scan(-1, NUM_ITEMS * 2, &entries), NUM_ITEMS);
+
+  // 扫描与插入奇数键并发进行，结果始终有序且包含所有偶数键
+  std::thread writer([&]() {
+    for (int i = 0; i < NUM_ITEMS; ++i) {
+      tree->Insert(i * 2 + 1, value);
+    }
+  });
+  for (int round = 0; round < 20; ++round) {
+    entries.clear();
+    tree->Scan(0, NUM_ITEMS * 2, &entries);
+    int evens = 0;
+    for (size_t i = 0; i < entries.size(); ++i) {
+      if (i > 0) {
+        ASSERT_LT(entries[i - 1].first, entries[i].first);
+      }
+      evens += entries[i].first % 2 == 0 ? 1 : 0;
+    }
+    EXPECT_EQ(evens, NUM_ITEMS);
+  }
+  writer.join();
+}
+
+TEST_F(BPlusTreeComplexTest, PointLookupOverloads) {
+  const int NUM_ITEMS = 500;
+  for (int i = 0; i < NUM_ITEMS; ++i) {
+    ValueType value{};
+    value[0] = static_cast<char>(i);
+    ASSERT_TRUE(tree->Insert(i * 2, value));
+  }
+  for (int i = 0; i < NUM_ITEMS * 2; ++i) {
+    ValueType value{};
+    value[1] = 'x';
+    std::optional<ValueType> optional = tree->GetValue(i);
+    if (i % 2 == 0) {
+      ASSERT_TRUE(tree->GetValue(i, &value));
+      EXPECT_EQ(value[0], static_cast<char>(i / 2));
+      ASSERT_TRUE(optional.has_value());
+      EXPECT_EQ(*optional, value);
+    } else {
+      // 找不到时不修改输出参数
+      EXPECT_FALSE(tree->GetValue(i, &value));
+      EXPECT_EQ(value[1], 'x');
+      EXPECT_FALSE(optional.has_value());
+    }
+  }
+}
+
+TEST_F(BPlusTreeComplexTest, UnswizzledChildren) {
+  const int NUM_ITEMS = 1000;
+  ValueType value{};
+  for (int i = 0; i < NUM_ITEMS; ++i) {
+    ASSERT_TRUE(tree->Insert(i, value));
+  }
+
+  // 子页面换回页面 id 后所有操作照常工作，只是每层多一次页表查找
+  tree->UnswizzleChildren();
+  std::vector<ValueType> result;
+  for (int i = 0; i < NUM_ITEMS; i += 7) {
+    result.clear();
+    EXPECT_TRUE(tree->GetValue(i, &result));
+  }
+  for (int i = 0; i < NUM_ITEMS; i += 2) {
+    tree->Remove(i);
+  }
+  for (int i = NUM_ITEMS; i < NUM_ITEMS * 2; ++i) {
+    ASSERT_TRUE(tree->Insert(i, value));
+  }
+
+  tree->SwizzleChildren();
+  std::vector<std::pair<KeyType, ValueType>> entries;
+  ASSERT_EQ(tree->Scan(0, NUM_ITEMS * 2, &entries), NUM_ITEMS / 2 + NUM_ITEMS);
+  for (size_t i = 1; i < entries.size(); ++i) {
+    EXPECT_LT(entries[i - 1].first, entries[i].first);
+  }
+  EXPECT_EQ(tree->GetStats(true).key_count, NUM_ITEMS / 2 + NUM_ITEMS);
+}
+
+TEST_F(BPlusTreeComplexTest, UpdateExistingKeys) {
+  ValueType value{};
+  EXPECT_FALSE(tree->Update(1, value));
+  for (int i = 0; i < 500; ++i) {
+    tree->Insert(i, value);
+  }
+  size_t pages = tree->GetPageCount();
+  for (int i = 0; i < 500; i += 2) {
+    std::string str = "updated_" + std::to_string(i);
+    std::strcpy(value.data(), str.c_str());
+    EXPECT_TRUE(tree->Update(i, value));
+  }
+  EXPECT_FALSE(tree->Update(500, value));
+  // 更新不改变树的结构
+  EXPECT_EQ(tree->GetPageCount(), pages);
+  for (int i = 0; i < 500; ++i) {
+    std::vector<ValueType> results;
+    ASSERT_TRUE(tree->GetValue(i, &results));
+    std::string expected = i % 2 == 0 ? "updated_" + std::to_string(i) : "";
+    EXPECT_STREQ(results[0].data(), expected.c_str());
+  }
+}
+
 TEST_F(BPlusTreeComplexTest, LongValueTest) {
   // 测试长值（接近最大长度）
   const int NUM_ITEMS = 100;
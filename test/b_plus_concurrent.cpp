@@ -1,6 +1,7 @@
 #include <gtest/gtest.h>
 
 #include <algorithm>
+#include <array>
 #include <atomic>
 #include <chrono>
 #include <cstdint>
@@ -16,6 +17,7 @@
 #include <vector>
 
 #include "b_plus_tree.h"
+#include "b_plus_tree_sharded.h"
 #include "config.h"
 
 namespace mybplus {
@@ -383,4 +385,680 @@ TEST_F(BPlusTreeConcurrentOrderTest, DISABLED_ConcurrentStressTest) {
   EXPECT_EQ(operation_errors.load(), 0)
       << "Found " << operation_errors.load() << " operation errors during stress test";
 }
+TEST(HybridLatchTest, SharedExclusiveAndOptimisticModes) {
+  HybridLatch latch;
+  // 写者在写锁内让两个计数不相等，读者任何时候都不应看到不相等
+  std::atomic<int64_t> first{0};
+  std::atomic<int64_t> second{0};
+  std::atomic<int64_t> torn_reads{0};
+  std::atomic<int64_t> validated_reads{0};
+  const int num_writers = 4;
+  const int num_readers = 4;
+  const int iterations = 20000;
+
+  LaunchThreads(num_writers + num_readers, [&](int id) {
+    for (int i = 0; i < iterations; i++) {
+      if (id < num_writers) {
+        latch.LockExclusive();
+        first.store(first.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        std::this_thread::yield();
+        second.store(second.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        latch.UnlockExclusive();
+      } else if (i % 2 == 0) {
+        latch.LockShared();
+        if (first.load(std::memory_order_relaxed) != second.load(std::memory_order_relaxed)) {
+          torn_reads++;
+        }
+        latch.UnlockShared();
+      } else {
+        uint32_t version;
+        if (!latch.OptimisticRead(&version)) {
+          continue;
+        }
+        int64_t a = first.load(std::memory_order_relaxed);
+        int64_t b = second.load(std::memory_order_relaxed);
+        if (latch.Validate(version)) {
+          validated_reads++;
+          if (a != b) {
+            torn_reads++;
+          }
+        }
+      }
+    }
+  });
+
+  EXPECT_EQ(first.load(), num_writers * iterations);
+  EXPECT_EQ(second.load(), num_writers * iterations);
+  EXPECT_EQ(torn_reads.load(), 0);
+  EXPECT_GT(validated_reads.load(), 0);
+
+  // 写锁与读锁互斥，解锁后版本号变化
+  uint32_t version;
+  ASSERT_TRUE(latch.OptimisticRead(&version));
+  ASSERT_TRUE(latch.TryLockShared());
+  EXPECT_FALSE(latch.TryLockExclusive());
+  EXPECT_TRUE(latch.Validate(version));
+  latch.UnlockShared();
+  ASSERT_TRUE(latch.TryLockExclusive());
+  EXPECT_FALSE(latch.TryLockShared());
+  EXPECT_FALSE(latch.Validate(version));
+  latch.UnlockExclusive();
+  EXPECT_FALSE(latch.Validate(version));
+}
+
+TEST(EpochManagerTest, RetiredObjectOutlivesRunningOperations) {
+  // 被回收的“对象”就是计数器本身，销毁时计数加一
+  std::atomic<int> destroyed{0};
+  auto destroy = [](void *counter) { static_cast<std::atomic<int> *>(counter)->fetch_add(1); };
+  EpochManager epochs;
+
+  std::atomic<bool> entered{false};
+  std::atomic<bool> leave{false};
+  std::thread reader([&] {
+    EpochGuard guard(epochs);
+    entered = true;
+    while (!leave) {
+      std::this_thread::yield();
+    }
+  });
+  while (!entered) {
+    std::this_thread::yield();
+  }
+
+  // 读者进入时对象尚未退休，读者退出前不能释放
+  epochs.Retire(&destroyed, destroy);
+  EXPECT_EQ(epochs.Reclaim(), 0);
+  EXPECT_EQ(epochs.PendingCount(), 1);
+  EXPECT_EQ(destroyed.load(), 0);
+  {
+    // 之后开始的操作不会阻止回收
+    EpochGuard later(epochs);
+    leave = true;
+    reader.join();
+    EXPECT_EQ(epochs.Reclaim(), 1);
+  }
+  EXPECT_EQ(destroyed.load(), 1);
+
+  // 攒够一批后 Retire 自行回收
+  for (size_t i = 0; i < EpochManager::kReclaimBatch; i++) {
+    epochs.Retire(&destroyed, destroy);
+  }
+  EXPECT_EQ(destroyed.load(), 1 + static_cast<int>(EpochManager::kReclaimBatch));
+  EXPECT_EQ(epochs.PendingCount(), 0);
+
+  // 未进入 epoch 的 guard 不影响回收，ReclaimAll 释放剩余对象
+  EpochGuard disabled(epochs, false);
+  epochs.Retire(&destroyed, destroy);
+  epochs.ReclaimAll();
+  EXPECT_EQ(destroyed.load(), 2 + static_cast<int>(EpochManager::kReclaimBatch));
+}
+
+TEST(ConcurrencyModeTest, EveryModeKeepsTheTreeConsistent) {
+  KeyComparator comparator;
+  const int num_threads = 4;
+  const int keys_per_thread = 5000;
+  for (auto mode : {ConcurrencyMode::SINGLE_THREADED, ConcurrencyMode::GLOBAL_LOCK,
+                    ConcurrencyMode::CRABBING, ConcurrencyMode::OPTIMISTIC}) {
+    SCOPED_TRACE(static_cast<int>(mode));
+    BPlusTree<KeyType, ValueType, KeyComparator> tree("mode_tree", comparator, 8, 8, mode);
+    EXPECT_EQ(tree.GetConcurrencyMode(), mode);
+    int threads = mode == ConcurrencyMode::SINGLE_THREADED ? 1 : num_threads;
+
+    // 每个线程插入自己的键，查找刚插入的键，再删除其中的奇数位置
+    LaunchThreads(threads, [&](int t) {
+      ValueType value{};
+      std::vector<ValueType> result;
+      for (int i = 0; i < keys_per_thread; i++) {
+        KeyType key = static_cast<KeyType>(i) * threads + t;
+        KeyToValue(key, value);
+        EXPECT_TRUE(tree.Insert(key, value));
+        result.clear();
+        EXPECT_TRUE(tree.GetValue(key, &result));
+      }
+      for (int i = 1; i < keys_per_thread; i += 2) {
+        tree.Remove(static_cast<KeyType>(i) * threads + t);
+      }
+    });
+
+    std::vector<std::pair<KeyType, ValueType>> entries;
+    size_t expected = static_cast<size_t>(threads) * keys_per_thread / 2;
+    ASSERT_EQ(tree.Scan(0, threads * keys_per_thread, &entries), expected);
+    for (size_t i = 0; i < entries.size(); i++) {
+      KeyType key = entries[i].first;
+      EXPECT_EQ(key / threads % 2, 0);
+      ValueType value{};
+      KeyToValue(key, value);
+      EXPECT_EQ(entries[i].second, value);
+      if (i > 0) {
+        EXPECT_LT(entries[i - 1].first, key);
+      }
+    }
+    EXPECT_EQ(tree.GetStats(true).key_count, expected);
+  }
+}
+
+TEST(AppendModeTest, AscendingKeysFillPagesAndSkipTheDescent) {
+  KeyComparator comparator;
+  const int num_keys = 20000;
+  BPlusTree<KeyType, ValueType, KeyComparator> plain("plain_tree", comparator, 16, 16);
+  BPlusTree<KeyType, ValueType, KeyComparator> append("append_tree", comparator, 16, 16);
+  append.EnableAppendMode();
+  append.EnableMetrics();
+  ValueType value{};
+  for (int i = 0; i < num_keys; i++) {
+    ASSERT_TRUE(plain.Insert(i, value));
+    ASSERT_TRUE(append.Insert(i, value));
+  }
+
+  // 50/50 分裂留下一半空的叶子，追加模式下除最右叶子外都是满的
+  TreeStats plain_stats = plain.GetStats(true);
+  TreeStats append_stats = append.GetStats(true);
+  EXPECT_LT(plain_stats.LeafFillFactor(16), 0.6);
+  EXPECT_GT(append_stats.LeafFillFactor(16), 0.99);
+  EXPECT_LT(append_stats.internal_pages, plain_stats.internal_pages);
+  MetricsSnapshot metrics = append.GetMetrics();
+  EXPECT_EQ(metrics.Counter(MetricCounter::APPEND_HIT) +
+                metrics.Counter(MetricCounter::LEAF_SPLIT) + 1,
+            num_keys);
+
+  // 键不递增时回到普通插入
+  for (int i = -1; i > -100; i--) {
+    ASSERT_TRUE(append.Insert(i, value));
+  }
+  EXPECT_FALSE(append.Insert(num_keys - 1, value));
+  std::vector<std::pair<KeyType, ValueType>> entries;
+  ASSERT_EQ(append.Scan(-100, num_keys * 2, &entries), num_keys + 99);
+}
+
+TEST(AppendModeTest, ConcurrentAppendsAndRemoves) {
+  KeyComparator comparator;
+  const int num_writers = 3;
+  const int keys_per_writer = 5000;
+  for (auto mode : {ConcurrencyMode::GLOBAL_LOCK, ConcurrencyMode::CRABBING,
+                    ConcurrencyMode::OPTIMISTIC}) {
+    SCOPED_TRACE(static_cast<int>(mode));
+    BPlusTree<KeyType, ValueType, KeyComparator> tree("append_tree", comparator, 8, 8, mode);
+    tree.EnableAppendMode();
+    std::array<std::atomic<int>, num_writers> inserted{};
+    const KeyType total = static_cast<KeyType>(num_writers) * keys_per_writer;
+
+    // 写线程 t 依次插入 i * num_writers + t，整体上键基本递增；删除线程删除已经插入的偶数键，
+    // 让最右叶子也参与借用与合并
+    LaunchThreads(num_writers + 1, [&](int t) {
+      ValueType value{};
+      if (t < num_writers) {
+        for (int i = 0; i < keys_per_writer; i++) {
+          KeyType key = static_cast<KeyType>(i) * num_writers + t;
+          KeyToValue(key, value);
+          EXPECT_TRUE(tree.Insert(key, value));
+          inserted[t].store(i + 1);
+        }
+        return;
+      }
+      for (KeyType key = 0; key < total; key += 2) {
+        while (inserted[key % num_writers].load() <= key / num_writers) {
+          std::this_thread::yield();
+        }
+        tree.Remove(key);
+      }
+    });
+
+    std::vector<std::pair<KeyType, ValueType>> entries;
+    tree.Scan(0, total, &entries);
+    ASSERT_EQ(entries.size(), static_cast<size_t>(total / 2));
+    for (size_t i = 0; i < entries.size(); i++) {
+      EXPECT_EQ(entries[i].first, static_cast<KeyType>(i) * 2 + 1);
+      ValueType value{};
+      KeyToValue(entries[i].first, value);
+      EXPECT_EQ(entries[i].second, value);
+    }
+    EXPECT_EQ(tree.GetStats(true).key_count, static_cast<uint64_t>(total / 2));
+  }
+}
+
+TEST(FingerCacheTest, ClusteredAccessSkipsTheDescent) {
+  KeyComparator comparator;
+  const int num_keys = 20000;
+  for (auto mode : {ConcurrencyMode::SINGLE_THREADED, ConcurrencyMode::GLOBAL_LOCK,
+                    ConcurrencyMode::CRABBING, ConcurrencyMode::OPTIMISTIC}) {
+    SCOPED_TRACE(static_cast<int>(mode));
+    BPlusTree<KeyType, ValueType, KeyComparator> tree("finger_tree", comparator, 64, 64, mode);
+    tree.EnableFingerCache();
+    tree.EnableMetrics();
+    ValueType value{};
+    for (int i = 0; i < num_keys; i++) {
+      KeyToValue(i, value);
+      ASSERT_TRUE(tree.Insert(i, value));
+    }
+    // 只有分裂的插入和分裂后的第一次插入需要从根下降
+    EXPECT_GT(tree.GetMetrics().Counter(MetricCounter::FINGER_HIT), num_keys * 9 / 10);
+
+    tree.ResetMetrics();
+    for (int i = 0; i < num_keys; i++) {
+      ValueType found{};
+      ASSERT_TRUE(tree.GetValue(i, &found));
+      KeyToValue(i, value);
+      ASSERT_EQ(found, value);
+    }
+    EXPECT_GT(tree.GetMetrics().Counter(MetricCounter::FINGER_HIT), num_keys * 9 / 10);
+
+    // 删除引起借用与合并之后，finger 不能再指向被释放或范围已经缩小的叶子
+    std::vector<KeyType> removed(num_keys / 2);
+    for (int i = 0; i < num_keys / 2; i++) {
+      removed[i] = i * 2;
+    }
+    std::shuffle(removed.begin(), removed.end(), std::mt19937(42));
+    for (KeyType key : removed) {
+      tree.Remove(key);
+      ValueType found{};
+      ASSERT_FALSE(tree.GetValue(key, &found));
+      ASSERT_TRUE(tree.GetValue(key + 1, &found));
+      KeyToValue(key + 1, value);
+      ASSERT_EQ(found, value);
+      ASSERT_FALSE(tree.Insert(key + 1, value));
+    }
+    for (int i = 0; i < num_keys; i++) {
+      ValueType found{};
+      ASSERT_EQ(tree.GetValue(i, &found), i % 2 == 1);
+    }
+    EXPECT_EQ(tree.GetStats(true).key_count, static_cast<uint64_t>(num_keys / 2));
+
+    tree.Clear();
+    ValueType found{};
+    EXPECT_FALSE(tree.GetValue(1, &found));
+  }
+}
+
+TEST(FingerCacheTest, ConcurrentClusteredWorkers) {
+  KeyComparator comparator;
+  const int num_threads = 4;
+  const int keys_per_thread = 6000;
+  for (auto mode : {ConcurrencyMode::GLOBAL_LOCK, ConcurrencyMode::CRABBING,
+                    ConcurrencyMode::OPTIMISTIC}) {
+    SCOPED_TRACE(static_cast<int>(mode));
+    BPlusTree<KeyType, ValueType, KeyComparator> tree("finger_tree", comparator, 8, 8, mode);
+    tree.EnableFingerCache();
+
+    // 每个线程在自己的区间内递增插入，并删除身后的键，叶子在线程之间不断分裂、借用与合并
+    LaunchThreads(num_threads, [&](int t) {
+      KeyType base = static_cast<KeyType>(t) * keys_per_thread;
+      ValueType value{};
+      ValueType found{};
+      for (KeyType i = 0; i < keys_per_thread; i++) {
+        KeyType key = base + i;
+        KeyToValue(key, value);
+        EXPECT_TRUE(tree.Insert(key, value));
+        EXPECT_TRUE(tree.GetValue(key, &found));
+        EXPECT_EQ(found, value);
+        if (i >= 2 && i % 3 == 0) {
+          tree.Remove(key - 2);
+          EXPECT_FALSE(tree.GetValue(key - 2, &found));
+        }
+      }
+    });
+
+    uint64_t expected = 0;
+    for (int t = 0; t < num_threads; t++) {
+      for (KeyType i = 0; i < keys_per_thread; i++) {
+        KeyType key = static_cast<KeyType>(t) * keys_per_thread + i;
+        bool present = !(i >= 1 && (i + 2) % 3 == 0 && i + 2 < keys_per_thread);
+        ValueType found{};
+        ASSERT_EQ(tree.GetValue(key, &found), present) << key;
+        expected += present ? 1 : 0;
+      }
+    }
+    EXPECT_EQ(tree.GetStats(true).key_count, expected);
+  }
+}
+
+TEST(HashIndexTest, HotKeysAreServedFromTheIndex) {
+  KeyComparator comparator;
+  const int num_keys = 10000;
+  const int hot_keys = 200;
+  for (auto mode : {ConcurrencyMode::SINGLE_THREADED, ConcurrencyMode::GLOBAL_LOCK,
+                    ConcurrencyMode::CRABBING, ConcurrencyMode::OPTIMISTIC}) {
+    SCOPED_TRACE(static_cast<int>(mode));
+    BPlusTree<KeyType, ValueType, KeyComparator> tree("hash_tree", comparator, 16, 16, mode);
+    // 叶子装到 3/4，下面单个键的删除与插入不会引起分裂或合并，条目所在的叶子一直有效
+    ValueType value{};
+    tree.BeginBulkLoad(num_keys, 0.75);
+    for (int i = 0; i < num_keys; i++) {
+      KeyToValue(i * 2, value);
+      ASSERT_TRUE(tree.BulkLoadAppend(i * 2, value));
+    }
+    ASSERT_TRUE(tree.FinishBulkLoad());
+    tree.EnableHashIndex(1000);
+    EXPECT_EQ(tree.GetHashIndexStats().capacity, 1024U);
+
+    // 热键分散在不同叶子里，多轮查找之后几乎都由哈希索引回答
+    auto check = [&](KeyType key, bool present, KeyType value_key) {
+      ValueType found{};
+      ASSERT_EQ(tree.GetValue(key, &found), present) << key;
+      if (present) {
+        ValueType expected{};
+        KeyToValue(value_key, expected);
+        ASSERT_EQ(found, expected) << key;
+      }
+    };
+    for (int round = 0; round < 50; round++) {
+      for (int i = 0; i < hot_keys; i++) {
+        check(i * 97 % num_keys * 2, true, i * 97 % num_keys * 2);
+      }
+    }
+    HashIndexStats stats = tree.GetHashIndexStats();
+    EXPECT_EQ(stats.lookups, 50U * hot_keys);
+    EXPECT_GT(stats.HitRate(), 0.7);
+
+    // 删除、更新与插入移动了叶子中的槽位，条目只会落空，不会返回过期的结果
+    for (int i = 0; i < hot_keys; i++) {
+      KeyType key = i * 97 % num_keys * 2;
+      if (i % 3 == 0) {
+        tree.Remove(key);
+      } else if (i % 3 == 1) {
+        KeyToValue(key + 1, value);
+        ASSERT_TRUE(tree.Update(key, value));
+      } else {
+        KeyToValue(key + 1, value);
+        ASSERT_TRUE(tree.Insert(key + 1, value));
+      }
+    }
+    for (int round = 0; round < 20; round++) {
+      for (int i = 0; i < hot_keys; i++) {
+        KeyType key = i * 97 % num_keys * 2;
+        check(key, i % 3 != 0, i % 3 == 1 ? key + 1 : key);
+      }
+    }
+
+    // 大量删除引起合并、释放叶子
+    for (int i = 0; i < num_keys; i += 2) {
+      tree.Remove(i * 2);
+    }
+    for (int i = 0; i < hot_keys; i++) {
+      KeyType key = i * 97 % num_keys * 2;
+      check(key, i % 3 != 0 && key % 4 != 0, i % 3 == 1 ? key + 1 : key);
+    }
+
+    tree.EnableHashIndex(0);
+    EXPECT_EQ(tree.GetHashIndexStats().capacity, 0U);
+    check(2, true, 2);
+  }
+}
+
+TEST(HashIndexTest, FreeingOtherLeavesKeepsEntries) {
+  KeyComparator comparator;
+  const int num_keys = 10000;
+  const int hot_keys = 100;
+  for (auto mode : {ConcurrencyMode::SINGLE_THREADED, ConcurrencyMode::GLOBAL_LOCK,
+                    ConcurrencyMode::CRABBING, ConcurrencyMode::OPTIMISTIC}) {
+    SCOPED_TRACE(static_cast<int>(mode));
+    BPlusTree<KeyType, ValueType, KeyComparator> tree("hash_tree", comparator, 16, 16, mode);
+    ValueType value{};
+    for (int i = 0; i < num_keys; i++) {
+      KeyToValue(i, value);
+      ASSERT_TRUE(tree.Insert(i, value));
+    }
+    tree.EnableHashIndex(1 << 14);
+
+    // 热键都在树的前半部分
+    ValueType found{};
+    for (int round = 0; round < 20; round++) {
+      for (int i = 0; i < hot_keys; i++) {
+        ASSERT_TRUE(tree.GetValue(i * 37, &found));
+      }
+    }
+
+    // 删除后半部分的键，合并释放了许多叶子，但热键所在的叶子都没有动
+    uint64_t leaf_pages = tree.GetStats(true).leaf_pages;
+    for (int i = num_keys / 2; i < num_keys; i++) {
+      tree.Remove(i);
+    }
+    ASSERT_LT(tree.GetStats(true).leaf_pages, leaf_pages);
+
+    // 释放其他叶子只让共用代数的少数条目失效，热键的第一轮查找几乎都命中
+    tree.ResetHashIndexStats();
+    for (int i = 0; i < hot_keys; i++) {
+      ASSERT_TRUE(tree.GetValue(i * 37, &found));
+      ValueType expected{};
+      KeyToValue(i * 37, expected);
+      ASSERT_EQ(found, expected);
+    }
+    EXPECT_GT(tree.GetHashIndexStats().hits, hot_keys * 3 / 4U);
+  }
+}
+
+TEST(HashIndexTest, ConcurrentReadersAndWriters) {
+  KeyComparator comparator;
+  const int num_keys = 4000;
+  const int num_readers = 3;
+  for (auto mode : {ConcurrencyMode::GLOBAL_LOCK, ConcurrencyMode::CRABBING,
+                    ConcurrencyMode::OPTIMISTIC}) {
+    SCOPED_TRACE(static_cast<int>(mode));
+    BPlusTree<KeyType, ValueType, KeyComparator> tree("hash_tree", comparator, 8, 8, mode);
+    tree.EnableHashIndex(256);
+    ValueType value{};
+    for (int i = 0; i < num_keys; i++) {
+      KeyToValue(i, value);
+      ASSERT_TRUE(tree.Insert(i, value));
+    }
+
+    // 写线程反复删除、重新插入与更新键，引起分裂与合并；读线程查找热键，
+    // 找到的值只能是插入或更新时写入的值之一
+    std::atomic<bool> done{false};
+    LaunchThreads(num_readers + 1, [&](int t) {
+      if (t == num_readers) {
+        std::mt19937 rng(7);
+        ValueType written{};
+        for (int round = 0; round < 4; round++) {
+          for (int i = 0; i < num_keys; i++) {
+            KeyType key = static_cast<KeyType>(rng() % num_keys);
+            tree.Remove(key);
+            KeyToValue(key + (i % 2) * num_keys, written);
+            tree.Insert(key, written);
+            if (i % 5 == 0) {
+              KeyToValue(key, written);
+              tree.Update(key, written);
+            }
+          }
+        }
+        done.store(true);
+        return;
+      }
+      ValueType found{};
+      ValueType original{};
+      ValueType updated{};
+      std::mt19937 rng(t);
+      while (!done.load()) {
+        KeyType key = static_cast<KeyType>(rng() % 64) * (num_keys / 64);
+        if (tree.GetValue(key, &found)) {
+          KeyToValue(key, original);
+          KeyToValue(key + num_keys, updated);
+          ASSERT_TRUE(found == original || found == updated) << key;
+        }
+      }
+    });
+
+    for (int i = 0; i < num_keys; i++) {
+      ValueType found{};
+      ASSERT_TRUE(tree.GetValue(i, &found)) << i;
+      ValueType original{};
+      ValueType updated{};
+      KeyToValue(i, original);
+      KeyToValue(i + num_keys, updated);
+      ASSERT_TRUE(found == original || found == updated) << i;
+    }
+    EXPECT_GT(tree.GetHashIndexStats().hits, 0U);
+  }
+}
+
+// 分片的范围首尾相接，各分片的键数之和等于总键数
+template <typename Tree>
+void CheckShardRanges(Tree *tree, uint64_t expected_keys) {
+  auto shards = tree->GetShards();
+  ASSERT_FALSE(shards.empty());
+  uint64_t total = 0;
+  for (size_t i = 0; i < shards.size(); i++) {
+    ASSERT_EQ(shards[i].has_high, i + 1 < shards.size()) << i;
+    if (i + 1 < shards.size()) {
+      ASSERT_EQ(shards[i].high, shards[i + 1].low) << i;
+    }
+    total += shards[i].key_count;
+  }
+  ASSERT_EQ(total, expected_keys);
+}
+
+TEST(ShardedTreeTest, RoutesAndScansAcrossShards) {
+  KeyComparator comparator;
+  ShardedBPlusTree<KeyType, ValueType, KeyComparator> tree("sharded_tree", comparator, 4,
+                                                          {1000, 2000, 3000}, 8, 8);
+  tree.SetAutoRebalance(false);
+  ValueType value{};
+  for (KeyType key = -500; key < 4000; key++) {
+    KeyToValue(key, value);
+    ASSERT_TRUE(tree.Insert(key, value));
+  }
+  ASSERT_FALSE(tree.Insert(1500, value));
+  auto shards = tree.GetShards();
+  ASSERT_EQ(shards.size(), 4U);
+  EXPECT_EQ(shards[0].key_count, 1500U);
+  EXPECT_EQ(shards[1].key_count, 1000U);
+  EXPECT_EQ(shards[3].key_count, 1000U);
+  CheckShardRanges(&tree, 4500);
+
+  for (KeyType key = 990; key < 4000; key += 1000) {
+    tree.Remove(key + 10);
+  }
+  // 扫描跨过分片边界，被删除的边界键不会出现
+  std::vector<std::pair<KeyType, ValueType>> result;
+  ASSERT_EQ(tree.Scan(990, 30, &result), 30U);
+  for (size_t i = 0; i < result.size(); i++) {
+    KeyType expected = 990 + static_cast<KeyType>(i) + (i >= 10 ? 1 : 0);
+    ASSERT_EQ(result[i].first, expected);
+    KeyToValue(expected, value);
+    ASSERT_EQ(result[i].second, value);
+  }
+  result.clear();
+  ASSERT_EQ(tree.Scan(-1000, SIZE_MAX, &result), 4497U);
+  ASSERT_TRUE(std::is_sorted(result.begin(), result.end(),
+                             [](const auto &a, const auto &b) { return a.first < b.first; }));
+
+  ValueType found{};
+  EXPECT_FALSE(tree.GetValue(2000, &found));
+  KeyToValue(-1, value);
+  ASSERT_TRUE(tree.Update(2001, value));
+  ASSERT_TRUE(tree.GetValue(2001, &found));
+  EXPECT_EQ(found, value);
+}
+
+TEST(ShardedTreeTest, GrowingTreeSplitsIntoShards) {
+  KeyComparator comparator;
+  const int num_keys = 60000;
+  auto largest_shard = [](auto *sharded) {
+    uint64_t largest = 0;
+    for (const auto &shard : sharded->GetShards()) {
+      largest = std::max(largest, shard.key_count);
+    }
+    return largest;
+  };
+  ValueType value{};
+  std::vector<KeyType> keys = GenerateRandomKeys(num_keys);
+  // 从一个分片开始随机插入，划分稳定后分片数正好是 num_shards
+  for (size_t shards : {2, 4, 8}) {
+    SCOPED_TRACE(shards);
+    ShardedBPlusTree<KeyType, ValueType, KeyComparator> tree("sharded_tree", comparator,
+                                                            static_cast<int>(shards));
+    ASSERT_EQ(tree.ShardCount(), 1U);
+    for (KeyType key : keys) {
+      KeyToValue(key, value);
+      ASSERT_TRUE(tree.Insert(key, value));
+    }
+    // 拆分在后台线程中进行，等它至少完成一次；关闭自动划分之后手动做完剩下的步骤
+    for (int i = 0; i < 5000 && tree.ShardCount() == 1; i++) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_GT(tree.ShardCount(), 1U);
+    tree.SetAutoRebalance(false);
+    while (tree.Rebalance()) {
+    }
+    EXPECT_EQ(tree.ShardCount(), shards);
+    EXPECT_LE(largest_shard(&tree) * shards, 2U * num_keys);
+    CheckShardRanges(&tree, num_keys);
+  }
+
+  const int num_shards = 4;
+  // 从 num_shards 个均匀的分片开始，关闭自动划分后把所有新键插入最后一个分片，
+  // 手动划分会拆分它并合并最小的相邻分片
+  ShardedBPlusTree<KeyType, ValueType, KeyComparator> manual(
+      "manual_tree", comparator, num_shards, {num_keys / 4, num_keys / 2, num_keys * 3 / 4});
+  manual.SetAutoRebalance(false);
+  for (int i = 0; i < 3 * num_keys; i++) {
+    KeyToValue(i, value);
+    ASSERT_TRUE(manual.Insert(i, value));
+  }
+  bool merged = false;
+  size_t shard_count = manual.ShardCount();
+  for (int step = 0; step < 32 && manual.Rebalance(); step++) {
+    merged |= manual.ShardCount() < shard_count;
+    shard_count = manual.ShardCount();
+    CheckShardRanges(&manual, 3 * num_keys);
+  }
+  EXPECT_TRUE(merged);
+  EXPECT_LE(largest_shard(&manual) * num_shards, 2U * 3 * num_keys);
+
+  ValueType found{};
+  for (int i = 0; i < 3 * num_keys; i++) {
+    ASSERT_TRUE(manual.GetValue(i, &found)) << i;
+    KeyToValue(i, value);
+    ASSERT_EQ(found, value) << i;
+  }
+}
+
+TEST(ShardedTreeTest, ConcurrentOperationsDuringRebalance) {
+  KeyComparator comparator;
+  const int num_writers = 4;
+  const int keys_per_writer = 20000;
+  for (auto mode : {ConcurrencyMode::GLOBAL_LOCK, ConcurrencyMode::OPTIMISTIC}) {
+    SCOPED_TRACE(static_cast<int>(mode));
+    ShardedBPlusTree<KeyType, ValueType, KeyComparator> tree("sharded_tree", comparator, 4, {},
+                                                            16, 16, mode);
+    // 写线程插入并删除各自的键；另一个线程不停地拆分、合并分片
+    std::atomic<int> writers_done{0};
+    LaunchThreads(num_writers + 1, [&](int t) {
+      if (t == num_writers) {
+        while (writers_done.load() < num_writers) {
+          tree.Rebalance();
+          std::this_thread::yield();
+        }
+        return;
+      }
+      ValueType value{};
+      ValueType found{};
+      for (int i = 0; i < keys_per_writer; i++) {
+        KeyType key = static_cast<KeyType>(i) * num_writers + t;
+        KeyToValue(key, value);
+        ASSERT_TRUE(tree.Insert(key, value)) << key;
+        ASSERT_TRUE(tree.GetValue(key, &found)) << key;
+        ASSERT_EQ(found, value) << key;
+        if (i % 3 == 0) {
+          tree.Remove(key);
+          ASSERT_FALSE(tree.GetValue(key, &found)) << key;
+        }
+      }
+      writers_done.fetch_add(1);
+    });
+
+    uint64_t expected = 0;
+    ValueType found{};
+    for (int i = 0; i < keys_per_writer; i++) {
+      for (int t = 0; t < num_writers; t++) {
+        KeyType key = static_cast<KeyType>(i) * num_writers + t;
+        ASSERT_EQ(tree.GetValue(key, &found), i % 3 != 0) << key;
+        expected += i % 3 != 0 ? 1 : 0;
+      }
+    }
+    CheckShardRanges(&tree, expected);
+    std::vector<std::pair<KeyType, ValueType>> result;
+    EXPECT_EQ(tree.Scan(0, SIZE_MAX, &result), expected);
+  }
+}
+
 }  // namespace mybplus
@@ -0,0 +1,267 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "b_plus_tree.h"
+#include "config.h"
+
+namespace mybplus {
+namespace test {
+
+TEST(HistogramTest, BucketBoundsCoverValues) {
+  for (uint64_t value : {0ULL, 1ULL, 31ULL, 32ULL, 33ULL, 1000ULL, 123456789ULL, 1ULL << 39}) {
+    int index = HistogramSnapshot::BucketIndex(value);
+    EXPECT_GE(HistogramSnapshot::BucketUpperBound(index), value);
+    if (index > 0) {
+      EXPECT_LT(HistogramSnapshot::BucketUpperBound(index - 1), value);
+    }
+    // 误差不超过 1/16
+    EXPECT_LE(HistogramSnapshot::BucketUpperBound(index) - value, value / 16);
+  }
+  EXPECT_EQ(HistogramSnapshot::BucketIndex(UINT64_MAX), HistogramSnapshot::kBucketCount - 1);
+}
+
+TEST(TreeMetricsTest, CountsOperationsAndStructureChanges) {
+  KeyComparator comparator;
+  BPlusTree<KeyType, ValueType, KeyComparator> tree("metrics_tree", comparator, 8, 8);
+
+  // 未开启时不记录
+  ValueType value{};
+  tree.Insert(0, value);
+  EXPECT_EQ(tree.GetMetrics().Latency(MetricOp::INSERT).count, 0);
+  tree.Remove(0);
+
+  tree.EnableMetrics();
+  const int NUM_THREADS = 4;
+  const int KEYS_PER_THREAD = 5000;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < NUM_THREADS; t++) {
+    threads.emplace_back([&, t]() {
+      ValueType v{};
+      std::vector<ValueType> result;
+      for (int i = 0; i < KEYS_PER_THREAD; i++) {
+        KeyType key = static_cast<KeyType>(i) * NUM_THREADS + t;
+        tree.Insert(key, v);
+        tree.GetValue(key, &result);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  for (int i = 0; i < NUM_THREADS * KEYS_PER_THREAD; i += 2) {
+    tree.Remove(i);
+  }
+
+  MetricsSnapshot snapshot = tree.GetMetrics();
+  const HistogramSnapshot &insert = snapshot.Latency(MetricOp::INSERT);
+  EXPECT_EQ(insert.count, NUM_THREADS * KEYS_PER_THREAD);
+  EXPECT_EQ(snapshot.Latency(MetricOp::GET).count, NUM_THREADS * KEYS_PER_THREAD);
+  EXPECT_EQ(snapshot.Latency(MetricOp::REMOVE).count, NUM_THREADS * KEYS_PER_THREAD / 2);
+  EXPECT_LE(insert.min, insert.Percentile(0.5));
+  EXPECT_LE(insert.Percentile(0.5), insert.Percentile(0.99));
+  EXPECT_LE(insert.Percentile(0.99), insert.Percentile(0.999));
+  EXPECT_LE(insert.Percentile(0.999), insert.max);
+
+  EXPECT_GT(snapshot.Counter(MetricCounter::LEAF_SPLIT), 0);
+  EXPECT_GT(snapshot.Counter(MetricCounter::INTERNAL_SPLIT), 0);
+  // 乐观下降遇到需要分裂的叶子时重新下降
+  EXPECT_GE(snapshot.Counter(MetricCounter::RESTART), snapshot.Counter(MetricCounter::LEAF_SPLIT));
+  EXPECT_GT(snapshot.Counter(MetricCounter::LEAF_MERGE) +
+                snapshot.Counter(MetricCounter::LEAF_BORROW),
+            0);
+  // 开启之后分配/释放的页面数与树中的页面数一致
+  EXPECT_EQ(snapshot.Counter(MetricCounter::PAGE_ALLOC) -
+                snapshot.Counter(MetricCounter::PAGE_FREE),
+            tree.GetPageCount());
+
+  std::string dump = snapshot.ToString();
+  EXPECT_NE(dump.find("p999"), std::string::npos);
+  EXPECT_NE(dump.find("leaf_splits"), std::string::npos);
+  std::cout << dump;
+
+  tree.ResetMetrics();
+  EXPECT_EQ(tree.GetMetrics().Latency(MetricOp::INSERT).count, 0);
+  EXPECT_EQ(tree.GetMetrics().Counter(MetricCounter::LEAF_SPLIT), 0);
+}
+
+TEST(LatchProfilerTest, ReportsWaitsPerLevelAndPage) {
+  KeyComparator comparator;
+  BPlusTree<KeyType, ValueType, KeyComparator> tree("latch_tree", comparator, 8, 8);
+  ValueType value{};
+  tree.Insert(0, value);
+  tree.EnableLatchProfiling();
+
+  // 所有线程都在同一段键上插入和删除，制造争用
+  const int NUM_THREADS = 8;
+  const int OPS_PER_THREAD = 5000;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < NUM_THREADS; t++) {
+    threads.emplace_back([&, t]() {
+      ValueType v{};
+      std::vector<ValueType> result;
+      for (int i = 1; i <= OPS_PER_THREAD; i++) {
+        KeyType key = static_cast<KeyType>(i) * NUM_THREADS + t;
+        tree.Insert(key, v);
+        tree.GetValue(key - NUM_THREADS, &result);
+        if (i % 3 == 0) {
+          tree.Remove(key - 2 * NUM_THREADS);
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  LatchProfileSnapshot profile = tree.GetLatchProfile(5);
+  // 插入和查找都读锁根互斥量，只有需要分裂或合并时才重新下降并写锁根互斥量
+  EXPECT_GE(profile.root[static_cast<int>(LatchMode::SHARED)].acquisitions,
+            2 * NUM_THREADS * OPS_PER_THREAD);
+  EXPECT_GT(profile.root[static_cast<int>(LatchMode::EXCLUSIVE)].acquisitions, 0);
+  EXPECT_LT(profile.root[static_cast<int>(LatchMode::EXCLUSIVE)].acquisitions,
+            NUM_THREADS * OPS_PER_THREAD);
+  ASSERT_GE(profile.levels.size(), 2);
+  EXPECT_GE(profile.levels[0][static_cast<int>(LatchMode::SHARED)].acquisitions,
+            NUM_THREADS * OPS_PER_THREAD);
+  EXPECT_LE(profile.top_pages.size(), 5);
+  for (size_t i = 1; i < profile.top_pages.size(); i++) {
+    EXPECT_GE(profile.top_pages[i - 1].wait_ns, profile.top_pages[i].wait_ns);
+  }
+  std::string report = profile.ToString();
+  EXPECT_NE(report.find("top contended pages"), std::string::npos);
+  std::cout << report;
+
+  tree.ResetLatchProfile();
+  EXPECT_EQ(tree.GetLatchProfile().root[0].acquisitions, 0);
+  EXPECT_TRUE(tree.GetLatchProfile().top_pages.empty());
+}
+
+TEST(TreeStatsTest, MaintainedCountersMatchFullScan) {
+  KeyComparator comparator;
+  BPlusTree<KeyType, ValueType, KeyComparator> tree("stats_tree", comparator, 16, 16);
+  EXPECT_EQ(tree.GetStats().height, 0);
+
+  const int NUM_ITEMS = 50000;
+  std::vector<KeyType> keys(NUM_ITEMS);
+  for (int i = 0; i < NUM_ITEMS; i++) {
+    keys[i] = i + 1;
+  }
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(7));
+  ValueType value{};
+  for (auto key : keys) {
+    tree.Insert(key, value);
+  }
+  for (int i = 0; i < NUM_ITEMS / 3; i++) {
+    tree.Remove(keys[i]);
+  }
+
+  TreeStats cheap = tree.GetStats();
+  TreeStats full = tree.GetStats(true);
+  EXPECT_FALSE(cheap.full_scan);
+  ASSERT_TRUE(full.full_scan);
+  EXPECT_EQ(cheap.key_count, NUM_ITEMS - NUM_ITEMS / 3);
+  EXPECT_EQ(full.key_count, cheap.key_count);
+  EXPECT_EQ(full.leaf_pages, cheap.leaf_pages);
+  EXPECT_EQ(full.internal_pages, cheap.internal_pages);
+  EXPECT_EQ(full.height, cheap.height);
+  EXPECT_EQ(full.leaf_pages + full.internal_pages, tree.GetPageCount());
+
+  ASSERT_EQ(full.pages_per_level.size(), static_cast<size_t>(full.height));
+  EXPECT_EQ(full.pages_per_level.front(), 1);
+  EXPECT_EQ(full.pages_per_level.back(), full.leaf_pages);
+  uint64_t leaf_fill_total = 0;
+  for (auto pages : full.leaf_fill) {
+    leaf_fill_total += pages;
+  }
+  EXPECT_EQ(leaf_fill_total, full.leaf_pages);
+  EXPECT_GT(full.bytes_used, 0);
+  EXPECT_LE(full.bytes_used, full.bytes_allocated);
+  // 页面数组大小固定，插入不会让 vector 增长
+  EXPECT_EQ(full.bytes_excess_capacity, 0);
+  EXPECT_GT(cheap.LeafFillFactor(tree.GetLeafMaxSize()), 0.4);
+  std::cout << full.ToString();
+
+  // 批量构建同样维护计数
+  tree.BeginBulkLoad(1000);
+  for (int i = 0; i < 1000; i++) {
+    tree.BulkLoadAppend(i, value);
+  }
+  tree.FinishBulkLoad();
+  TreeStats loaded = tree.GetStats();
+  EXPECT_EQ(loaded.key_count, 1000);
+  EXPECT_EQ(loaded.height, tree.GetStats(true).height);
+  EXPECT_EQ(loaded.leaf_pages + loaded.internal_pages, tree.GetPageCount());
+}
+
+TEST(TraceRecorderTest, RecordsEveryCallInPerThreadOrder) {
+  KeyComparator comparator;
+  BPlusTree<KeyType, ValueType, KeyComparator> tree("trace_tree", comparator, 8, 8);
+  const std::string path = "trace_test.bin";
+  ASSERT_TRUE(tree.StartTrace(path));
+  EXPECT_FALSE(tree.StartTrace(path));
+
+  const int NUM_THREADS = 4;
+  const int KEYS_PER_THREAD = 2000;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < NUM_THREADS; t++) {
+    threads.emplace_back([&, t]() {
+      ValueType v{};
+      std::vector<ValueType> result;
+      std::vector<std::pair<KeyType, ValueType>> entries;
+      for (int i = 0; i < KEYS_PER_THREAD; i++) {
+        KeyType key = static_cast<KeyType>(i) * NUM_THREADS + t;
+        tree.Insert(key, v);
+        tree.GetValue(key, &result);
+        tree.Update(key, v);
+        tree.Scan(key, 10, &entries);
+        tree.Remove(key);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  ASSERT_TRUE(tree.StopTrace());
+  // 停止之后不再记录
+  ValueType value{};
+  tree.Insert(-1, value);
+
+  TraceHeader header;
+  std::vector<TraceRecord> records;
+  ASSERT_TRUE(TraceRecorder::ReadTrace(path, &header, &records));
+  EXPECT_EQ(header.dropped, 0);
+  ASSERT_EQ(records.size(), NUM_THREADS * KEYS_PER_THREAD * 5);
+  for (size_t i = 1; i < records.size(); i++) {
+    EXPECT_LE(records[i - 1].timestamp_ns, records[i].timestamp_ns);
+  }
+
+  // 每个线程的调用按原来的顺序出现
+  const TraceOp expected_ops[] = {TraceOp::INSERT, TraceOp::GET, TraceOp::UPDATE, TraceOp::SCAN,
+                                  TraceOp::REMOVE};
+  std::map<uint16_t, std::vector<TraceRecord>> by_thread;
+  for (const auto &record : records) {
+    by_thread[record.thread].push_back(record);
+  }
+  ASSERT_EQ(by_thread.size(), NUM_THREADS);
+  for (const auto &entry : by_thread) {
+    const auto &calls = entry.second;
+    ASSERT_EQ(calls.size(), KEYS_PER_THREAD * 5);
+    KeyType first = calls[0].key;
+    for (size_t i = 0; i < calls.size(); i++) {
+      EXPECT_EQ(calls[i].op, static_cast<uint8_t>(expected_ops[i % 5]));
+      EXPECT_EQ(calls[i].key, first + static_cast<KeyType>(i / 5) * NUM_THREADS);
+      EXPECT_EQ(calls[i].arg, calls[i].op == static_cast<uint8_t>(TraceOp::SCAN) ? 10 : 0);
+    }
+  }
+  std::remove(path.c_str());
+}
+
+}  // namespace test
+}  // namespace mybplus
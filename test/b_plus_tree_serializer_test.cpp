@@ -6,6 +6,7 @@
 #include <cstdio>
 #include <cstring>
 #include <fstream>
+#include <iterator>
 #include <memory>
 #include <random>
 #include <string>
@@ -15,6 +16,8 @@
 #include "config.h"
 
 extern "C" {
+#include "b_plus_tree_crc32c.h"
+#include "b_plus_tree_lz.h"
 #include "b_plus_tree_serializer.h"
 #include "b_plus_tree_wrapper.h"
 }
@@ -114,5 +117,480 @@ TEST_F(BPlusTreeCSerializationTest, SerializationAndDeserializationCorrectness)
   std::remove(serialize_path.c_str());
 }
 
+TEST_F(BPlusTreeCSerializationTest, EncodedLeafFormatRoundTrip) {
+  tree = std::make_unique<BPlusTree<KeyType, ValueType, KeyComparator>>("test_tree", comparator,
+                                                                        128, 128);
+
+  const int NUM_ITEMS = 200000;
+  std::vector<KeyType> keys;
+  GenerateUniqueKeys(NUM_ITEMS, keys);
+  for (const auto& key : keys) {
+    ValueType value;
+    KeyToValue(key, value);
+    ASSERT_TRUE(tree->Insert(key, value));
+  }
+
+  CBPlusTree* tree_handle = reinterpret_cast<CBPlusTree*>(tree.get());
+  std::string raw_path = std::to_string(getpid()) + "_raw.bin";
+  std::string encoded_path = std::to_string(getpid()) + "_encoded.bin";
+
+  BPlusTreeSerializer* raw_serializer = serializer_create(tree_handle, raw_path.c_str());
+  EXPECT_TRUE(serializer_serialize(raw_serializer));
+  serializer_destroy(raw_serializer);
+
+  BPlusTreeSerializer* serializer = serializer_create(tree_handle, encoded_path.c_str());
+  serializer_set_flags(serializer, SERIALIZER_FLAG_ENCODED);
+  EXPECT_TRUE(serializer_serialize(serializer));
+  serializer_destroy(serializer);
+
+  std::ifstream raw_file(raw_path, std::ios::binary | std::ios::ate);
+  std::ifstream encoded_file(encoded_path, std::ios::binary | std::ios::ate);
+  auto raw_size = static_cast<size_t>(raw_file.tellg());
+  auto encoded_size = static_cast<size_t>(encoded_file.tellg());
+  std::cout << "Raw size: " << raw_size << " bytes, encoded size: " << encoded_size << " bytes"
+            << std::endl;
+  EXPECT_LT(encoded_size, raw_size);
+
+  BPlusTree<KeyType, ValueType, KeyComparator> new_tree("deserialized_tree", comparator, 3, 3);
+  BPlusTreeSerializer* deserializer =
+      serializer_create(reinterpret_cast<CBPlusTree*>(&new_tree), encoded_path.c_str());
+  EXPECT_TRUE(serializer_deserialize(deserializer));
+  serializer_destroy(deserializer);
+
+  EXPECT_EQ(new_tree.GetPageCount(), tree->GetPageCount());
+  EXPECT_EQ(new_tree.GetRootPageId(), tree->GetRootPageId());
+  for (const auto& key : keys) {
+    std::vector<ValueType> results;
+    ASSERT_TRUE(new_tree.GetValue(key, &results));
+    std::string expected = "value_" + std::to_string(key);
+    EXPECT_STREQ(results[0].data(), expected.c_str());
+  }
+
+  std::remove(raw_path.c_str());
+  std::remove(encoded_path.c_str());
+}
+
+// 各种快照格式都能还原出同样的树，压缩格式的文件比未压缩的小；吞吐量见 bench/snapshot_bplustree
+TEST_F(BPlusTreeCSerializationTest, EveryFormatRoundTrips) {
+  tree = std::make_unique<BPlusTree<KeyType, ValueType, KeyComparator>>("test_tree", comparator,
+                                                                        128, 128);
+
+  const int NUM_ITEMS = 100000;
+  std::vector<KeyType> keys;
+  GenerateUniqueKeys(NUM_ITEMS, keys);
+  for (const auto& key : keys) {
+    ValueType value;
+    KeyToValue(key, value);
+    ASSERT_TRUE(tree->Insert(key, value));
+  }
+  CBPlusTree* tree_handle = reinterpret_cast<CBPlusTree*>(tree.get());
+
+  struct Mode {
+    const char* name;
+    uint32_t flags;
+  };
+  std::vector<Mode> modes = {{"raw", 0},
+                             {"encoded", SERIALIZER_FLAG_ENCODED},
+                             {"compressed", SERIALIZER_FLAG_COMPRESSED},
+                             {"encoded+compressed",
+                              SERIALIZER_FLAG_ENCODED | SERIALIZER_FLAG_COMPRESSED},
+                             {"segmented", SERIALIZER_FLAG_SEGMENTED},
+                             {"segmented+encoded+compressed",
+                              SERIALIZER_FLAG_SEGMENTED | SERIALIZER_FLAG_ENCODED |
+                                  SERIALIZER_FLAG_COMPRESSED}};
+
+  size_t raw_size = 0;
+  for (const auto& mode : modes) {
+    SCOPED_TRACE(mode.name);
+    std::string path = std::to_string(getpid()) + "_" + mode.name + ".bin";
+
+    BPlusTreeSerializer* serializer = serializer_create(tree_handle, path.c_str());
+    serializer_set_flags(serializer, mode.flags);
+    ASSERT_TRUE(serializer_serialize(serializer));
+    serializer_destroy(serializer);
+
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    auto size = static_cast<size_t>(file.tellg());
+    file.close();
+    if (mode.flags == 0) {
+      raw_size = size;
+    }
+
+    BPlusTree<KeyType, ValueType, KeyComparator> new_tree("deserialized_tree", comparator, 3, 3);
+    BPlusTreeSerializer* deserializer =
+        serializer_create(reinterpret_cast<CBPlusTree*>(&new_tree), path.c_str());
+    ASSERT_TRUE(serializer_deserialize(deserializer));
+    serializer_destroy(deserializer);
+
+    EXPECT_EQ(new_tree.GetPageCount(), tree->GetPageCount());
+    for (int i = 0; i < NUM_ITEMS; i += 97) {
+      std::vector<ValueType> results;
+      ASSERT_TRUE(new_tree.GetValue(keys[i], &results));
+      std::string expected = "value_" + std::to_string(keys[i]);
+      EXPECT_STREQ(results[0].data(), expected.c_str());
+    }
+    if (mode.flags & SERIALIZER_FLAG_COMPRESSED) {
+      EXPECT_LT(size, raw_size);
+    }
+    std::remove(path.c_str());
+  }
+}
+
+TEST_F(BPlusTreeCSerializationTest, SegmentedParallelRoundTrip) {
+  tree = std::make_unique<BPlusTree<KeyType, ValueType, KeyComparator>>("test_tree", comparator,
+                                                                        16, 16);
+
+  const int NUM_ITEMS = 100000;
+  std::vector<KeyType> keys;
+  GenerateUniqueKeys(NUM_ITEMS, keys);
+  for (const auto& key : keys) {
+    ValueType value;
+    KeyToValue(key, value);
+    ASSERT_TRUE(tree->Insert(key, value));
+  }
+
+  std::string path = std::to_string(getpid()) + "_segmented.bin";
+  BPlusTreeSerializer* serializer =
+      serializer_create(reinterpret_cast<CBPlusTree*>(tree.get()), path.c_str());
+  serializer_set_flags(serializer, SERIALIZER_FLAG_SEGMENTED | SERIALIZER_FLAG_ENCODED);
+  serializer_set_threads(serializer, 4);
+  ASSERT_TRUE(serializer_serialize(serializer));
+  serializer_destroy(serializer);
+
+  BPlusTree<KeyType, ValueType, KeyComparator> new_tree("deserialized_tree", comparator, 3, 3);
+  BPlusTreeSerializer* deserializer =
+      serializer_create(reinterpret_cast<CBPlusTree*>(&new_tree), path.c_str());
+  serializer_set_threads(deserializer, 4);
+  ASSERT_TRUE(serializer_deserialize(deserializer));
+  serializer_destroy(deserializer);
+
+  EXPECT_EQ(new_tree.GetPageCount(), tree->GetPageCount());
+  EXPECT_EQ(new_tree.GetRootPageId(), tree->GetRootPageId());
+  EXPECT_EQ(new_tree.GetStats().key_count, NUM_ITEMS);
+  EXPECT_EQ(new_tree.GetStats().height, tree->GetStats().height);
+  for (const auto& key : keys) {
+    std::vector<ValueType> results;
+    ASSERT_TRUE(new_tree.GetValue(key, &results));
+    std::string expected = "value_" + std::to_string(key);
+    EXPECT_STREQ(results[0].data(), expected.c_str());
+  }
+
+  // 新树可以继续插入，页面 id 不会与已加载的页面冲突
+  ValueType value;
+  KeyToValue(NUM_ITEMS * 20, value);
+  EXPECT_TRUE(new_tree.Insert(NUM_ITEMS * 20, value));
+  std::remove(path.c_str());
+}
+
+// 不加页面锁的模式下，并行读入的线程注册页面时也不能与页表查找竞争（TSan 下可检测）
+TEST_F(BPlusTreeCSerializationTest, SegmentedRestoreInNonLatchingModes) {
+  tree = std::make_unique<BPlusTree<KeyType, ValueType, KeyComparator>>("test_tree", comparator,
+                                                                        8, 8);
+  const int NUM_ITEMS = 50000;
+  std::vector<KeyType> keys;
+  GenerateUniqueKeys(NUM_ITEMS, keys);
+  for (const auto& key : keys) {
+    ValueType value;
+    KeyToValue(key, value);
+    ASSERT_TRUE(tree->Insert(key, value));
+  }
+  std::string path = std::to_string(getpid()) + "_segmented_modes.bin";
+  BPlusTreeSerializer* serializer =
+      serializer_create(reinterpret_cast<CBPlusTree*>(tree.get()), path.c_str());
+  serializer_set_flags(serializer, SERIALIZER_FLAG_SEGMENTED);
+  serializer_set_threads(serializer, 8);
+  ASSERT_TRUE(serializer_serialize(serializer));
+  serializer_destroy(serializer);
+
+  for (auto mode : {ConcurrencyMode::SINGLE_THREADED, ConcurrencyMode::GLOBAL_LOCK}) {
+    SCOPED_TRACE(static_cast<int>(mode));
+    BPlusTree<KeyType, ValueType, KeyComparator> new_tree("deserialized_tree", comparator, 3, 3,
+                                                          mode);
+    BPlusTreeSerializer* deserializer =
+        serializer_create(reinterpret_cast<CBPlusTree*>(&new_tree), path.c_str());
+    serializer_set_threads(deserializer, 8);
+    ASSERT_TRUE(serializer_deserialize(deserializer));
+    serializer_destroy(deserializer);
+
+    EXPECT_EQ(new_tree.GetPageCount(), tree->GetPageCount());
+    EXPECT_EQ(new_tree.GetStats().key_count, NUM_ITEMS);
+    for (const auto& key : keys) {
+      std::vector<ValueType> results;
+      ASSERT_TRUE(new_tree.GetValue(key, &results)) << key;
+      std::string expected = "value_" + std::to_string(key);
+      EXPECT_STREQ(results[0].data(), expected.c_str());
+    }
+  }
+  std::remove(path.c_str());
+}
+
+TEST_F(BPlusTreeCSerializationTest, LeafStreamRestoreCompactsTree) {
+  tree = std::make_unique<BPlusTree<KeyType, ValueType, KeyComparator>>("test_tree", comparator,
+                                                                        32, 32);
+
+  const int NUM_ITEMS = 100000;
+  std::vector<KeyType> keys;
+  GenerateUniqueKeys(NUM_ITEMS, keys);
+  for (const auto& key : keys) {
+    ValueType value;
+    KeyToValue(key, value);
+    ASSERT_TRUE(tree->Insert(key, value));
+  }
+  // 删除一半以上的键，留下大量半空的页面
+  std::vector<KeyType> kept(keys.begin() + NUM_ITEMS * 6 / 10, keys.end());
+  for (int i = 0; i < NUM_ITEMS * 6 / 10; i++) {
+    tree->Remove(keys[i]);
+  }
+
+  std::string path = std::to_string(getpid()) + "_leaf_stream.bin";
+  BPlusTreeSerializer* serializer =
+      serializer_create(reinterpret_cast<CBPlusTree*>(tree.get()), path.c_str());
+  serializer_set_flags(serializer, SERIALIZER_FLAG_LEAF_STREAM | SERIALIZER_FLAG_ENCODED |
+                                       SERIALIZER_FLAG_COMPRESSED);
+  ASSERT_TRUE(serializer_serialize(serializer));
+  serializer_destroy(serializer);
+
+  BPlusTree<KeyType, ValueType, KeyComparator> new_tree("deserialized_tree", comparator, 3, 3);
+  BPlusTreeSerializer* deserializer =
+      serializer_create(reinterpret_cast<CBPlusTree*>(&new_tree), path.c_str());
+  serializer_set_fill_factor(deserializer, 1.0);
+  ASSERT_TRUE(serializer_deserialize(deserializer));
+  serializer_destroy(deserializer);
+
+  std::cout << "Pages before restore: " << tree->GetPageCount()
+            << ", after restore: " << new_tree.GetPageCount() << std::endl;
+  EXPECT_LT(new_tree.GetPageCount(), tree->GetPageCount());
+  EXPECT_EQ(new_tree.GetLeafMaxSize(), tree->GetLeafMaxSize());
+
+  for (const auto& key : kept) {
+    std::vector<ValueType> results;
+    ASSERT_TRUE(new_tree.GetValue(key, &results));
+    std::string expected = "value_" + std::to_string(key);
+    EXPECT_STREQ(results[0].data(), expected.c_str());
+  }
+  for (int i = 0; i < NUM_ITEMS * 6 / 10; i += 13) {
+    std::vector<ValueType> results;
+    EXPECT_FALSE(new_tree.GetValue(keys[i], &results));
+  }
+
+  // 重建后的树可以继续正常插入和删除
+  for (int i = 0; i < NUM_ITEMS * 6 / 10; i += 2) {
+    ValueType value;
+    KeyToValue(keys[i], value);
+    ASSERT_TRUE(new_tree.Insert(keys[i], value));
+  }
+  for (const auto& key : kept) {
+    new_tree.Remove(key);
+  }
+  for (int i = 0; i < NUM_ITEMS * 6 / 10; i++) {
+    std::vector<ValueType> results;
+    EXPECT_EQ(new_tree.GetValue(keys[i], &results), i % 2 == 0);
+  }
+  std::remove(path.c_str());
+}
+
+// 每层的页面数不超过 元素数 / 最小大小，均匀分布时即没有低于最小大小的页面
+void ExpectNoUnderfullPages(BPlusTree<KeyType, ValueType, KeyComparator>* tree) {
+  TreeStats stats = tree->GetStats(true);
+  const auto& levels = stats.pages_per_level;
+  ASSERT_FALSE(levels.empty());
+  uint64_t leaf_min = tree->GetLeafMaxSize() / 2;
+  EXPECT_TRUE(levels.back() == 1 || levels.back() * leaf_min <= stats.key_count)
+      << levels.back() << " leaves for " << stats.key_count << " keys";
+  for (size_t i = 1; i + 1 < levels.size(); i++) {
+    EXPECT_LE(levels[i] * (tree->GetInternalMaxSize() / 2), levels[i + 1]) << "level " << i;
+  }
+}
+
+TEST_F(BPlusTreeCSerializationTest, LeafStreamRestoreClampsFillFactor) {
+  tree = std::make_unique<BPlusTree<KeyType, ValueType, KeyComparator>>("test_tree", comparator,
+                                                                        32, 32);
+  const int NUM_ITEMS = 20000;
+  std::vector<KeyType> keys;
+  GenerateUniqueKeys(NUM_ITEMS, keys);
+  for (const auto& key : keys) {
+    ValueType value;
+    KeyToValue(key, value);
+    ASSERT_TRUE(tree->Insert(key, value));
+  }
+  std::string path = std::to_string(getpid()) + "_fill_factor.bin";
+  BPlusTreeSerializer* serializer =
+      serializer_create(reinterpret_cast<CBPlusTree*>(tree.get()), path.c_str());
+  serializer_set_flags(serializer, SERIALIZER_FLAG_LEAF_STREAM);
+  ASSERT_TRUE(serializer_serialize(serializer));
+  serializer_destroy(serializer);
+
+  // 过低的填充率被提高到 SERIALIZER_MIN_FILL_FACTOR
+  for (double fill_factor : {0.0, 0.1, 0.5, 0.75}) {
+    SCOPED_TRACE(fill_factor);
+    BPlusTree<KeyType, ValueType, KeyComparator> new_tree("deserialized_tree", comparator, 32,
+                                                          32);
+    BPlusTreeSerializer* deserializer =
+        serializer_create(reinterpret_cast<CBPlusTree*>(&new_tree), path.c_str());
+    serializer_set_fill_factor(deserializer, fill_factor);
+    ASSERT_TRUE(serializer_deserialize(deserializer));
+    serializer_destroy(deserializer);
+    ASSERT_EQ(new_tree.GetStats().key_count, static_cast<uint64_t>(NUM_ITEMS));
+    ExpectNoUnderfullPages(&new_tree);
+  }
+  std::remove(path.c_str());
+
+  // 元素很少时也不会分出低于最小大小的页面
+  ValueType value{};
+  for (int count = 1; count <= 300; count++) {
+    SCOPED_TRACE(count);
+    BPlusTree<KeyType, ValueType, KeyComparator> small_tree("small_tree", comparator, 8, 8);
+    small_tree.BeginBulkLoad(count, 0.5);
+    for (int i = 0; i < count; i++) {
+      ASSERT_TRUE(small_tree.BulkLoadAppend(i, value));
+    }
+    ASSERT_TRUE(small_tree.FinishBulkLoad());
+    ExpectNoUnderfullPages(&small_tree);
+  }
+}
+
+TEST(Crc32cTest, MatchesReferenceValues) {
+  const char* check = "123456789";
+  EXPECT_EQ(crc32c_extend(0, check, 9), 0xE3069283u);
+  EXPECT_EQ(crc32c_extend_portable(0, check, 9), 0xE3069283u);
+
+  // 分段计算与一次计算结果相同，硬件实现与软件实现结果相同
+  std::vector<uint8_t> data(4099);
+  std::mt19937 gen(42);
+  for (auto& b : data) {
+    b = static_cast<uint8_t>(gen());
+  }
+  for (size_t len : {0, 1, 7, 8, 15, 64, 1000, 4099}) {
+    for (size_t offset : {0, 1, 3}) {
+      size_t n = std::min(len, data.size() - offset);
+      uint32_t whole = crc32c_extend(0, data.data() + offset, n);
+      EXPECT_EQ(whole, crc32c_extend_portable(0, data.data() + offset, n));
+      uint32_t split = crc32c_extend(0, data.data() + offset, n / 3);
+      split = crc32c_extend(split, data.data() + offset + n / 3, n - n / 3);
+      EXPECT_EQ(whole, split);
+    }
+  }
+  std::cout << "CRC32C hardware accelerated: " << crc32c_is_hardware_accelerated() << std::endl;
+}
+
+// 解压时 dst 与输入都按实际长度分配，越界读写会被 ASan 发现
+int LzDecompress(const std::vector<uint8_t>& src, int dst_capacity, std::vector<uint8_t>* dst) {
+  std::vector<uint8_t> input(src);
+  dst->assign(dst_capacity, 0);
+  return lz_decompress(input.data(), static_cast<int>(input.size()), dst->data(), dst_capacity);
+}
+
+TEST(LzTest, RoundTripsAndRejectsTruncatedInput) {
+  // 重复片段与随机字节交替，既有匹配也有长字面量
+  std::vector<uint8_t> data;
+  std::mt19937 gen(7);
+  for (int block = 0; block < 64; block++) {
+    for (int i = 0; i < 300; i++) {
+      data.push_back(block % 2 == 0 ? static_cast<uint8_t>("abcdefgh"[i % 8])
+                                    : static_cast<uint8_t>(gen()));
+    }
+  }
+  int size = static_cast<int>(data.size());
+  std::vector<uint8_t> compressed(lz_compress_bound(size));
+  int compressed_size = lz_compress(data.data(), size, compressed.data(),
+                                    static_cast<int>(compressed.size()));
+  ASSERT_GT(compressed_size, 0);
+  ASSERT_LT(compressed_size, size);
+  compressed.resize(compressed_size);
+
+  std::vector<uint8_t> output;
+  ASSERT_EQ(LzDecompress(compressed, size, &output), size);
+  EXPECT_EQ(output, data);
+  // 输出空间差一个字节
+  EXPECT_EQ(LzDecompress(compressed, size - 1, &output), -1);
+  // 任何截断的输入都不能还原出完整的数据
+  for (int n = 0; n < compressed_size; n++) {
+    std::vector<uint8_t> prefix(compressed.begin(), compressed.begin() + n);
+    EXPECT_NE(LzDecompress(prefix, size, &output), size) << n;
+  }
+}
+
+TEST(LzTest, RejectsCorruptSequences) {
+  std::vector<uint8_t> output;
+  // 只有字面量的合法输入，以及偏移为 1 的重叠匹配
+  EXPECT_EQ(LzDecompress({0x30, 'a', 'b', 'c'}, 16, &output), 3);
+  ASSERT_EQ(LzDecompress({0x12, 'a', 0x01, 0x00, 0x00}, 16, &output), 7);
+  EXPECT_EQ(std::string(output.begin(), output.begin() + 7), "aaaaaaa");
+
+  // 字面量长度超过剩余输入
+  EXPECT_EQ(LzDecompress({0xF0, 255, 255, 10, 'a', 'b'}, 1024, &output), -1);
+  // 长度扩展字节被截断
+  EXPECT_EQ(LzDecompress({0xF0, 255}, 1024, &output), -1);
+  EXPECT_EQ(LzDecompress({0x1F, 'a', 0x01, 0x00}, 1024, &output), -1);
+  // 偏移缺少一个字节、偏移为 0、偏移指向输出开头之前
+  EXPECT_EQ(LzDecompress({0x10, 'a', 0x01}, 16, &output), -1);
+  EXPECT_EQ(LzDecompress({0x10, 'a', 0x00, 0x00}, 16, &output), -1);
+  EXPECT_EQ(LzDecompress({0x10, 'a', 0x02, 0x00}, 16, &output), -1);
+  // 字面量或匹配写出 dst 之外
+  EXPECT_EQ(LzDecompress({0x50, 'a', 'b', 'c', 'd', 'e'}, 4, &output), -1);
+  EXPECT_EQ(LzDecompress({0x1F, 'a', 0x01, 0x00, 100}, 64, &output), -1);
+  EXPECT_EQ(LzDecompress({0x1F, 'a', 0x01, 0x00, 100}, 120, &output), 120);
+
+  // 扩展字节累加超出 int 范围
+  std::vector<uint8_t> overflow(9 << 20, 255);
+  overflow[0] = 0xF0;
+  EXPECT_EQ(LzDecompress(overflow, 1024, &output), -1);
+}
+
+TEST_F(BPlusTreeCSerializationTest, ChecksumDetectsCorruptedPage) {
+  tree = std::make_unique<BPlusTree<KeyType, ValueType, KeyComparator>>("test_tree", comparator,
+                                                                        16, 16);
+  const int NUM_ITEMS = 20000;
+  std::vector<KeyType> keys;
+  GenerateUniqueKeys(NUM_ITEMS, keys);
+  for (const auto& key : keys) {
+    ValueType value;
+    KeyToValue(key, value);
+    ASSERT_TRUE(tree->Insert(key, value));
+  }
+
+  std::string path = std::to_string(getpid()) + "_checksum.bin";
+  for (uint32_t flags : {0u, SERIALIZER_FLAG_ENCODED | SERIALIZER_FLAG_SEGMENTED,
+                         SERIALIZER_FLAG_LEAF_STREAM}) {
+    flags |= SERIALIZER_FLAG_CHECKSUM;
+    BPlusTreeSerializer* serializer =
+        serializer_create(reinterpret_cast<CBPlusTree*>(tree.get()), path.c_str());
+    serializer_set_flags(serializer, flags);
+    ASSERT_TRUE(serializer_serialize(serializer));
+    EXPECT_TRUE(serializer_verify(serializer));
+    serializer_destroy(serializer);
+
+    // 改动某个值中的一个字节，文件结构仍然合法，只有校验和能发现
+    std::string content;
+    {
+      std::ifstream in(path, std::ios::binary);
+      content.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    std::string needle = "value_" + std::to_string(keys[NUM_ITEMS / 2]);
+    size_t pos = content.find(needle + '\0');
+    ASSERT_NE(pos, std::string::npos);
+    content[pos + 1] ^= 0x20;
+    {
+      std::ofstream out(path, std::ios::binary | std::ios::trunc);
+      out.write(content.data(), content.size());
+    }
+
+    BPlusTree<KeyType, ValueType, KeyComparator> new_tree("deserialized_tree", comparator, 3, 3);
+    BPlusTreeSerializer* deserializer =
+        serializer_create(reinterpret_cast<CBPlusTree*>(&new_tree), path.c_str());
+    EXPECT_FALSE(serializer_verify(deserializer));
+    EXPECT_FALSE(serializer_deserialize(deserializer));
+
+    // 关闭校验后按可信文件加载
+    serializer_set_verify(deserializer, false);
+    EXPECT_TRUE(serializer_deserialize(deserializer));
+    serializer_destroy(deserializer);
+    std::vector<ValueType> results;
+    ASSERT_TRUE(new_tree.GetValue(keys[NUM_ITEMS / 2], &results));
+    EXPECT_STRNE(results[0].data(), needle.c_str());
+  }
+  std::remove(path.c_str());
+}
+
 }  // namespace test
 }  // namespace mybplus